@@ -0,0 +1,141 @@
+#ifndef AUTOMATION_H_INCLUDED
+#define AUTOMATION_H_INCLUDED
+
+#include <algorithm>
+
+/**
+    Parameter automation applied to the processor between blocks, the way a
+    host without sample accurate automation sets parameters.
+
+    A script has one point per line: the time in seconds, the parameter by
+    index or by name, and its normalized value. Blank lines and lines starting
+    with # are ignored:
+
+    @code
+    # seconds  parameter     value
+    0.0        oversampling  0
+    1.5        oversampling  1
+    2.0        0             0.25
+    @endcode
+
+    Parameters whose names contain spaces are given by index.
+
+    Each point is applied with AudioProcessorParameter::setValue() before the
+    first block that starts at or after its time, so the same script always
+    produces the same output.
+ */
+class Automation {
+public:
+    /// A value a parameter is set to at a time.
+    struct Point {
+        double seconds;
+        int parameterIndex;
+        float value;
+    };
+
+    /// Reads a script, resolving parameter names against processor. Returns
+    /// false with a description of the first bad line in error if it cannot.
+    bool parse(const String& script, const AudioProcessor& processor, String& error)
+    {
+        points.clear();
+
+        const StringArray lines(StringArray::fromLines(script));
+        for (int line = 0; line < lines.size(); ++line) {
+            const String text(lines[line].trim());
+            if (text.isEmpty() || text.startsWithChar('#')) {
+                continue;
+            }
+
+            StringArray fields(StringArray::fromTokens(text, " \t", String()));
+            fields.removeEmptyStrings();
+
+            Point point;
+            point.parameterIndex = fields.size() == 3 ? findParameter(processor, fields[1]) : -1;
+
+            if (point.parameterIndex < 0) {
+                error = "line " + String(line + 1) + ": expected a time, a parameter and a value";
+                return false;
+            }
+
+            point.seconds = fields[0].getDoubleValue();
+            point.value = jlimit(0.f, 1.f, fields[2].getFloatValue());
+            points.add(point);
+        }
+
+        sort();
+        return true;
+    }
+
+    /// Creates a script that steps every parameter through its range in ten
+    /// steps over the given seconds, each parameter offset from the previous
+    /// one, so parameters change alone and together.
+    void createSweep(const AudioProcessor& processor, double seconds)
+    {
+        points.clear();
+
+        const int numParameters = processor.getParameters().size();
+        const int numSteps = 10;
+
+        for (int index = 0; index < numParameters; ++index) {
+            for (int step = 0; step <= numSteps; ++step) {
+                Point point;
+                point.parameterIndex = index;
+                point.seconds = seconds * (step + (double) index / numParameters) / (numSteps + 1);
+                point.value = (float) step / numSteps;
+                points.add(point);
+            }
+        }
+
+        sort();
+    }
+
+    /// Returns true if there are no points.
+    bool isEmpty() const
+    {
+        return points.isEmpty();
+    }
+
+    /// Sets the parameters of every point from nextPoint up to the given time,
+    /// and moves nextPoint past them. Start with nextPoint at 0.
+    void apply(AudioProcessor& processor, double seconds, int& nextPoint) const
+    {
+        for (; nextPoint < points.size() && points.getReference(nextPoint).seconds <= seconds; ++nextPoint) {
+            const Point& point = points.getReference(nextPoint);
+
+            if (AudioProcessorParameter* parameter = processor.getParameters()[point.parameterIndex]) {
+                parameter->setValue(point.value);
+            }
+        }
+    }
+
+private:
+    /// Returns the index of the parameter with the given index or name, or -1.
+    static int findParameter(const AudioProcessor& processor, const String& name)
+    {
+        const int numParameters = processor.getParameters().size();
+
+        if (name.containsOnly("0123456789")) {
+            const int index = name.getIntValue();
+            return index < numParameters ? index : -1;
+        }
+
+        for (int index = 0; index < numParameters; ++index) {
+            if (processor.getParameters()[index]->getName(100).equalsIgnoreCase(name)) {
+                return index;
+            }
+        }
+        return -1;
+    }
+
+    /// Orders the points by time, keeping the order of points at the same time.
+    void sort()
+    {
+        std::stable_sort(points.begin(), points.end(),
+                         [] (const Point& a, const Point& b) { return a.seconds < b.seconds; });
+    }
+
+    Array<Point> points;
+};
+
+
+#endif  // AUTOMATION_H_INCLUDED
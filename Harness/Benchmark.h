@@ -0,0 +1,175 @@
+#ifndef BENCHMARK_H_INCLUDED
+#define BENCHMARK_H_INCLUDED
+
+#include <algorithm>
+
+#include "TestSignals.h"
+#include "Automation.h"
+
+/// Creates the plugin, defined in PluginProcessor.cpp.
+AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+/**
+    Times processBlock() of a fresh processor instance without a host.
+
+    Each run creates the processor with createPluginFilter(), prepares it like a
+    host would and feeds it a test signal block by block. Only the processBlock()
+    calls are timed, copying the signal in and out is not. A few blocks are
+    processed before timing starts, so first-use costs such as lazily detected
+    instruction sets do not distort the results.
+
+    Runs in double precision set the processor's processing precision before
+    preparing it and pass it double buffers, like a host with a 64-bit mix bus.
+    Runs with automation set parameters between the timed blocks.
+ */
+class Benchmark {
+public:
+    /// The configuration of a single run.
+    struct Case {
+        TestSignals::Type signal;
+        double sampleRate;
+        int blockSize;
+        int numChannels;
+        AudioProcessor::ProcessingPrecision precision;
+
+        /// The parameter changes during the run, or nullptr for none.
+        const Automation* automation;
+    };
+
+    /// The timings of a single run.
+    struct Result {
+        Case config;
+
+        /// The number of blocks timed.
+        int numBlocks;
+
+        /// The mean processing time per sample of one channel in nanoseconds.
+        double nanosecondsPerSample;
+
+        /// The median, 99th percentile and longest block time in microseconds.
+        double medianMicroseconds;
+        double p99Microseconds;
+        double maximumMicroseconds;
+
+        /// The duration of the audio divided by the time taken to process it.
+        /// Values above 1 are faster than real time.
+        double realtimeFactor;
+    };
+
+    /// The number of blocks processed before timing starts.
+    static const int warmUpBlocks = 8;
+
+    /// Returns true if the plugin processes double buffers itself.
+    static bool supportsDoublePrecision()
+    {
+        ScopedPointer<AudioProcessor> processor(createPluginFilter());
+        return processor->supportsDoublePrecisionProcessing();
+    }
+
+    /// Processes about seconds of the case's signal and returns the timings. If
+    /// render is not nullptr it is resized to and filled with the processed
+    /// output, converted to float. If state is not nullptr it is replaced with
+    /// the state of the processor at the end of the run.
+    static Result run(const Case& config, double seconds, AudioSampleBuffer* render = nullptr,
+                      MemoryBlock* state = nullptr)
+    {
+        return config.precision == AudioProcessor::doublePrecision ? run<double>(config, seconds, render, state)
+                                                                   : run<float>(config, seconds, render, state);
+    }
+
+private:
+    template <typename FloatType>
+    static Result run(const Case& config, double seconds, AudioSampleBuffer* render, MemoryBlock* state)
+    {
+        const int blockSize = jmax(1, config.blockSize);
+        const int numChannels = jmax(1, config.numChannels);
+        const int numBlocks = jmax(1, roundToInt(seconds * config.sampleRate / blockSize));
+        const int numSamples = numBlocks * blockSize;
+
+        AudioSampleBuffer signal(numChannels, numSamples);
+        TestSignals::generate(config.signal, signal, config.sampleRate);
+
+        AudioBuffer<FloatType> source;
+        source.makeCopyOf(signal);
+
+        if (render != nullptr) {
+            render->setSize(numChannels, numSamples);
+        }
+
+        ScopedPointer<AudioProcessor> processor(createPluginFilter());
+        processor->setPlayConfigDetails(numChannels, numChannels, config.sampleRate, blockSize);
+        processor->setProcessingPrecision(config.precision);
+        processor->prepareToPlay(config.sampleRate, blockSize);
+
+        AudioBuffer<FloatType> block(numChannels, blockSize);
+        MidiBuffer midi;
+
+        for (int i = 0; i < warmUpBlocks; ++i) {
+            block.clear();
+            midi.clear();
+            processor->processBlock(block, midi);
+        }
+
+        HeapBlock<double> times((size_t) numBlocks);
+        const double secondsPerTick = 1.0 / (double) Time::getHighResolutionTicksPerSecond();
+        double totalSeconds = 0.0;
+        int nextPoint = 0;
+
+        for (int b = 0; b < numBlocks; ++b) {
+            if (config.automation != nullptr) {
+                config.automation->apply(*processor, b * blockSize / config.sampleRate, nextPoint);
+            }
+
+            for (int channel = 0; channel < numChannels; ++channel) {
+                block.copyFrom(channel, 0, source, channel, b * blockSize, blockSize);
+            }
+            midi.clear();
+
+            const int64 start = Time::getHighResolutionTicks();
+            processor->processBlock(block, midi);
+            const int64 end = Time::getHighResolutionTicks();
+
+            times[b] = (double) (end - start) * secondsPerTick;
+            totalSeconds += times[b];
+
+            if (render != nullptr) {
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    const FloatType* const samples = block.getReadPointer(channel);
+                    float* const output = render->getWritePointer(channel, b * blockSize);
+
+                    for (int i = 0; i < blockSize; ++i) {
+                        output[i] = (float) samples[i];
+                    }
+                }
+            }
+        }
+
+        processor->releaseResources();
+
+        if (state != nullptr) {
+            processor->getStateInformation(*state);
+        }
+
+        std::sort(times.getData(), times.getData() + numBlocks);
+
+        Result result;
+        result.config = config;
+        result.numBlocks = numBlocks;
+        result.nanosecondsPerSample = totalSeconds * 1.0e9 / ((double) numSamples * numChannels);
+        result.medianMicroseconds = percentile(times, numBlocks, 0.5) * 1.0e6;
+        result.p99Microseconds = percentile(times, numBlocks, 0.99) * 1.0e6;
+        result.maximumMicroseconds = times[numBlocks - 1] * 1.0e6;
+        result.realtimeFactor = totalSeconds > 0.0 ? numSamples / config.sampleRate / totalSeconds : 0.0;
+        return result;
+    }
+
+    /// Returns the nearest-rank percentile of sorted values.
+    static double percentile(const double* sorted, int numValues, double fraction)
+    {
+        const int rank = (int) std::ceil(fraction * numValues);
+        return sorted[jlimit(0, numValues - 1, rank - 1)];
+    }
+};
+
+
+#endif  // BENCHMARK_H_INCLUDED
@@ -0,0 +1,131 @@
+#ifndef CONVOLUTIONBENCHMARK_H_INCLUDED
+#define CONVOLUTIONBENCHMARK_H_INCLUDED
+
+#include <cmath>
+#include <ctime>
+
+#include "../Source/Convolver.h"
+
+/**
+    Times a Convolver with a stereo impulse response of several seconds at the
+    host block sizes it is most sensitive to, with the levels after the first
+    computed on the audio thread and on the background thread.
+
+    Each run convolves noise in blocks of one size and reports the CPU used per
+    channel as a percentage of real time: on the audio thread alone, i.e. the
+    time spent in process(), and in total including the background thread. It
+    also reports the longest block, which the largest levels dominate when they
+    run on the audio thread, and the blocks the background thread was late
+    for.
+ */
+class ConvolutionBenchmark {
+public:
+    /// The timings of one block size with or without the background thread.
+    struct Result {
+        int blockSize;
+        bool backgroundThread;
+        double audioThreadPercent;
+        double totalPercent;
+        double maximumMicroseconds;
+        int lateBlocks;
+    };
+
+    /// The host block sizes timed.
+    static const int numBlockSizes = 3;
+
+    /// The number of runs, each block size with and without the thread.
+    static const int numCases = 2 * numBlockSizes;
+
+    static const int numChannels = 2;
+
+    /// Runs every case over the given seconds of audio, with an impulse
+    /// response of impulseSeconds, and writes their timings to results.
+    static void run(double seconds, double impulseSeconds, Result (&results)[numCases])
+    {
+        const double sampleRate = 48000.0;
+        const int blockSizes[numBlockSizes] = { 32, 64, 512 };
+        const int impulseLength = jmax(1, (int) (impulseSeconds * sampleRate));
+        const int numSamples = jmax(1, (int) (seconds * sampleRate));
+
+        // A decaying noise tail, like the late reverberation of a hall
+        Random random(1);
+        AudioSampleBuffer impulseResponse(numChannels, impulseLength);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float* const samples = impulseResponse.getWritePointer(channel);
+            for (int i = 0; i < impulseLength; ++i) {
+                samples[i] = (random.nextFloat() * 2.f - 1.f) * std::exp(-6.9f * (float) i / (float) impulseLength);
+            }
+        }
+
+        AudioSampleBuffer input(numChannels, numSamples);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float* const samples = input.getWritePointer(channel);
+            for (int i = 0; i < numSamples; ++i) {
+                samples[i] = (random.nextFloat() * 2.f - 1.f) * 0.25f;
+            }
+        }
+
+        AudioSampleBuffer buffer(numChannels, numSamples);
+
+        for (int i = 0; i < numCases; ++i) {
+            Result& result = results[i];
+            result.blockSize = blockSizes[i / 2];
+            result.backgroundThread = (i & 1) != 0;
+
+            Convolver convolver;
+            convolver.loadImpulseResponse(impulseResponse);
+            convolver.prepare(numChannels, impulseLength, result.backgroundThread);
+
+            for (int channel = 0; channel < numChannels; ++channel) {
+                buffer.copyFrom(channel, 0, input, channel, 0, numSamples);
+            }
+
+            time(convolver, buffer, numSamples / sampleRate, result);
+            result.lateBlocks = convolver.getNumLateBlocks();
+        }
+    }
+
+private:
+    /// Processes buffer, audioSeconds long, in blocks of result.blockSize
+    /// samples and sets the timings of result.
+    static void time(Convolver& convolver, AudioSampleBuffer& buffer, double audioSeconds, Result& result)
+    {
+        const int blockSize = result.blockSize;
+        const int numSamples = buffer.getNumSamples();
+        const double secondsPerTick = 1.0 / (double) Time::getHighResolutionTicksPerSecond();
+        float* channels[numChannels];
+
+        int64 audioThreadTicks = 0;
+        int64 longestTicks = 0;
+
+        // The processor time of every thread of the process on POSIX systems
+        const std::clock_t startClock = std::clock();
+
+        for (int start = 0; start < numSamples; start += blockSize) {
+            const int count = jmin(blockSize, numSamples - start);
+            for (int channel = 0; channel < numChannels; ++channel) {
+                channels[channel] = buffer.getWritePointer(channel, start);
+            }
+
+            const int64 begin = Time::getHighResolutionTicks();
+            convolver.process(channels, numChannels, count);
+            const int64 ticks = Time::getHighResolutionTicks() - begin;
+
+            audioThreadTicks += ticks;
+            longestTicks = jmax(longestTicks, ticks);
+        }
+
+        // Stopping the thread waits for its last block, so it is counted too
+        convolver.release();
+
+        const double totalSeconds = (double) (std::clock() - startClock) / CLOCKS_PER_SEC;
+        const double percentPerSecond = 100.0 / (audioSeconds * numChannels);
+
+        result.audioThreadPercent = audioThreadTicks * secondsPerTick * percentPerSecond;
+        result.totalPercent = totalSeconds * percentPerSecond;
+        result.maximumMicroseconds = longestTicks * secondsPerTick * 1.0e6;
+    }
+};
+
+
+#endif  // CONVOLUTIONBENCHMARK_H_INCLUDED
@@ -0,0 +1,169 @@
+#ifndef DECIBELBENCHMARK_H_INCLUDED
+#define DECIBELBENCHMARK_H_INCLUDED
+
+#include <cmath>
+
+#include "../Source/DecibelConversion.h"
+
+/**
+    Times the conversions between uV and dB: the dB() and uV() macros the
+    template used before, which evaluated log10 and pow in double precision,
+    against the inline float functions and the block kernels of every
+    instruction set the machine supports.
+
+    Every case converts the same sweep of values, gains from -120 dB to +100 dB
+    for uV -> dB and decibels from -100 dB to +100 dB for dB -> uV. The largest
+    error against the double precision result is reported alongside, in dB for
+    uV -> dB and relative for dB -> uV.
+ */
+class DecibelBenchmark {
+public:
+    /// The timing and error of a single case.
+    struct Result {
+        const char* conversion;
+        const char* method;
+        double nanosecondsPerValue;
+        double maximumError;
+    };
+
+    /// The largest number of cases run, two for each of the macros, the inline
+    /// functions and the three instruction sets.
+    static const int maximumCases = 10;
+
+    /// Runs every case over numConversions values, writes their timings to
+    /// results and returns the number of cases.
+    static int run(int numConversions, Result (&results)[maximumCases])
+    {
+        const int numValues = 4096;
+        const int numPasses = jmax(1, numConversions / numValues);
+
+        HeapBlock<float> gains((size_t) numValues);
+        HeapBlock<float> decibels((size_t) numValues);
+        HeapBlock<float> converted((size_t) numValues);
+        for (int i = 0; i < numValues; ++i) {
+            const double position = (double) i / (numValues - 1);
+            gains[i] = (float) std::pow(10.0, (-120.0 + 220.0 * position) / 20.0);
+            decibels[i] = (float) (-100.0 + 200.0 * position);
+        }
+
+        int numKernels;
+        const DecibelConversion::Kernels* const kernels = DecibelConversion::getSupportedKernels(numKernels);
+
+        int numResults = 0;
+
+        {
+            Result& result = results[numResults++];
+            result.conversion = "uV -> dB";
+            result.method = "macro";
+            result.nanosecondsPerValue = time(convertEach<macroDecibels>, gains, converted, numValues, numPasses);
+            result.maximumError = getDecibelsError(gains, converted, numValues);
+        }
+
+        {
+            Result& result = results[numResults++];
+            result.conversion = "uV -> dB";
+            result.method = "inline";
+            result.nanosecondsPerValue = time(convertEach<inlineDecibels>, gains, converted, numValues, numPasses);
+            result.maximumError = getDecibelsError(gains, converted, numValues);
+        }
+
+        for (int k = 0; k < numKernels; ++k) {
+            Result& result = results[numResults++];
+            result.conversion = "uV -> dB";
+            result.method = kernels[k].name;
+            result.nanosecondsPerValue = time(kernels[k].toDecibels, gains, converted, numValues, numPasses);
+            result.maximumError = getDecibelsError(gains, converted, numValues);
+        }
+
+        {
+            Result& result = results[numResults++];
+            result.conversion = "dB -> uV";
+            result.method = "macro";
+            result.nanosecondsPerValue = time(convertEach<macroGain>, decibels, converted, numValues, numPasses);
+            result.maximumError = getGainError(decibels, converted, numValues);
+        }
+
+        {
+            Result& result = results[numResults++];
+            result.conversion = "dB -> uV";
+            result.method = "inline";
+            result.nanosecondsPerValue = time(convertEach<inlineGain>, decibels, converted, numValues, numPasses);
+            result.maximumError = getGainError(decibels, converted, numValues);
+        }
+
+        for (int k = 0; k < numKernels; ++k) {
+            Result& result = results[numResults++];
+            result.conversion = "dB -> uV";
+            result.method = kernels[k].name;
+            result.nanosecondsPerValue = time(kernels[k].toGain, decibels, converted, numValues, numPasses);
+            result.maximumError = getGainError(decibels, converted, numValues);
+        }
+
+        return numResults;
+    }
+
+private:
+    /// The expansions of the old macros, assigned to a float like the
+    /// processors did.
+    static float macroDecibels(float x) { return (float) (20.0 * ((x) > 0.00001 ? std::log10(x) : -5.0)); }
+    static float macroGain(float x) { return (float) std::pow(10.0, (x) / 20.0); }
+
+    static float inlineDecibels(float x) { return dB(x); }
+    static float inlineGain(float x) { return uV(x); }
+
+    /// Converts a block with a function of one value, which is inlined into the
+    /// loop, so it is timed the same way as the kernels.
+    template <float (*Convert)(float)>
+    static void convertEach(const float* source, float* destination, int numValues)
+    {
+        for (int i = 0; i < numValues; ++i) {
+            destination[i] = Convert(source[i]);
+        }
+    }
+
+    /// Returns the mean time of a conversion in nanoseconds.
+    template <typename Function>
+    static double time(const Function& convert, const float* source, float* destination,
+                       int numValues, int numPasses)
+    {
+        const int64 start = Time::getHighResolutionTicks();
+
+        for (int pass = 0; pass < numPasses; ++pass) {
+            convert(source, destination, numValues);
+        }
+
+        const double seconds = (double) (Time::getHighResolutionTicks() - start)
+                             / (double) Time::getHighResolutionTicksPerSecond();
+
+        // Keeps the loops from being optimized away
+        volatile float sink = destination[numValues / 2];
+        (void) sink;
+
+        return seconds * 1.0e9 / ((double) numPasses * numValues);
+    }
+
+    /// Returns the largest absolute error in dB of converted gains.
+    static double getDecibelsError(const float* gains, const float* converted, int numValues)
+    {
+        double error = 0.0;
+        for (int i = 0; i < numValues; ++i) {
+            const double exact = dB((double) gains[i]);
+            error = jmax(error, std::abs(converted[i] - exact));
+        }
+        return error;
+    }
+
+    /// Returns the largest relative error of converted decibels.
+    static double getGainError(const float* decibels, const float* converted, int numValues)
+    {
+        double error = 0.0;
+        for (int i = 0; i < numValues; ++i) {
+            const double exact = uV((double) decibels[i]);
+            error = jmax(error, std::abs(converted[i] - exact) / exact);
+        }
+        return error;
+    }
+};
+
+
+#endif  // DECIBELBENCHMARK_H_INCLUDED
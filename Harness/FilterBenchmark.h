@@ -0,0 +1,179 @@
+#ifndef FILTERBENCHMARK_H_INCLUDED
+#define FILTERBENCHMARK_H_INCLUDED
+
+#include "../Source/FilterBank.h"
+
+/**
+    Times a FilterBank against filtering each channel with its own scalar
+    biquad cascade, the way filters were written before, for stereo, 8 and 16
+    channels with 1 to 8 cascaded lowpass stages.
+
+    Every case filters the same noise in host blocks of 256 samples and reports
+    the time per sample of each channel: the scalar cascade, the bank with
+    biquads and the bank with state variable filters.
+ */
+class FilterBenchmark {
+public:
+    /// The timings of one configuration in nanoseconds per sample and channel.
+    struct Result {
+        int numChannels;
+        int numStages;
+        double scalarNanoseconds;
+        double biquadNanoseconds;
+        double stateVariableNanoseconds;
+    };
+
+    static const int numChannelCounts = 3;
+    static const int numStageCounts = 4;
+
+    /// The number of configurations timed.
+    static const int numCases = numChannelCounts * numStageCounts;
+
+    /// Runs every case over numSamples samples per channel and writes their
+    /// timings to results.
+    static void run(int numSamples, Result (&results)[numCases])
+    {
+        const int channelCounts[numChannelCounts] = { 2, 8, 16 };
+        const int stageCounts[numStageCounts] = { 1, 2, 4, 8 };
+        const int maximumChannels = 16;
+        const double sampleRate = 48000.0;
+
+        numSamples = jmax((int) blockSize, numSamples);
+
+        AudioSampleBuffer buffer(maximumChannels, numSamples);
+        Random random(1);
+        for (int channel = 0; channel < maximumChannels; ++channel) {
+            float* const samples = buffer.getWritePointer(channel);
+            for (int i = 0; i < numSamples; ++i) {
+                samples[i] = random.nextFloat() * 2.f - 1.f;
+            }
+        }
+
+        for (int i = 0; i < numCases; ++i) {
+            Result& result = results[i];
+            result.numChannels = channelCounts[i / numStageCounts];
+            result.numStages = stageCounts[i % numStageCounts];
+
+            ScalarCascade scalar(sampleRate, result.numChannels, result.numStages);
+            result.scalarNanoseconds = time(scalar, buffer, result.numChannels);
+
+            FilterBank biquadBank;
+            prepare(biquadBank, FilterBank::biquad, sampleRate, result.numChannels, result.numStages);
+            result.biquadNanoseconds = time(biquadBank, buffer, result.numChannels);
+
+            FilterBank stateVariableBank;
+            prepare(stateVariableBank, FilterBank::stateVariable, sampleRate, result.numChannels, result.numStages);
+            result.stateVariableNanoseconds = time(stateVariableBank, buffer, result.numChannels);
+        }
+    }
+
+private:
+    static const int blockSize = 256;
+
+    /// The frequency of every lowpass stage.
+    static float getFrequency(int stage) { return 2000.f + 1000.f * stage; }
+
+    /// A transposed direct form II biquad cascade per channel, one sample and
+    /// one stage at a time.
+    class ScalarCascade {
+    public:
+        ScalarCascade(double sampleRate, int numChannels, int numStages)
+        : num_stages(numStages)
+        {
+            coefficients.calloc((size_t) numStages * 5);
+            states.calloc((size_t) numChannels * (size_t) numStages * 2);
+
+            for (int stage = 0; stage < numStages; ++stage) {
+                const double w = 2.0 * double_Pi * getFrequency(stage) / sampleRate;
+                const double alpha = std::sin(w) / (2.0 * 0.70710678);
+                const double a0 = 1.0 + alpha;
+                float* const c = coefficients + stage * 5;
+
+                c[0] = c[2] = (float) ((1.0 - std::cos(w)) / 2.0 / a0);
+                c[1] = (float) ((1.0 - std::cos(w)) / a0);
+                c[3] = (float) (-2.0 * std::cos(w) / a0);
+                c[4] = (float) ((1.0 - alpha) / a0);
+            }
+        }
+
+        void process(float* const* channels, int numChannels, int numSamples)
+        {
+            for (int channel = 0; channel < numChannels; ++channel) {
+                float* const samples = channels[channel];
+
+                for (int stage = 0; stage < num_stages; ++stage) {
+                    const float* const c = coefficients + stage * 5;
+                    float* const state = states + (channel * num_stages + stage) * 2;
+                    float s1 = state[0], s2 = state[1];
+
+                    for (int i = 0; i < numSamples; ++i) {
+                        const float x = samples[i];
+                        const float y = c[0] * x + s1;
+                        s1 = c[1] * x - c[3] * y + s2;
+                        s2 = c[2] * x - c[4] * y;
+                        samples[i] = y;
+                    }
+
+                    state[0] = s1;
+                    state[1] = s2;
+                }
+            }
+        }
+
+    private:
+        int num_stages;
+        HeapBlock<float> coefficients;
+        HeapBlock<float> states;
+    };
+
+    static void prepare(FilterBank& bank, FilterBank::Topology topology, double sampleRate,
+                        int numChannels, int numStages)
+    {
+        bank.setTopology(topology);
+        bank.prepare(sampleRate, numChannels, numStages);
+
+        for (int stage = 0; stage < numStages; ++stage) {
+            bank.setStage(stage, FilterBank::lowPass, getFrequency(stage));
+        }
+
+        // Reach the coefficients, so the timed blocks don't interpolate
+        AudioSampleBuffer warmUp(numChannels, 1);
+        warmUp.clear();
+        bank.process(warmUp.getArrayOfWritePointers(), numChannels, 1);
+    }
+
+    /// Returns the mean time per sample and channel in nanoseconds of
+    /// filtering buffer in blocks.
+    template <typename Filter>
+    static double time(Filter& filter, const AudioSampleBuffer& source, int numChannels)
+    {
+        const int numSamples = source.getNumSamples();
+
+        AudioSampleBuffer buffer(numChannels, numSamples);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            buffer.copyFrom(channel, 0, source, channel, 0, numSamples);
+        }
+
+        float* channels[16];
+        const int64 start = Time::getHighResolutionTicks();
+
+        for (int position = 0; position + blockSize <= numSamples; position += blockSize) {
+            for (int channel = 0; channel < numChannels; ++channel) {
+                channels[channel] = buffer.getWritePointer(channel, position);
+            }
+            filter.process(channels, numChannels, blockSize);
+        }
+
+        const double seconds = (double) (Time::getHighResolutionTicks() - start)
+                             / (double) Time::getHighResolutionTicksPerSecond();
+
+        // Keeps the loops from being optimized away
+        volatile float sink = buffer.getReadPointer(0)[numSamples / 2];
+        (void) sink;
+
+        return seconds * 1.0e9 / ((double) (numSamples / blockSize) * blockSize * numChannels);
+    }
+};
+
+
+#endif  // FILTERBENCHMARK_H_INCLUDED
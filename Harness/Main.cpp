@@ -0,0 +1,673 @@
+/*
+    Headless benchmark and render harness.
+
+    Runs the plugin's processBlock() over a matrix of test signals, sample rates,
+    block sizes and channel counts without a host or audio device, and reports
+    the timings as a table and optionally as JSON. See the readme for how to
+    build it.
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../Source/RealtimeSafety.h"
+#include "Benchmark.h"
+#include "Regression.h"
+#include "TextBenchmark.h"
+#include "MappingBenchmark.h"
+#include "ConvolutionBenchmark.h"
+#include "FilterBenchmark.h"
+#include "DecibelBenchmark.h"
+#include "StateBenchmark.h"
+
+#include <iostream>
+
+//==============================================================================
+namespace
+{
+    struct Options
+    {
+        Array<int> blockSizes;
+        Array<double> sampleRates;
+        Array<int> channelCounts;
+        Array<TestSignals::Type> signals;
+        Array<AudioProcessor::ProcessingPrecision> precisions;
+        double seconds;
+        String jsonPath;
+        String renderPath;
+        String automationPath;
+        String goldenPath;
+        String baselinePath;
+        float tolerance;
+        double maximumSlowdown;
+        bool update;
+        double minimumRealtimeFactor;
+        bool failOnViolations;
+        bool parameterText;
+        bool parameterMapping;
+        bool convolution;
+        bool filterBank;
+        bool decibels;
+        bool state;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: PluginHarness [options]" << std::endl
+                  << std::endl
+                  << "  --block-sizes 64,256,1024        host block sizes" << std::endl
+                  << "  --sample-rates 44100,48000,96000 sample rates" << std::endl
+                  << "  --channels 1,2,6                 channel counts" << std::endl
+                  << "  --signals noise,sweep,silence,denormal" << std::endl
+                  << "  --precisions float,double        sample types, double runs the 64-bit processBlock" << std::endl
+                  << "  --seconds 5                      audio processed per run" << std::endl
+                  << "  --json <file>                    also write the results as JSON, - for stdout" << std::endl
+                  << "  --render <directory>             write the output of each run as a WAV file" << std::endl
+                  << "  --min-realtime-factor <x>        exit with 1 if any run is slower" << std::endl
+                  << "  --automation <file>|sweep        set parameters during each run from a script, or" << std::endl
+                  << "                                   step every parameter through its range" << std::endl
+                  << "  --golden <directory>             exit with 1 if any output differs from its golden" << std::endl
+                  << "                                   file or its state does not restore, or the file" << std::endl
+                  << "                                   is missing" << std::endl
+                  << "  --tolerance 0.00001              largest sample difference from the golden output" << std::endl
+                  << "  --baseline <file>                exit with 1 if any p50 block time is slower than" << std::endl
+                  << "                                   the baseline or missing from it" << std::endl
+                  << "  --max-slowdown 10                percentage allowed over the baseline" << std::endl
+                  << "  --update                         record the golden files and the baseline" << std::endl
+                  << "  --fail-on-violations             exit with 1 if processBlock allocates, locks or" << std::endl
+                  << "                                   accesses files, needs REALTIMESAFETY_ENABLED=1" << std::endl
+                  << "  --parameter-text                 time parameter text formatting and parsing instead" << std::endl
+                  << "  --parameter-mapping              time parameter mappings against direct evaluation instead" << std::endl
+                  << "  --convolution                    time the convolver with a 5 s impulse response instead" << std::endl
+                  << "  --filter-bank                    time the filter bank against scalar biquads instead" << std::endl
+                  << "  --decibels                       time the dB and uV conversions against the old macros instead" << std::endl
+                  << "  --state                          time saving and restoring 1000 instances against ValueTree XML instead" << std::endl;
+    }
+
+    StringArray splitList (const String& list)
+    {
+        return StringArray::fromTokens (list, ",", String());
+    }
+
+    bool parseOptions (const StringArray& args, Options& options)
+    {
+        const int defaultBlockSizes[] = { 64, 256, 1024 };
+        const double defaultSampleRates[] = { 44100.0, 48000.0, 96000.0 };
+        const int defaultChannelCounts[] = { 1, 2, 6 };
+
+        options.blockSizes.addArray (defaultBlockSizes, numElementsInArray (defaultBlockSizes));
+        options.sampleRates.addArray (defaultSampleRates, numElementsInArray (defaultSampleRates));
+        options.channelCounts.addArray (defaultChannelCounts, numElementsInArray (defaultChannelCounts));
+
+        for (int i = 0; i < TestSignals::numTypes; ++i)
+            options.signals.add ((TestSignals::Type) i);
+
+        options.precisions.add (AudioProcessor::singlePrecision);
+        options.precisions.add (AudioProcessor::doublePrecision);
+
+        options.seconds = 5.0;
+        options.minimumRealtimeFactor = 0.0;
+        options.tolerance = 0.00001f;
+        options.maximumSlowdown = 10.0;
+        options.update = false;
+        options.failOnViolations = false;
+        options.parameterText = false;
+        options.parameterMapping = false;
+        options.convolution = false;
+        options.filterBank = false;
+        options.decibels = false;
+        options.state = false;
+
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const String& arg = args[i];
+
+            if (arg == "--help" || arg == "-h")
+                return false;
+
+            if (arg == "--fail-on-violations")
+            {
+                options.failOnViolations = true;
+                continue;
+            }
+
+            if (arg == "--update")
+            {
+                options.update = true;
+                continue;
+            }
+
+            if (arg == "--parameter-text")
+            {
+                options.parameterText = true;
+                continue;
+            }
+
+            if (arg == "--parameter-mapping")
+            {
+                options.parameterMapping = true;
+                continue;
+            }
+
+            if (arg == "--convolution")
+            {
+                options.convolution = true;
+                continue;
+            }
+
+            if (arg == "--filter-bank")
+            {
+                options.filterBank = true;
+                continue;
+            }
+
+            if (arg == "--decibels")
+            {
+                options.decibels = true;
+                continue;
+            }
+
+            if (arg == "--state")
+            {
+                options.state = true;
+                continue;
+            }
+
+            if (i + 1 >= args.size())
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+
+            const String value (args[++i]);
+
+            if (arg == "--block-sizes" || arg == "--channels")
+            {
+                Array<int>& list = arg == "--block-sizes" ? options.blockSizes : options.channelCounts;
+                list.clear();
+
+                for (const String& item : splitList (value))
+                    if (item.getIntValue() > 0)
+                        list.add (item.getIntValue());
+            }
+            else if (arg == "--sample-rates")
+            {
+                options.sampleRates.clear();
+
+                for (const String& item : splitList (value))
+                    if (item.getDoubleValue() > 0.0)
+                        options.sampleRates.add (item.getDoubleValue());
+            }
+            else if (arg == "--signals")
+            {
+                options.signals.clear();
+
+                for (const String& item : splitList (value))
+                {
+                    TestSignals::Type type;
+                    if (! TestSignals::fromName (item, type))
+                    {
+                        std::cerr << "Unknown signal " << item << std::endl;
+                        return false;
+                    }
+                    options.signals.add (type);
+                }
+            }
+            else if (arg == "--precisions")
+            {
+                options.precisions.clear();
+
+                for (const String& item : splitList (value))
+                {
+                    if (item != "float" && item != "double")
+                    {
+                        std::cerr << "Unknown precision " << item << std::endl;
+                        return false;
+                    }
+                    options.precisions.addIfNotAlreadyThere (item == "double" ? AudioProcessor::doublePrecision
+                                                                              : AudioProcessor::singlePrecision);
+                }
+            }
+            else if (arg == "--seconds")
+                options.seconds = jmax (0.01, value.getDoubleValue());
+            else if (arg == "--json")
+                options.jsonPath = value;
+            else if (arg == "--render")
+                options.renderPath = value;
+            else if (arg == "--min-realtime-factor")
+                options.minimumRealtimeFactor = value.getDoubleValue();
+            else if (arg == "--automation")
+                options.automationPath = value;
+            else if (arg == "--golden")
+                options.goldenPath = value;
+            else if (arg == "--tolerance")
+                options.tolerance = jmax (0.f, value.getFloatValue());
+            else if (arg == "--baseline")
+                options.baselinePath = value;
+            else if (arg == "--max-slowdown")
+                options.maximumSlowdown = jmax (0.0, value.getDoubleValue());
+            else
+            {
+                std::cerr << "Unknown option " << arg << std::endl;
+                return false;
+            }
+        }
+
+        return options.blockSizes.size() > 0 && options.sampleRates.size() > 0
+            && options.channelCounts.size() > 0 && options.signals.size() > 0
+            && options.precisions.size() > 0;
+    }
+
+    const char* getPrecisionName (AudioProcessor::ProcessingPrecision precision)
+    {
+        return precision == AudioProcessor::doublePrecision ? "double" : "float";
+    }
+
+    String getCaseName (const Benchmark::Case& config)
+    {
+        return String (TestSignals::getName (config.signal))
+             + "_" + String (roundToInt (config.sampleRate))
+             + "_" + String (config.blockSize)
+             + "_" + String (config.numChannels) + "ch"
+             + (config.precision == AudioProcessor::doublePrecision ? "_double" : "");
+    }
+
+    String formatRow (const Benchmark::Result& result)
+    {
+        const Benchmark::Case& config = result.config;
+
+        return String (TestSignals::getName (config.signal)).paddedRight (' ', 10)
+             + String (roundToInt (config.sampleRate)).paddedLeft (' ', 7)
+             + String (config.blockSize).paddedLeft (' ', 7)
+             + String (config.numChannels).paddedLeft (' ', 4)
+             + String (getPrecisionName (config.precision)).paddedLeft (' ', 8)
+             + String (result.nanosecondsPerSample, 2).paddedLeft (' ', 12)
+             + String (result.medianMicroseconds, 2).paddedLeft (' ', 11)
+             + String (result.p99Microseconds, 2).paddedLeft (' ', 11)
+             + String (result.maximumMicroseconds, 2).paddedLeft (' ', 11)
+             + String (result.realtimeFactor, 1).paddedLeft (' ', 11);
+    }
+
+    var toJson (const Benchmark::Result& result, int numViolations)
+    {
+        DynamicObject* object = new DynamicObject();
+        object->setProperty ("signal", TestSignals::getName (result.config.signal));
+        object->setProperty ("sampleRate", result.config.sampleRate);
+        object->setProperty ("blockSize", result.config.blockSize);
+        object->setProperty ("channels", result.config.numChannels);
+        object->setProperty ("precision", getPrecisionName (result.config.precision));
+        object->setProperty ("blocks", result.numBlocks);
+        object->setProperty ("nsPerSample", result.nanosecondsPerSample);
+        object->setProperty ("p50Us", result.medianMicroseconds);
+        object->setProperty ("p99Us", result.p99Microseconds);
+        object->setProperty ("maxUs", result.maximumMicroseconds);
+        object->setProperty ("realtimeFactor", result.realtimeFactor);
+        object->setProperty ("rtViolations", numViolations);
+        return var (object);
+    }
+
+    void runTextBenchmark()
+    {
+        TextBenchmark::Result results[TextBenchmark::numCases];
+        TextBenchmark::run (1000000, results);
+
+        std::cout << "case                            ns/call" << std::endl;
+
+        for (const TextBenchmark::Result& result : results)
+            std::cout << String (result.name).paddedRight (' ', 28)
+                      << String (result.nanosecondsPerCall, 1).paddedLeft (' ', 11) << std::endl;
+    }
+
+    void runMappingBenchmark()
+    {
+        MappingBenchmark::Result results[MappingBenchmark::numCases];
+        MappingBenchmark::run (10000000, results);
+
+        std::cout << "mapping        direct ns  mapping ns    table ns  table error" << std::endl;
+
+        for (const MappingBenchmark::Result& result : results)
+            std::cout << String (result.name).paddedRight (' ', 12)
+                      << String (result.directNanoseconds, 2).paddedLeft (' ', 12)
+                      << String (result.mappingNanoseconds, 2).paddedLeft (' ', 12)
+                      << (result.tableNanoseconds > 0.0 ? String (result.tableNanoseconds, 2) : String ("-")).paddedLeft (' ', 12)
+                      << (result.tableNanoseconds > 0.0 ? String (result.tableError, 7) : String ("-")).paddedLeft (' ', 13) << std::endl;
+    }
+
+    void runConvolutionBenchmark (double seconds)
+    {
+        ConvolutionBenchmark::Result results[ConvolutionBenchmark::numCases];
+        ConvolutionBenchmark::run (seconds, 5.0, results);
+
+        std::cout << "block  thread   audio %/ch   total %/ch     max us   late" << std::endl;
+
+        for (const ConvolutionBenchmark::Result& result : results)
+            std::cout << String (result.blockSize).paddedLeft (' ', 5)
+                      << String (result.backgroundThread ? "yes" : "no").paddedLeft (' ', 8)
+                      << String (result.audioThreadPercent, 2).paddedLeft (' ', 13)
+                      << String (result.totalPercent, 2).paddedLeft (' ', 13)
+                      << String (result.maximumMicroseconds, 1).paddedLeft (' ', 11)
+                      << String (result.lateBlocks).paddedLeft (' ', 7) << std::endl;
+    }
+
+    void runFilterBenchmark (double seconds)
+    {
+        FilterBenchmark::Result results[FilterBenchmark::numCases];
+        FilterBenchmark::run ((int) (seconds * 48000.0), results);
+
+        std::cout << "channels  stages   scalar ns   biquad ns      svf ns  speedup" << std::endl;
+
+        for (const FilterBenchmark::Result& result : results)
+            std::cout << String (result.numChannels).paddedLeft (' ', 8)
+                      << String (result.numStages).paddedLeft (' ', 8)
+                      << String (result.scalarNanoseconds, 2).paddedLeft (' ', 12)
+                      << String (result.biquadNanoseconds, 2).paddedLeft (' ', 12)
+                      << String (result.stateVariableNanoseconds, 2).paddedLeft (' ', 12)
+                      << String (result.scalarNanoseconds / result.biquadNanoseconds, 2).paddedLeft (' ', 9) << std::endl;
+    }
+
+    void runDecibelBenchmark()
+    {
+        DecibelBenchmark::Result results[DecibelBenchmark::maximumCases];
+        const int numResults = DecibelBenchmark::run (10000000, results);
+
+        std::cout << "conversion  method   ns/value    max error" << std::endl;
+
+        for (int i = 0; i < numResults; ++i)
+            std::cout << String (results[i].conversion).paddedRight (' ', 12)
+                      << String (results[i].method).paddedRight (' ', 6)
+                      << String (results[i].nanosecondsPerValue, 2).paddedLeft (' ', 11)
+                      << String (results[i].maximumError, 7).paddedLeft (' ', 13) << std::endl;
+    }
+
+    void runStateBenchmark()
+    {
+        StateBenchmark::Result results[StateBenchmark::numCases];
+        StateBenchmark::run (1000, 200, results);
+
+        std::cout << "format            save us    load us      bytes" << std::endl;
+
+        for (const StateBenchmark::Result& result : results)
+            std::cout << String (result.name).paddedRight (' ', 14)
+                      << String (result.saveMicroseconds, 2).paddedLeft (' ', 11)
+                      << String (result.loadMicroseconds, 2).paddedLeft (' ', 11)
+                      << String (result.bytes, 0).paddedLeft (' ', 11) << std::endl;
+    }
+
+    bool writeWav (const File& file, const AudioSampleBuffer& buffer, double sampleRate)
+    {
+        file.deleteFile();
+        ScopedPointer<FileOutputStream> stream (file.createOutputStream());
+
+        if (stream == nullptr)
+            return false;
+
+        WavAudioFormat wav;
+        ScopedPointer<AudioFormatWriter> writer (wav.createWriterFor (stream, sampleRate,
+                                                                      (unsigned int) buffer.getNumChannels(),
+                                                                      32, StringPairArray(), 0));
+        if (writer == nullptr)
+            return false;
+
+        stream.release();   // now owned by the writer
+        return writer->writeFromAudioSampleBuffer (buffer, 0, buffer.getNumSamples());
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processor starts timers for its preset and latency notifications,
+    // which need a message manager. No message loop runs here, so they never
+    // fire
+    const ScopedJuceInitialiser_GUI juceInitialiser;
+
+    StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    Options options;
+    if (! parseOptions (args, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    if (options.parameterText)
+    {
+        runTextBenchmark();
+        return 0;
+    }
+
+    if (options.parameterMapping)
+    {
+        runMappingBenchmark();
+        return 0;
+    }
+
+    if (options.convolution)
+    {
+        runConvolutionBenchmark (options.seconds);
+        return 0;
+    }
+
+    if (options.filterBank)
+    {
+        runFilterBenchmark (options.seconds);
+        return 0;
+    }
+
+    if (options.decibels)
+    {
+        runDecibelBenchmark();
+        return 0;
+    }
+
+    if (options.state)
+    {
+        runStateBenchmark();
+        return 0;
+    }
+
+    File renderDirectory;
+    if (options.renderPath.isNotEmpty())
+    {
+        renderDirectory = File::getCurrentWorkingDirectory().getChildFile (options.renderPath);
+        renderDirectory.createDirectory();
+    }
+
+    File goldenDirectory;
+    if (options.goldenPath.isNotEmpty())
+    {
+        goldenDirectory = File::getCurrentWorkingDirectory().getChildFile (options.goldenPath);
+
+        if (options.update)
+            goldenDirectory.createDirectory();
+    }
+
+    // With --update the baseline starts empty, so every run is recorded again
+    File baselineFile;
+    Regression::Baseline baseline;
+    bool baselineChanged = false;
+
+    if (options.baselinePath.isNotEmpty())
+    {
+        baselineFile = File::getCurrentWorkingDirectory().getChildFile (options.baselinePath);
+
+        if (! options.update)
+            baseline.load (baselineFile);
+    }
+
+    Automation automation;
+    if (options.automationPath.isNotEmpty())
+    {
+        ScopedPointer<AudioProcessor> processor (createPluginFilter());
+
+        if (options.automationPath == "sweep")
+        {
+            automation.createSweep (*processor, options.seconds);
+        }
+        else
+        {
+            const File script (File::getCurrentWorkingDirectory().getChildFile (options.automationPath));
+            String error ("could not be read");
+
+            if (! script.existsAsFile() || ! automation.parse (script.loadFileAsString(), *processor, error))
+            {
+                std::cerr << options.automationPath << ": " << error << std::endl;
+                return 2;
+            }
+        }
+    }
+
+    if (options.failOnViolations && ! RealtimeSafety::isEnabled())
+    {
+        std::cerr << "--fail-on-violations needs a build with REALTIMESAFETY_ENABLED=1" << std::endl;
+        return 2;
+    }
+
+    // Violations are reported after each run instead of asserting
+    RealtimeSafety::setAction (RealtimeSafety::recordViolations);
+
+    // With JSON on stdout, the table goes to stderr so the output stays valid
+    std::ostream& table = options.jsonPath == "-" ? std::cerr : std::cout;
+
+    // Hosts convert double buffers to float for plugins without a double path
+    if (options.precisions.contains (AudioProcessor::doublePrecision) && ! Benchmark::supportsDoublePrecision())
+    {
+        std::cerr << "The plugin does not support double precision, only timing float" << std::endl;
+        options.precisions.removeAllInstancesOf (AudioProcessor::doublePrecision);
+
+        if (options.precisions.isEmpty())
+            return 2;
+    }
+
+    table << "signal       rate  block  ch    prec   ns/sample    p50 us     p99 us     max us   RT factor" << std::endl;
+
+    Array<var> results;
+    bool passed = true;
+    AudioSampleBuffer render;
+
+    for (TestSignals::Type signal : options.signals)
+    for (double sampleRate : options.sampleRates)
+    for (int blockSize : options.blockSizes)
+    for (int numChannels : options.channelCounts)
+    for (AudioProcessor::ProcessingPrecision precision : options.precisions)
+    {
+        Benchmark::Case config;
+        config.signal = signal;
+        config.sampleRate = sampleRate;
+        config.blockSize = blockSize;
+        config.numChannels = numChannels;
+        config.precision = precision;
+        config.automation = automation.isEmpty() ? nullptr : &automation;
+
+        const bool comparing = goldenDirectory != File();
+        const bool rendering = renderDirectory != File() || comparing;
+        MemoryBlock state;
+
+        RealtimeSafety::clearViolations();
+        const Benchmark::Result result = Benchmark::run (config, options.seconds, rendering ? &render : nullptr,
+                                                         comparing ? &state : nullptr);
+        const int numViolations = RealtimeSafety::getNumViolations();
+
+        table << formatRow (result) << std::endl;
+        results.add (toJson (result, numViolations));
+
+        if (result.realtimeFactor < options.minimumRealtimeFactor)
+            passed = false;
+
+        if (numViolations > 0)
+        {
+            RealtimeSafety::Record record;
+            RealtimeSafety::getViolation (0, record);
+            table << "  " << numViolations << " real-time safety violations, the first: "
+                  << RealtimeSafety::describe (record) << std::endl;
+
+            if (options.failOnViolations)
+                passed = false;
+        }
+
+        if (renderDirectory != File() && ! writeWav (renderDirectory.getChildFile (getCaseName (config) + ".wav"), render, sampleRate))
+            std::cerr << "Could not write " << getCaseName (config) << ".wav" << std::endl;
+
+        if (comparing)
+        {
+            const File golden (goldenDirectory.getChildFile (getCaseName (config) + ".raw"));
+            float difference;
+
+            switch (Regression::compareWithGolden (golden, render, options.tolerance, options.update, difference))
+            {
+                case Regression::recorded:
+                    table << "  recorded the golden output" << std::endl;
+                    break;
+
+                case Regression::missing:
+                    table << "  there is no golden output, record it with --update" << std::endl;
+                    passed = false;
+                    break;
+
+                case Regression::differed:
+                    if (std::isinf (difference))
+                        table << "  the output has a different length or channel count than the golden output" << std::endl;
+                    else
+                        table << "  the output differs from the golden output by up to " << String (difference, 7) << std::endl;
+
+                    passed = false;
+                    break;
+
+                case Regression::matched:
+                    break;
+            }
+
+            if (! Regression::checkStateRoundTrip (state))
+            {
+                table << "  the state saved after the run does not restore to the same state" << std::endl;
+                passed = false;
+            }
+        }
+
+        if (baselineFile != File())
+        {
+            double baselineMicroseconds;
+
+            if (options.update)
+            {
+                baseline.set (getCaseName (config), result.medianMicroseconds);
+                baselineChanged = true;
+            }
+            else if (! baseline.get (getCaseName (config), baselineMicroseconds))
+            {
+                table << "  there is no baseline entry, record it with --update" << std::endl;
+                passed = false;
+            }
+            else if (result.medianMicroseconds > baselineMicroseconds * (1.0 + options.maximumSlowdown / 100.0))
+            {
+                table << "  the p50 block time is " << String (100.0 * (result.medianMicroseconds / baselineMicroseconds - 1.0), 1)
+                      << "% slower than the baseline of " << String (baselineMicroseconds, 2) << " us" << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    if (baselineChanged && ! baseline.save (baselineFile))
+        std::cerr << "Could not write " << options.baselinePath << std::endl;
+
+    if (options.jsonPath.isNotEmpty())
+    {
+        DynamicObject* root = new DynamicObject();
+        root->setProperty ("plugin", JucePlugin_Name);
+        root->setProperty ("seconds", options.seconds);
+        root->setProperty ("results", results);
+
+        const String json (JSON::toString (var (root)));
+
+        if (options.jsonPath == "-")
+            std::cout << json << std::endl;
+        else
+            File::getCurrentWorkingDirectory().getChildFile (options.jsonPath).replaceWithText (json);
+    }
+
+    if (! passed)
+        table << "Failed: a run was slower than the minimum real-time factor or its baseline, violated real-time safety,"
+              << " or did not match its golden output or state" << std::endl;
+
+    return passed ? 0 : 1;
+}
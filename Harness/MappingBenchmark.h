@@ -0,0 +1,174 @@
+#ifndef MAPPINGBENCHMARK_H_INCLUDED
+#define MAPPINGBENCHMARK_H_INCLUDED
+
+#include <cmath>
+
+#include "../Source/ParameterMapping.h"
+
+/**
+    Times each ParameterMapping against evaluating its curve directly with the
+    transcendental functions, the way parameters were mapped by hand before,
+    and against a ParameterMapping::Table of it.
+
+    Every case converts the same sweep of normalized values to actual values.
+    The largest relative error of each table against its exact mapping is
+    reported alongside.
+ */
+class MappingBenchmark {
+public:
+    /// The timings of a single mapping in nanoseconds per conversion. The table
+    /// timing and error are 0 for mappings not worth a table.
+    struct Result {
+        const char* name;
+        double directNanoseconds;
+        double mappingNanoseconds;
+        double tableNanoseconds;
+        double tableError;
+    };
+
+    /// The number of mappings timed.
+    static const int numCases = 5;
+
+    /// Runs every case over numConversions values and writes their timings to
+    /// results.
+    static void run(int numConversions, Result (&results)[numCases])
+    {
+        const int numValues = 4096;
+        const int numPasses = jmax(1, numConversions / numValues);
+
+        HeapBlock<float> values((size_t) numValues);
+        HeapBlock<float> actual((size_t) numValues);
+        for (int i = 0; i < numValues; ++i) {
+            values[i] = (float) i / (numValues - 1);
+        }
+
+        const float minimum = 20.f;
+        const float maximum = 20000.f;
+        const float range = maximum - minimum;
+
+        {
+            const ParameterMapping::Linear mapping(minimum, maximum);
+            auto direct = [=] (float v) { return minimum + range * v; };
+
+            Result& result = results[0];
+            result.name = "linear";
+            result.directNanoseconds = time(direct, values, actual, numValues, numPasses);
+            result.mappingNanoseconds = time(toActual(mapping), values, actual, numValues, numPasses);
+            result.tableNanoseconds = 0.0;
+            result.tableError = 0.0;
+        }
+
+        {
+            const ParameterMapping::Logarithmic mapping(minimum, maximum);
+            const ParameterMapping::Table<ParameterMapping::Logarithmic> table(mapping);
+            auto direct = [=] (float v) { return minimum * std::pow(maximum / minimum, v); };
+
+            Result& result = results[1];
+            result.name = "logarithmic";
+            result.directNanoseconds = time(direct, values, actual, numValues, numPasses);
+            result.mappingNanoseconds = time(toActual(mapping), values, actual, numValues, numPasses);
+            result.tableNanoseconds = time(toActual(table), values, actual, numValues, numPasses);
+            result.tableError = getTableError(mapping, table, values, numValues);
+        }
+
+        {
+            const float skew = 0.3f;
+            const ParameterMapping::Skewed mapping(minimum, maximum, skew);
+            const ParameterMapping::Table<ParameterMapping::Skewed> table(mapping);
+            auto direct = [=] (float v) { return minimum + range * std::pow(v, 1.f / skew); };
+
+            Result& result = results[2];
+            result.name = "skewed";
+            result.directNanoseconds = time(direct, values, actual, numValues, numPasses);
+            result.mappingNanoseconds = time(toActual(mapping), values, actual, numValues, numPasses);
+            result.tableNanoseconds = time(toActual(table), values, actual, numValues, numPasses);
+            result.tableError = getTableError(mapping, table, values, numValues);
+        }
+
+        {
+            const float curvature = 4.f;
+            const ParameterMapping::Exponential mapping(minimum, maximum, curvature);
+            const ParameterMapping::Table<ParameterMapping::Exponential> table(mapping);
+            auto direct = [=] (float v) {
+                return minimum + range * (std::exp(curvature * v) - 1.f) / (std::exp(curvature) - 1.f);
+            };
+
+            Result& result = results[3];
+            result.name = "exponential";
+            result.directNanoseconds = time(direct, values, actual, numValues, numPasses);
+            result.mappingNanoseconds = time(toActual(mapping), values, actual, numValues, numPasses);
+            result.tableNanoseconds = time(toActual(table), values, actual, numValues, numPasses);
+            result.tableError = getTableError(mapping, table, values, numValues);
+        }
+
+        {
+            const int numSteps = 8;
+            const ParameterMapping::Stepped mapping(minimum, maximum, numSteps);
+            auto direct = [=] (float v) {
+                return minimum + range * std::floor(v * (numSteps - 1) + 0.5f) / (numSteps - 1);
+            };
+
+            Result& result = results[4];
+            result.name = "stepped";
+            result.directNanoseconds = time(direct, values, actual, numValues, numPasses);
+            result.mappingNanoseconds = time(toActual(mapping), values, actual, numValues, numPasses);
+            result.tableNanoseconds = 0.0;
+            result.tableError = 0.0;
+        }
+    }
+
+private:
+    /// Calls toActual() of a mapping, so it is timed the same way as the
+    /// direct lambdas.
+    template <typename Mapping>
+    struct ToActual {
+        const Mapping& mapping;
+        float operator()(float value) const { return mapping.toActual(value); }
+    };
+
+    /// Returns the mean time of a conversion in nanoseconds.
+    template <typename Function>
+    static double time(const Function& convert, const float* values, float* actual,
+                       int numValues, int numPasses)
+    {
+        const int64 start = Time::getHighResolutionTicks();
+
+        for (int pass = 0; pass < numPasses; ++pass) {
+            for (int i = 0; i < numValues; ++i) {
+                actual[i] = convert(values[i]);
+            }
+        }
+
+        const double seconds = (double) (Time::getHighResolutionTicks() - start)
+                             / (double) Time::getHighResolutionTicksPerSecond();
+
+        // Keeps the loops from being optimized away
+        volatile float sink = actual[numValues / 2];
+        (void) sink;
+
+        return seconds * 1.0e9 / ((double) numPasses * numValues);
+    }
+
+    template <typename Mapping>
+    static ToActual<Mapping> toActual(const Mapping& mapping)
+    {
+        ToActual<Mapping> function = { mapping };
+        return function;
+    }
+
+    /// Returns the largest relative error of a table against its mapping.
+    template <typename Mapping, typename Table>
+    static double getTableError(const Mapping& mapping, const Table& table,
+                                const float* values, int numValues)
+    {
+        double error = 0.0;
+        for (int i = 0; i < numValues; ++i) {
+            const double exact = mapping.toActual(values[i]);
+            error = jmax(error, std::abs(table.toActual(values[i]) - exact) / std::abs(exact));
+        }
+        return error;
+    }
+};
+
+
+#endif  // MAPPINGBENCHMARK_H_INCLUDED
@@ -0,0 +1,158 @@
+#ifndef REGRESSION_H_INCLUDED
+#define REGRESSION_H_INCLUDED
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+/// Creates the plugin, defined in PluginProcessor.cpp.
+AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+/**
+    Checks the harness runs against earlier ones, so a change that alters the
+    output of processBlock, the parameters or the saved state, or that makes
+    processing slower, fails the run.
+
+    - Golden files hold the rendered output of a run as raw 32-bit floats in
+      the byte order of the machine, one channel after another. A run matches
+      if no sample differs by more than the tolerance.
+    - The state a run ends with must restore into a fresh processor and save
+      back to the same bytes.
+    - A baseline file holds the median block time of each run, one run per
+      line. A run regresses if it is slower by more than a percentage.
+
+    Missing golden files and baseline entries fail the run like a mismatch, so
+    a misspelt directory or a new case cannot pass unchecked. Record them, or
+    record everything again after an intended change, with update set.
+ */
+class Regression {
+public:
+    /// The result of comparing with a golden file.
+    enum Outcome {
+        matched,
+        differed,
+        missing,
+        recorded
+    };
+
+    /** Compares output with the golden file, or writes it if update is true.
+        maximumDifference is set to the largest difference of a sample, or
+        infinity if the number of channels or samples differ.
+     */
+    static Outcome compareWithGolden(const File& file, const AudioSampleBuffer& output,
+                                     float tolerance, bool update, float& maximumDifference)
+    {
+        const int numChannels = output.getNumChannels();
+        const int numSamples = output.getNumSamples();
+        const size_t channelSize = sizeof(float) * (size_t) numSamples;
+
+        maximumDifference = 0.f;
+
+        if (update) {
+            MemoryBlock data;
+            for (int channel = 0; channel < numChannels; ++channel) {
+                data.append(output.getReadPointer(channel), channelSize);
+            }
+            file.replaceWithData(data.getData(), data.getSize());
+            return recorded;
+        }
+
+        if (! file.existsAsFile()) {
+            return missing;
+        }
+
+        MemoryBlock golden;
+        if (! file.loadFileAsData(golden) || golden.getSize() != channelSize * (size_t) numChannels) {
+            maximumDifference = std::numeric_limits<float>::infinity();
+            return differed;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const float* const expected = static_cast<const float*>(golden.getData()) + (size_t) channel * (size_t) numSamples;
+            const float* const samples = output.getReadPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i) {
+                maximumDifference = jmax(maximumDifference, std::abs(samples[i] - expected[i]));
+            }
+        }
+
+        return maximumDifference <= tolerance ? matched : differed;
+    }
+
+    /// Restores state into a fresh processor and returns true if it saves the
+    /// same bytes back.
+    static bool checkStateRoundTrip(const MemoryBlock& state)
+    {
+        ScopedPointer<AudioProcessor> processor(createPluginFilter());
+        processor->setStateInformation(state.getData(), (int) state.getSize());
+
+        MemoryBlock restored;
+        processor->getStateInformation(restored);
+
+        return restored.getSize() == state.getSize()
+            && std::memcmp(restored.getData(), state.getData(), state.getSize()) == 0;
+    }
+
+    /// The median block times of runs by name, in microseconds.
+    class Baseline {
+    public:
+        /// Reads a baseline file, or starts an empty baseline if there is none.
+        void load(const File& file)
+        {
+            names.clear();
+            times.clear();
+
+            const StringArray lines(StringArray::fromLines(file.loadFileAsString()));
+            for (const String& line : lines) {
+                StringArray fields(StringArray::fromTokens(line, " \t", String()));
+                fields.removeEmptyStrings();
+
+                if (fields.size() == 2 && ! fields[0].startsWithChar('#')) {
+                    set(fields[0], fields[1].getDoubleValue());
+                }
+            }
+        }
+
+        /// Writes the baseline to a file, replacing it.
+        bool save(const File& file) const
+        {
+            String text("# run  p50 us\n");
+            for (int i = 0; i < names.size(); ++i) {
+                text += names[i] + " " + String(times[i], 3) + "\n";
+            }
+            return file.replaceWithText(text);
+        }
+
+        /// Looks up the time of a run. Returns false if it is not in the
+        /// baseline.
+        bool get(const String& name, double& microseconds) const
+        {
+            const int index = names.indexOf(name);
+            if (index < 0) {
+                return false;
+            }
+            microseconds = times[index];
+            return true;
+        }
+
+        /// Sets the time of a run.
+        void set(const String& name, double microseconds)
+        {
+            const int index = names.indexOf(name);
+            if (index < 0) {
+                names.add(name);
+                times.add(microseconds);
+            }
+            else {
+                times.set(index, microseconds);
+            }
+        }
+
+    private:
+        StringArray names;
+        Array<double> times;
+    };
+};
+
+
+#endif  // REGRESSION_H_INCLUDED
@@ -0,0 +1,144 @@
+#ifndef STATEBENCHMARK_H_INCLUDED
+#define STATEBENCHMARK_H_INCLUDED
+
+#include "../Source/ParameterState.h"
+
+/**
+    Times saving and restoring the state of many plugin instances, as a host
+    does when it saves or opens a large session, with ParameterState against
+    storing the parameters as properties of a ValueTree copied to binary XML,
+    the usual JUCE approach.
+
+    Every instance has its own parameters, set to random values before saving,
+    so each case converts the same values. The mean times per instance and the
+    mean state size are reported.
+ */
+class StateBenchmark {
+public:
+    /// The timings of a single format.
+    struct Result {
+        const char* name;
+        double saveMicroseconds;
+        double loadMicroseconds;
+        double bytes;
+    };
+
+    /// The number of formats timed.
+    static const int numCases = 2;
+
+    /// Saves and restores numInstances instances with numParameters parameters
+    /// each in every format and writes their timings to results.
+    static void run(int numInstances, int numParameters, Result (&results)[numCases])
+    {
+        numInstances = jmax(1, numInstances);
+
+        Random random(1);
+        OwnedArray<Instance> instances;
+        OwnedArray<MemoryBlock> states;
+        for (int i = 0; i < numInstances; ++i) {
+            Instance* const instance = instances.add(new Instance(numParameters));
+            for (PluginParameter* parameter : instance->parameters) {
+                parameter->setValue(random.nextFloat());
+            }
+            states.add(new MemoryBlock());
+        }
+
+        {
+            Result& result = results[0];
+            result.name = "ParameterState";
+            result.saveMicroseconds = time(numInstances, [&] (int i) {
+                instances[i]->state.save(*states[i]);
+            });
+            result.bytes = getMeanSize(states);
+            result.loadMicroseconds = time(numInstances, [&] (int i) {
+                instances[i]->state.load(states[i]->getData(), states[i]->getSize());
+            });
+        }
+
+        {
+            Result& result = results[1];
+            result.name = "ValueTree XML";
+            result.saveMicroseconds = time(numInstances, [&] (int i) {
+                saveXml(instances[i]->parameters, *states[i]);
+            });
+            result.bytes = getMeanSize(states);
+            result.loadMicroseconds = time(numInstances, [&] (int i) {
+                loadXml(instances[i]->parameters, *states[i]);
+            });
+        }
+    }
+
+private:
+    /// The parameters of one plugin instance.
+    struct Instance {
+        explicit Instance(int numParameters)
+        {
+            for (int i = 0; i < numParameters; ++i) {
+                PluginParameter* const parameter = new PluginParameter("parameter" + String(i), 0.5f, 0.f, 1.f,
+                                                                       "Parameter " + String(i));
+                owned.add(parameter);
+                parameters.add(parameter);
+            }
+            state.setParameters(parameters);
+        }
+
+        OwnedArray<PluginParameter> owned;
+        Array<PluginParameter*> parameters;
+        ParameterState state;
+    };
+
+    /// Saves the parameters the way plugins did before ParameterState.
+    static void saveXml(const Array<PluginParameter*>& parameters, MemoryBlock& destination)
+    {
+        ValueTree tree("PARAMETERS");
+        for (PluginParameter* parameter : parameters) {
+            tree.setProperty(parameter->getIdentifier(), parameter->getValue(), nullptr);
+        }
+
+        const ScopedPointer<XmlElement> xml(tree.createXml());
+        AudioProcessor::copyXmlToBinary(*xml, destination);
+    }
+
+    /// Restores parameters saved by saveXml().
+    static void loadXml(const Array<PluginParameter*>& parameters, const MemoryBlock& source)
+    {
+        const ScopedPointer<XmlElement> xml(AudioProcessor::getXmlFromBinary(source.getData(),
+                                                                             (int) source.getSize()));
+        if (xml == nullptr) {
+            return;
+        }
+
+        const ValueTree tree(ValueTree::fromXml(*xml));
+        for (PluginParameter* parameter : parameters) {
+            parameter->setValue((float) tree.getProperty(parameter->getIdentifier(),
+                                                         parameter->getDefaultValue()));
+        }
+    }
+
+    /// Returns the mean time of process(int instance) in microseconds.
+    template <typename Function>
+    static double time(int numInstances, const Function& process)
+    {
+        const int64 start = Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numInstances; ++i) {
+            process(i);
+        }
+
+        const double seconds = (double) (Time::getHighResolutionTicks() - start)
+                             / (double) Time::getHighResolutionTicksPerSecond();
+        return seconds * 1.0e6 / numInstances;
+    }
+
+    static double getMeanSize(const OwnedArray<MemoryBlock>& states)
+    {
+        double bytes = 0.0;
+        for (const MemoryBlock* state : states) {
+            bytes += (double) state->getSize();
+        }
+        return bytes / jmax(1, states.size());
+    }
+};
+
+
+#endif  // STATEBENCHMARK_H_INCLUDED
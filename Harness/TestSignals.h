@@ -0,0 +1,118 @@
+#ifndef TESTSIGNALS_H_INCLUDED
+#define TESTSIGNALS_H_INCLUDED
+
+#include <cmath>
+
+/**
+    Synthetic signals used to drive the processor outside of a host.
+
+    Every signal is deterministic, so renders of the same build are identical
+    and can be compared between builds.
+
+    - noise: uniform white noise at -6 dBFS peak, different on every channel.
+    - sineSweep: a logarithmic sweep from 20 Hz to 20 kHz, or to 0.45 times
+      the sample rate if that is lower, over the whole buffer.
+    - silence: digital silence.
+    - denormalDecay: a 1 kHz sine decaying exponentially, which passes below
+      the smallest normal float halfway through the buffer and then decays
+      through the denormal range to zero.
+ */
+struct TestSignals {
+    /// The available signals.
+    enum Type {
+        noise,
+        sineSweep,
+        silence,
+        denormalDecay
+    };
+
+    /// The number of signal types.
+    static const int numTypes = 4;
+
+    /// Returns the name of a signal, as used on the command line.
+    static const char* getName(Type type)
+    {
+        switch (type) {
+            case noise:         return "noise";
+            case sineSweep:     return "sweep";
+            case silence:       return "silence";
+            case denormalDecay: return "denormal";
+        }
+        return "";
+    }
+
+    /// Finds the signal with the given name. Returns false if there is none.
+    static bool fromName(const String& name, Type& type)
+    {
+        for (int i = 0; i < numTypes; ++i) {
+            if (name == getName((Type) i)) {
+                type = (Type) i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Fills the whole buffer with a signal at the given sample rate.
+    static void generate(Type type, AudioSampleBuffer& buffer, double sampleRate)
+    {
+        const int numChannels = buffer.getNumChannels();
+        const int numSamples = buffer.getNumSamples();
+
+        switch (type) {
+            case noise:
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    Random random(0x5eed + channel);
+                    float* samples = buffer.getWritePointer(channel);
+                    for (int i = 0; i < numSamples; ++i) {
+                        samples[i] = random.nextFloat() - 0.5f;
+                    }
+                }
+                break;
+
+            case sineSweep: {
+                const double startFrequency = 20.0;
+                const double endFrequency = jmin(20000.0, 0.45 * sampleRate);
+                const double duration = numSamples / sampleRate;
+                const double rate = std::log(endFrequency / startFrequency) / duration;
+
+                float* samples = buffer.getWritePointer(0);
+                for (int i = 0; i < numSamples; ++i) {
+                    const double t = i / sampleRate;
+                    const double phase = 2.0 * double_Pi * startFrequency * (std::exp(rate * t) - 1.0) / rate;
+                    samples[i] = (float) (0.5 * std::sin(phase));
+                }
+                copyToOtherChannels(buffer);
+                break;
+            }
+
+            case silence:
+                buffer.clear();
+                break;
+
+            case denormalDecay: {
+                // Reach the smallest normal float, about 1.2e-38, halfway through
+                const double decay = 2.0 * std::log(0.5 / 1.17549435e-38) / jmax(1, numSamples);
+
+                float* samples = buffer.getWritePointer(0);
+                for (int i = 0; i < numSamples; ++i) {
+                    const double amplitude = 0.5 * std::exp(-decay * i);
+                    samples[i] = (float) (amplitude * std::sin(2.0 * double_Pi * 1000.0 * i / sampleRate));
+                }
+                copyToOtherChannels(buffer);
+                break;
+            }
+        }
+    }
+
+private:
+    static void copyToOtherChannels(AudioSampleBuffer& buffer)
+    {
+        for (int channel = 1; channel < buffer.getNumChannels(); ++channel) {
+            buffer.copyFrom(channel, 0, buffer, 0, 0, buffer.getNumSamples());
+        }
+    }
+};
+
+
+#endif  // TESTSIGNALS_H_INCLUDED
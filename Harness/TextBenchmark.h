@@ -0,0 +1,114 @@
+#ifndef TEXTBENCHMARK_H_INCLUDED
+#define TEXTBENCHMARK_H_INCLUDED
+
+#include <iomanip>
+#include <sstream>
+
+#include "../Source/PluginParameter.h"
+
+/**
+    Times formatting and parsing parameter text, which hosts do on the message
+    thread whenever they draw automation lanes or generic editors.
+
+    The stream based path PluginParameter used before ParameterText is kept here
+    as the baseline. Each case runs numCalls times over a sweep of values, so
+    only the cached case sees the same value twice in a row.
+ */
+class TextBenchmark {
+public:
+    /// The timing of a single case.
+    struct Result {
+        const char* name;
+        double nanosecondsPerCall;
+    };
+
+    /// The number of cases run.
+    static const int numCases = 6;
+
+    /// Runs every case numCalls times and writes their timings to results.
+    static void run(int numCalls, Result (&results)[numCases])
+    {
+        numCalls = jmax(1, numCalls);
+
+        PluginParameter parameter("frequency", 1000.f, 20.f, 20000.f, "Frequency", "Hz", 1);
+        parameter.setUnit(ParameterText::hertz);
+
+        const int numValues = 1024;
+        float values[numValues];
+        String texts[numValues];
+        for (int i = 0; i < numValues; ++i) {
+            values[i] = (float) i / (numValues - 1);
+            texts[i] = parameter.getText(values[i], 0);
+        }
+
+        size_t sink = 0;
+        int64 start;
+
+        start = Time::getHighResolutionTicks();
+        for (int i = 0; i < numCalls; ++i) {
+            sink += (size_t) getStreamText(parameter.calculateActualValue(values[i % numValues]), 1).length();
+        }
+        results[0] = makeResult("stream getText", start, numCalls);
+
+        start = Time::getHighResolutionTicks();
+        for (int i = 0; i < numCalls; ++i) {
+            char text[ParameterText::maximumLength];
+            sink += (size_t) ParameterText::format(parameter.calculateActualValue(values[i % numValues]),
+                                                   ParameterText::hertz, 1, text);
+        }
+        results[1] = makeResult("ParameterText::format", start, numCalls);
+
+        start = Time::getHighResolutionTicks();
+        for (int i = 0; i < numCalls; ++i) {
+            sink += (size_t) parameter.getText(values[i % numValues], 0).length();
+        }
+        results[2] = makeResult("getText", start, numCalls);
+
+        start = Time::getHighResolutionTicks();
+        for (int i = 0; i < numCalls; ++i) {
+            sink += (size_t) parameter.getText(values[(i / 64) % numValues], 0).length();
+        }
+        results[3] = makeResult("getText, 64 calls per value", start, numCalls);
+
+        start = Time::getHighResolutionTicks();
+        for (int i = 0; i < numCalls; ++i) {
+            sink += (size_t) (texts[i % numValues].getFloatValue() > 0.f);
+        }
+        results[4] = makeResult("String::getFloatValue", start, numCalls);
+
+        start = Time::getHighResolutionTicks();
+        for (int i = 0; i < numCalls; ++i) {
+            sink += (size_t) (parameter.getValueForText(texts[i % numValues]) > 0.f);
+        }
+        results[5] = makeResult("getValueForText", start, numCalls);
+
+        // Keeps the loops from being optimized away
+        if (sink == 0) {
+            results[0].nanosecondsPerCall = 0.0;
+        }
+    }
+
+private:
+    /// The stream based formatting PluginParameter::getText() used before.
+    static String getStreamText(float actualValue, int precision)
+    {
+        std::ostringstream ss;
+        ss  << std::fixed
+            << std::setprecision(precision)
+            << actualValue;
+        return ss.str();
+    }
+
+    static Result makeResult(const char* name, int64 start, int numCalls)
+    {
+        const double seconds = (double) (Time::getHighResolutionTicks() - start)
+                             / (double) Time::getHighResolutionTicksPerSecond();
+        Result result;
+        result.name = name;
+        result.nanosecondsPerCall = seconds * 1.0e9 / numCalls;
+        return result;
+    }
+};
+
+
+#endif  // TEXTBENCHMARK_H_INCLUDED
@@ -0,0 +1,136 @@
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "BackgroundCompute.h"
+#include "Semaphore.h"
+
+namespace {
+    /// The priority of the thread, below the audio thread and the workers of
+    /// WorkerPool, as nothing waits for it within a block.
+    const int computePriority = 4;
+}
+
+//==============================================================================
+/// The thread, which runs requested tasks and frees retired objects whenever
+/// it is woken.
+class BackgroundCompute::Worker : public Thread {
+public:
+    explicit Worker(BackgroundCompute& owner)
+    : Thread("Background compute"),
+    compute(owner)
+    {
+    }
+
+    void run() override
+    {
+        for (;;) {
+            compute.work_available->wait();
+
+            if (threadShouldExit()) {
+                break;
+            }
+
+            compute.runRequestedTasks();
+            compute.freeRetired();
+        }
+    }
+
+private:
+    BackgroundCompute& compute;
+    JUCE_DECLARE_NON_COPYABLE(Worker)
+};
+
+//==============================================================================
+BackgroundCompute::BackgroundCompute()
+: retired_write(0),
+retired_read(0),
+work_available(new Semaphore())
+{
+    for (int i = 0; i < maximumTasks; ++i) {
+        requested[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+BackgroundCompute::~BackgroundCompute()
+{
+    stop();
+}
+
+int BackgroundCompute::addTask(const Task& task)
+{
+    jassert(worker == nullptr && tasks.size() < maximumTasks);
+
+    tasks.add(task);
+    return tasks.size() - 1;
+}
+
+void BackgroundCompute::start()
+{
+    stop();
+
+    runRequestedTasks();
+
+    worker = new Worker(*this);
+    worker->startThread(computePriority);
+}
+
+void BackgroundCompute::stop()
+{
+    if (worker != nullptr) {
+        worker->signalThreadShouldExit();
+        work_available->signal();
+        worker->stopThread(10000);
+        worker = nullptr;
+
+        // Drop wake-ups the thread didn't take, so they don't carry over to
+        // the next start()
+        work_available = new Semaphore();
+    }
+
+    freeRetired();
+}
+
+void BackgroundCompute::request(int task)
+{
+    jassert(isPositiveAndBelow(task, tasks.size()));
+
+    if (! requested[task].exchange(true, std::memory_order_acq_rel)) {
+        work_available->signal();
+    }
+}
+
+bool BackgroundCompute::retire(void* object, void (*destroy)(void*))
+{
+    const int write = retired_write.load(std::memory_order_relaxed);
+    const int next = (write + 1) % retireCapacity;
+
+    if (next == retired_read.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    retired[write].object = object;
+    retired[write].destroy = destroy;
+    retired_write.store(next, std::memory_order_release);
+
+    work_available->signal();
+    return true;
+}
+
+void BackgroundCompute::runRequestedTasks()
+{
+    for (int i = 0; i < tasks.size(); ++i) {
+        // Clear the flag first, so a request while the task runs runs it again
+        if (requested[i].exchange(false, std::memory_order_acq_rel)) {
+            tasks.getReference(i)();
+        }
+    }
+}
+
+void BackgroundCompute::freeRetired()
+{
+    int read = retired_read.load(std::memory_order_relaxed);
+
+    while (read != retired_write.load(std::memory_order_acquire)) {
+        retired[read].destroy(retired[read].object);
+        read = (read + 1) % retireCapacity;
+        retired_read.store(read, std::memory_order_release);
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef BACKGROUNDCOMPUTE_H_INCLUDED
+#define BACKGROUNDCOMPUTE_H_INCLUDED
+
+#include <atomic>
+#include <functional>
+
+class Semaphore;
+
+/**
+    Runs heavy recomputation, e.g. designing FIR filters, building FFT windows
+    or resampling impulse responses, on a background thread instead of the
+    thread that changed a parameter.
+
+    The processor adds tasks from its constructor with addTask() and requests
+    them from any thread with request(), including from parameter callbacks on
+    the audio thread. A request only sets a flag and signals a semaphore, so it
+    never locks or allocates. Requests made before a task gets to run are
+    merged, so it runs once with the latest parameter values:
+
+    @code
+    firTask = backgroundCompute.addTask ([this] { myFir.publish (new FirDesign (cutoff->getActualValue())); });
+    auto cutoffCallback = [this] (float) { backgroundCompute.request (firTask); };
+    @endcode
+
+    Tasks usually build a new state and hand it to the audio thread with
+    DspState::publish(). The thread also frees the states the audio thread is
+    done with, which it hands back with retire(), so the audio thread never
+    frees memory.
+ */
+class BackgroundCompute {
+public:
+    /// A task, which may allocate and take as long as it needs.
+    typedef std::function<void()> Task;
+
+    /// The largest number of tasks.
+    static const int maximumTasks = 32;
+
+    /// The number of objects that can wait to be freed.
+    static const int retireCapacity = 64;
+
+    BackgroundCompute();
+    ~BackgroundCompute();
+
+    /// Adds a task and returns its index for request(). Call this from the
+    /// constructor of the processor.
+    int addTask(const Task& task);
+
+    /// Runs the tasks requested so far on the calling thread, so states are
+    /// ready for the first block, then starts the thread. Call this from
+    /// prepareToPlay().
+    void start();
+
+    /// Stops the thread and frees everything retired. Call this from
+    /// releaseResources() and the destructor of the processor.
+    void stop();
+
+    /// Requests a task to run on the thread. Safe to call from any thread,
+    /// including the audio thread.
+    void request(int task);
+
+    /** Hands an object to the thread to free with destroy(object). Returns
+        false if too many objects are waiting, in which case try again in a
+        later block.
+
+        Only call this from one thread, the audio thread.
+     */
+    bool retire(void* object, void (*destroy)(void*));
+
+private:
+    class Worker;
+
+    /// An object waiting to be freed.
+    struct Retired {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    /// Runs every requested task once, on the calling thread.
+    void runRequestedTasks();
+
+    /// Frees every retired object, on the calling thread.
+    void freeRetired();
+
+    Array<Task> tasks;
+
+    /// Set for each task requested since it last started.
+    std::atomic<bool> requested[maximumTasks];
+
+    /// A ring of retired objects, written by the audio thread and read by the
+    /// thread.
+    Retired retired[retireCapacity];
+    std::atomic<int> retired_write;
+    std::atomic<int> retired_read;
+
+    ScopedPointer<Worker> worker;
+
+    /// Signalled by request() and retire().
+    ScopedPointer<Semaphore> work_available;
+
+    JUCE_DECLARE_NON_COPYABLE(BackgroundCompute)
+};
+
+
+#endif  // BACKGROUNDCOMPUTE_H_INCLUDED
@@ -0,0 +1,162 @@
+#ifndef CHANNELDISPATCHER_H_INCLUDED
+#define CHANNELDISPATCHER_H_INCLUDED
+
+/**
+    Runs a DSP kernel over every channel of a buffer, whatever the bus layout.
+
+    The kernel is written once and processes interleaved frames of a compile-time
+    number of lanes, where each lane is one channel. BlockSize is the number of
+    frames when it is known at compile time, or 0 otherwise:
+
+    @code
+    struct MyKernel
+    {
+        template <int Lanes, int BlockSize, typename FloatType>
+        void processLanes (FloatType* frames, int numFrames, int firstChannel)
+        {
+            const int n = BlockSize > 0 ? BlockSize : numFrames;
+
+            for (int i = 0; i < n; ++i)
+                for (int lane = 0; lane < Lanes; ++lane)
+                    frames[i * Lanes + lane] *= gain[firstChannel + lane];
+        }
+
+        float gain[maxChannels];
+    };
+    @endcode
+
+    Keeping per channel state in arrays indexed by `firstChannel + lane` lets the
+    compiler turn the inner loop into SIMD operations across channels. Layouts
+    with many channels, e.g. 7.1 or 7.1.4 beds, are packed into groups of
+    getMaximumLanes() channels, so 8 channels fit in one AVX register. Channels
+    that do not fill a group, and mono or stereo layouts, run with one lane per
+    channel directly on the buffer, where packing would cost more than it saves.
+
+    FloatType is float or double, whichever precision the buffer has, so the same
+    kernel serves both processBlock() overloads.
+
+    Kernels that only need a channel at a time can use processChannels() instead,
+    which calls `processChannel (FloatType* samples, int numSamples, int channel)`.
+ */
+class ChannelDispatcher {
+public:
+    /// The number of channels packed into one group. AVX builds use 8 lanes,
+    /// other builds 4 lanes, which matches the SSE and NEON register widths.
+   #if defined(__AVX__)
+    static const int maximumLanes = 8;
+   #else
+    static const int maximumLanes = 4;
+   #endif
+
+    /// The smallest group worth packing. Fewer channels are processed one lane
+    /// at a time.
+    static const int minimumLanes = 4;
+
+    ChannelDispatcher()
+    : frame_capacity(0),
+    sample_size(0)
+    {
+    }
+
+    /// Allocates the interleaving buffer for float samples, or double samples
+    /// if doublePrecision is true. Call this from prepareToPlay(). Longer blocks
+    /// are still processed correctly, in chunks of maximumBlockSize.
+    void prepare(int maximumBlockSize, bool doublePrecision = false)
+    {
+        frame_capacity = jmax(1, maximumBlockSize);
+        sample_size = doublePrecision ? (int) sizeof(double) : (int) sizeof(float);
+        frames.malloc((size_t) frame_capacity * maximumLanes * (size_t) sample_size);
+    }
+
+    /// Returns the number of lanes of the widest group.
+    static int getMaximumLanes()
+    {
+        return maximumLanes;
+    }
+
+    /// Runs kernel.processChannel() on each channel in turn.
+    template <typename Kernel, typename FloatType>
+    void processChannels(Kernel& kernel, AudioBuffer<FloatType>& buffer,
+                         int startSample, int numSamples, int numChannels)
+    {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            kernel.processChannel(buffer.getWritePointer(channel, startSample),
+                                  numSamples, channel);
+        }
+    }
+
+    /// Runs kernel.processLanes() over all channels, packing groups of channels
+    /// into interleaved frames where the layout is wide enough. If BlockSize is
+    /// not 0 it must equal numSamples.
+    template <int BlockSize = 0, typename Kernel, typename FloatType>
+    void processLanes(Kernel& kernel, AudioBuffer<FloatType>& buffer,
+                      int startSample, int numSamples, int numChannels)
+    {
+        jassert(frame_capacity > 0 && (int) sizeof(FloatType) <= sample_size);
+        jassert(BlockSize == 0 || (BlockSize == numSamples && BlockSize <= frame_capacity));
+
+        int channel = 0;
+
+        while (numChannels - channel >= maximumLanes) {
+            processGroup<maximumLanes, BlockSize>(kernel, buffer, startSample, numSamples, channel);
+            channel += maximumLanes;
+        }
+
+        if (maximumLanes > minimumLanes && numChannels - channel >= minimumLanes) {
+            processGroup<minimumLanes, BlockSize>(kernel, buffer, startSample, numSamples, channel);
+            channel += minimumLanes;
+        }
+
+        for (; channel < numChannels; ++channel) {
+            kernel.template processLanes<1, BlockSize>(buffer.getWritePointer(channel, startSample),
+                                            numSamples, channel);
+        }
+    }
+
+private:
+    /// Interleaves a group of channels, processes them and writes them back.
+    template <int Lanes, int BlockSize, typename Kernel, typename FloatType>
+    void processGroup(Kernel& kernel, AudioBuffer<FloatType>& buffer,
+                      int startSample, int numSamples, int firstChannel)
+    {
+        FloatType* channels[Lanes];
+        FloatType* const interleaved = reinterpret_cast<FloatType*>(frames.getData());
+
+        for (int offset = 0; offset < numSamples; offset += frame_capacity) {
+            const int numFrames = jmin(frame_capacity, numSamples - offset);
+
+            for (int lane = 0; lane < Lanes; ++lane) {
+                channels[lane] = buffer.getWritePointer(firstChannel + lane, startSample + offset);
+            }
+
+            for (int i = 0; i < numFrames; ++i) {
+                for (int lane = 0; lane < Lanes; ++lane) {
+                    interleaved[i * Lanes + lane] = channels[lane][i];
+                }
+            }
+
+            kernel.template processLanes<Lanes, BlockSize>(interleaved, numFrames, firstChannel);
+
+            for (int i = 0; i < numFrames; ++i) {
+                for (int lane = 0; lane < Lanes; ++lane) {
+                    channels[lane][i] = interleaved[i * Lanes + lane];
+                }
+            }
+        }
+    }
+
+    /// The interleaving buffer, holding frame_capacity frames of the widest group
+    /// in the precision it was prepared for.
+    HeapBlock<char> frames;
+
+    /// The number of frames that fit in the interleaving buffer.
+    int frame_capacity;
+
+    /// The size of the samples the interleaving buffer was prepared for.
+    int sample_size;
+
+    JUCE_DECLARE_NON_COPYABLE(ChannelDispatcher)
+};
+
+
+#endif  // CHANNELDISPATCHER_H_INCLUDED
@@ -0,0 +1,691 @@
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Convolver.h"
+#include "RealtimeSafety.h"
+#include "Semaphore.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+#endif
+
+namespace {
+    /// The number of kernels, see Convolver.
+    const int numKernels = 3;
+
+    /// The priority of the background thread. Its deadlines are a whole block
+    /// of a level away, so it stays below the workers of WorkerPool.
+    const int backgroundPriority = 8;
+
+    /// Tells the CPU the thread is spinning.
+    inline void pause()
+    {
+       #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        _mm_pause();
+       #elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+       #endif
+    }
+
+    /// Copies samples, converting them if the precisions differ.
+    template <typename Destination, typename Source>
+    void copySamples(Destination* destination, const Source* source, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i) {
+            destination[i] = (Destination) source[i];
+        }
+    }
+
+    void copySamples(float* destination, const float* source, int numSamples)
+    {
+        std::memcpy(destination, source, sizeof(float) * (size_t) numSamples);
+    }
+
+    int getOrder(int size)
+    {
+        int order = 0;
+        while ((1 << order) < size) {
+            ++order;
+        }
+        return order;
+    }
+}
+
+//==============================================================================
+/// The thread computing the levels after the first, whenever the audio thread
+/// has queued a block of them.
+class Convolver::Background : public Thread {
+public:
+    explicit Background(Convolver& c)
+    : Thread("Convolver"),
+    convolver(c)
+    {
+    }
+
+    void run() override
+    {
+        // Levels are part of processBlock(), so they are checked like it
+        const RealtimeSafety::ScopedRealtime realtime;
+
+        for (;;) {
+            convolver.work_available->wait();
+
+            if (threadShouldExit()) {
+                break;
+            }
+
+            // Smaller levels have the closer deadlines
+            for (int i = 1; i < convolver.levels.size(); ++i) {
+                Level& level = *convolver.levels[i];
+
+                int expected = Level::queued;
+                if (level.state.compare_exchange_strong(expected, Level::running, std::memory_order_acquire)) {
+                    convolver.computeLevelBlock(level);
+                    level.state.store(Level::done, std::memory_order_release);
+                }
+            }
+        }
+    }
+
+private:
+    Convolver& convolver;
+    JUCE_DECLARE_NON_COPYABLE(Background)
+};
+
+//==============================================================================
+Convolver::Convolver()
+: num_channels(0),
+maximum_length(0),
+kernel_channel_size(0),
+active(nullptr),
+retiring(nullptr),
+pending(-1),
+fades_outstanding(0),
+head_previous(nullptr),
+head_fading(false),
+history_mask(0),
+position(0),
+late_blocks(0),
+prepared(false),
+work_available(new Semaphore())
+{
+}
+
+Convolver::~Convolver()
+{
+    release();
+}
+
+void Convolver::prepare(int numChannels, int maximumImpulseLength, bool useBackgroundThread)
+{
+    const ScopedLock lock(loader_lock);
+    release();
+
+    num_channels = jmax(1, numChannels);
+    maximum_length = jmax(1, maximumImpulseLength);
+
+    // Lay out levels until they cover the longest impulse response. Each ends
+    // where the next one can start, at twice its partition size
+    levels.clear();
+    kernel_channel_size = headSize;
+
+    int size = headSize;
+    int offset = headSize;
+
+    while (offset < maximum_length && levels.size() < maximumLevels) {
+        const int nextSize = size * partitionGrowth;
+        const bool last = levels.size() + 1 == maximumLevels || maximum_length <= 2 * nextSize;
+        const int end = last ? maximum_length : 2 * nextSize;
+
+        Level* const level = levels.add(new Level());
+        level->index = levels.size() - 1;
+        level->size = size;
+        level->offset = offset;
+        level->num_partitions = (end - offset + size - 1) / size;
+        level->kernel_offset = kernel_channel_size;
+        level->delayed = level->index > 0;
+        level->fft = new RealFFT(getOrder(2 * size));
+
+        level->spectra.calloc((size_t) num_channels * (size_t) level->num_partitions * 2 * (size_t) size);
+        level->results.calloc((size_t) num_channels * 2 * (size_t) size);
+        level->input.calloc(2 * (size_t) size);
+        level->accumulated.calloc(2 * (size_t) size);
+        level->faded.calloc((size_t) size);
+
+        kernel_channel_size += level->num_partitions * 2 * size;
+
+        if (last) {
+            break;
+        }
+
+        size = nextSize;
+        offset = 2 * nextSize;
+    }
+
+    // The background thread reads two blocks of a level while the audio thread
+    // writes the next one
+    const int largestSize = levels.size() > 0 ? levels.getLast()->size : headSize;
+    const int historySize = nextPowerOfTwo(4 * largestSize);
+    history.calloc((size_t) num_channels * (size_t) historySize);
+    history_mask = historySize - 1;
+
+    head_history.calloc((size_t) num_channels * 2 * headSize);
+    segment.calloc(headSize);
+    segment_faded.calloc(headSize);
+
+    kernels.clear();
+    for (int i = 0; i < numKernels; ++i) {
+        kernels.add(new Kernel())->data.calloc((size_t) num_channels * (size_t) kernel_channel_size);
+    }
+
+    active = nullptr;
+    retiring = nullptr;
+    pending.store(-1);
+    fades_outstanding = 0;
+    head_previous = nullptr;
+    head_fading = false;
+
+    for (int i = 0; i < levels.size(); ++i) {
+        levels[i]->kernel = nullptr;
+        levels[i]->switch_pending = false;
+        levels[i]->job_fading = false;
+    }
+
+    late_blocks = 0;
+    prepared = true;
+    reset();
+
+    // Nothing is playing yet, so the last impulse response starts without a fade
+    if (impulse_response.getNumSamples() > 0) {
+        loadKernel(impulse_response, true);
+    }
+
+    if (useBackgroundThread && levels.size() > 1) {
+        background = new Background(*this);
+        background->startThread(backgroundPriority);
+    }
+}
+
+void Convolver::release()
+{
+    if (background != nullptr) {
+        background->signalThreadShouldExit();
+        work_available->signal();
+        background->stopThread(1000);
+        background = nullptr;
+    }
+
+    // Drop wake-ups the thread didn't take. Blocks it didn't get to are
+    // computed by the audio thread when it needs them
+    work_available = new Semaphore();
+}
+
+void Convolver::reset()
+{
+    // Take every level back from the background thread
+    for (int i = 0; i < levels.size(); ++i) {
+        Level& level = *levels[i];
+
+        int expected = Level::queued;
+        if (! level.state.compare_exchange_strong(expected, Level::running, std::memory_order_acquire)) {
+            while (level.state.load(std::memory_order_acquire) == Level::running) {
+                pause();
+            }
+        }
+        level.state.store(Level::idle, std::memory_order_relaxed);
+    }
+
+    // Finish a switch of kernels at once, as there is nothing to fade
+    if (fades_outstanding > 0) {
+        for (int i = 0; i < levels.size(); ++i) {
+            levels[i]->kernel = active;
+            levels[i]->switch_pending = false;
+            levels[i]->job_fading = false;
+        }
+
+        head_previous = nullptr;
+        head_fading = false;
+        fades_outstanding = 0;
+    }
+
+    if (retiring != nullptr) {
+        retiring->in_use.store(false, std::memory_order_release);
+        retiring = nullptr;
+    }
+
+    std::memset(head_history.getData(), 0, sizeof(float) * (size_t) num_channels * 2 * headSize);
+    std::memset(history.getData(), 0, sizeof(float) * (size_t) num_channels * (size_t) (history_mask + 1));
+
+    for (int i = 0; i < levels.size(); ++i) {
+        Level& level = *levels[i];
+        const size_t size = (size_t) level.size;
+
+        std::memset(level.spectra.getData(), 0, sizeof(float) * (size_t) num_channels * (size_t) level.num_partitions * 2 * size);
+        std::memset(level.results.getData(), 0, sizeof(float) * (size_t) num_channels * 2 * size);
+        level.newest = 0;
+        level.playing = 0;
+        level.silent = false;
+        level.skipped_blocks = 0;
+    }
+
+    position = 0;
+}
+
+bool Convolver::loadImpulseResponse(const AudioSampleBuffer& impulseResponse)
+{
+    const ScopedLock lock(loader_lock);
+
+    if (prepared && ! loadKernel(impulseResponse, false)) {
+        return false;
+    }
+
+    impulse_response.makeCopyOf(impulseResponse);
+    return true;
+}
+
+bool Convolver::loadKernel(const AudioSampleBuffer& impulseResponse, bool activate)
+{
+    int index = -1;
+    for (int i = 0; i < kernels.size() && index < 0; ++i) {
+        bool expected = false;
+        if (kernels.getUnchecked(i)->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            index = i;
+        }
+    }
+
+    if (index < 0) {
+        return false;
+    }
+
+    Kernel& kernel = *kernels[index];
+    fillKernel(kernel, impulseResponse);
+
+    if (activate) {
+        active = &kernel;
+        for (int i = 0; i < levels.size(); ++i) {
+            levels[i]->kernel = &kernel;
+        }
+        return true;
+    }
+
+    // A kernel the audio thread hasn't switched to yet is replaced
+    const int replaced = pending.exchange(index, std::memory_order_acq_rel);
+    if (replaced >= 0) {
+        kernels[replaced]->in_use.store(false, std::memory_order_release);
+    }
+
+    return true;
+}
+
+void Convolver::fillKernel(Kernel& kernel, const AudioSampleBuffer& impulseResponse)
+{
+    const int numSamples = jmin(impulseResponse.getNumSamples(), maximum_length);
+    const int numSourceChannels = impulseResponse.getNumChannels();
+
+    kernel.num_channels = jlimit(1, num_channels, numSourceChannels);
+    std::memset(kernel.data.getData(), 0, sizeof(float) * (size_t) kernel.num_channels * (size_t) kernel_channel_size);
+
+    for (int i = 0; i < levels.size(); ++i) {
+        const Level& level = *levels[i];
+        const int reached = (numSamples - level.offset + level.size - 1) / level.size;
+        kernel.num_partitions[i] = jlimit(0, level.num_partitions, reached);
+    }
+
+    if (numSourceChannels == 0) {
+        return;
+    }
+
+    for (int channel = 0; channel < kernel.num_channels; ++channel) {
+        const float* const source = impulseResponse.getReadPointer(channel);
+        float* const data = kernel.data + (size_t) channel * (size_t) kernel_channel_size;
+
+        std::memcpy(data, source, sizeof(float) * (size_t) jmin(numSamples, (int) headSize));
+    }
+
+    // Each partition is zero padded to twice its size, and scaled so the
+    // inverse transform of the product comes out at unity gain
+    for (int i = 0; i < levels.size(); ++i) {
+        const Level& level = *levels[i];
+        const int size = level.size;
+
+        RealFFT fft(getOrder(2 * size));
+        HeapBlock<float> padded(2 * (size_t) size);
+        const float scale = 1.f / (2 * size);
+
+        for (int channel = 0; channel < kernel.num_channels; ++channel) {
+            const float* const source = impulseResponse.getReadPointer(channel);
+            float* const data = kernel.data + (size_t) channel * (size_t) kernel_channel_size + level.kernel_offset;
+
+            for (int partition = 0; partition < kernel.num_partitions[i]; ++partition) {
+                const int start = level.offset + partition * size;
+                const int count = jmin(size, numSamples - start);
+
+                std::memset(padded.getData(), 0, sizeof(float) * 2 * (size_t) size);
+                std::memcpy(padded.getData(), source + start, sizeof(float) * (size_t) count);
+
+                float* const real = data + (size_t) partition * 2 * (size_t) size;
+                float* const imaginary = real + size;
+                fft.forward(padded, real, imaginary);
+
+                for (int bin = 0; bin < 2 * size; ++bin) {
+                    real[bin] *= scale;
+                }
+            }
+        }
+    }
+}
+
+void Convolver::process(float* const* channels, int numChannels, int numSamples)
+{
+    processSamples(channels, numChannels, numSamples);
+}
+
+void Convolver::process(double* const* channels, int numChannels, int numSamples)
+{
+    processSamples(channels, numChannels, numSamples);
+}
+
+template <typename FloatType>
+void Convolver::processSamples(FloatType* const* channels, int numChannels, int numSamples)
+{
+    numChannels = jmin(numChannels, num_channels);
+
+    // Audio is processed in segments that never cross a head block boundary,
+    // where the levels start and finish their blocks
+    int done = 0;
+    while (done < numSamples) {
+        const int offset = (int) (position & (headSize - 1));
+        const int count = jmin(numSamples - done, headSize - offset);
+
+        for (int channel = 0; channel < num_channels; ++channel) {
+            processSegment(channel, channel < numChannels ? channels[channel] + done : nullptr, offset, count);
+        }
+
+        position += count;
+        done += count;
+
+        if (offset + count == headSize) {
+            finishHeadBlock();
+        }
+    }
+}
+
+template <typename FloatType>
+void Convolver::processSegment(int channel, FloatType* samples, int offset, int numSamples)
+{
+    float* const headInput = head_history + (size_t) channel * 2 * headSize + headSize - 1 + offset;
+    float* const historyInput = history + (size_t) channel * (size_t) (history_mask + 1) + (position & history_mask);
+
+    // Channels the host didn't pass are silent, so none of their old input
+    // comes back around the history
+    if (samples == nullptr) {
+        std::memset(headInput, 0, sizeof(float) * (size_t) numSamples);
+        std::memset(historyInput, 0, sizeof(float) * (size_t) numSamples);
+        return;
+    }
+
+    copySamples(headInput, samples, numSamples);
+    std::memcpy(historyInput, headInput, sizeof(float) * (size_t) numSamples);
+
+    convolveHead(active, channel, headInput, segment, numSamples);
+
+    if (head_fading) {
+        convolveHead(head_previous, channel, headInput, segment_faded, numSamples);
+
+        for (int i = 0; i < numSamples; ++i) {
+            const float ramp = (float) (offset + i) * (1.f / headSize);
+            segment[i] = segment_faded[i] + ramp * (segment[i] - segment_faded[i]);
+        }
+    }
+
+    for (int i = 0; i < levels.size(); ++i) {
+        const Level& level = *levels[i];
+        if (level.silent) {
+            continue;
+        }
+
+        const float* const result = level.results + ((size_t) channel * 2 + (size_t) level.playing) * (size_t) level.size
+                                    + (position & (level.size - 1));
+
+        for (int j = 0; j < numSamples; ++j) {
+            segment[j] += result[j];
+        }
+    }
+
+    copySamples(samples, segment.getData(), numSamples);
+}
+
+void Convolver::convolveHead(const Kernel* kernel, int channel, const float* input, float* output, int numSamples) const
+{
+    std::memset(output, 0, sizeof(float) * (size_t) numSamples);
+
+    if (kernel == nullptr) {
+        return;
+    }
+
+    // One pass over the segment per tap, which vectorizes without reordering
+    // the sums
+    const float* const taps = kernel->data + (size_t) (channel % kernel->num_channels) * (size_t) kernel_channel_size;
+
+    for (int tap = 0; tap < headSize; ++tap) {
+        const float gain = taps[tap];
+        const float* const delayed = input - tap;
+
+        for (int i = 0; i < numSamples; ++i) {
+            output[i] += gain * delayed[i];
+        }
+    }
+}
+
+void Convolver::finishHeadBlock()
+{
+    // Keep the end of the block for the taps of the next one
+    for (int channel = 0; channel < num_channels; ++channel) {
+        float* const channelHistory = head_history + (size_t) channel * 2 * headSize;
+        std::memmove(channelHistory, channelHistory + headSize, sizeof(float) * (headSize - 1));
+    }
+
+    if (head_fading) {
+        head_fading = false;
+        head_previous = nullptr;
+        --fades_outstanding;
+    }
+
+    for (int i = 0; i < levels.size(); ++i) {
+        Level& level = *levels[i];
+
+        if ((position & (level.size - 1)) == 0 && finishLevelBlock(level)) {
+            startLevelBlock(level);
+        }
+    }
+
+    if (fades_outstanding > 0) {
+        return;
+    }
+
+    if (retiring != nullptr) {
+        retiring->in_use.store(false, std::memory_order_release);
+        retiring = nullptr;
+    }
+
+    if (pending.load(std::memory_order_relaxed) >= 0) {
+        const int index = pending.exchange(-1, std::memory_order_acq_rel);
+
+        if (index >= 0) {
+            retiring = active;
+            active = kernels[index];
+
+            head_previous = retiring;
+            head_fading = true;
+
+            for (int i = 0; i < levels.size(); ++i) {
+                levels[i]->switch_pending = true;
+            }
+
+            fades_outstanding = 1 + levels.size();
+        }
+    }
+}
+
+void Convolver::startLevelBlock(Level& level)
+{
+    level.job_fading = level.switch_pending;
+    level.job_previous = level.kernel;
+
+    if (level.switch_pending) {
+        level.kernel = active;
+        level.switch_pending = false;
+    }
+
+    level.job_kernel = level.kernel;
+    level.job_end = position;
+    level.job_result = level.delayed ? 1 - level.playing : 0;
+
+    if (level.delayed && background != nullptr) {
+        level.state.store(Level::queued, std::memory_order_release);
+        work_available->signal();
+        return;
+    }
+
+    computeLevelBlock(level);
+    level.state.store(Level::done, std::memory_order_relaxed);
+
+    // The first level plays the block it just computed
+    if (! level.delayed) {
+        finishLevelBlock(level);
+    }
+}
+
+bool Convolver::finishLevelBlock(Level& level)
+{
+    int expected = Level::queued;
+
+    if (level.state.compare_exchange_strong(expected, Level::running, std::memory_order_acquire)) {
+        // The background thread didn't get to it
+        computeLevelBlock(level);
+        ++late_blocks;
+    } else if (expected == Level::running) {
+        // Never wait for the background thread, which may not get the core
+        // while the audio thread spins. The level plays silence until it is
+        // back, and the block it should start now is skipped
+        ++late_blocks;
+        ++level.skipped_blocks;
+        level.silent = true;
+        return false;
+    } else if (expected == Level::idle) {
+        return true;
+    }
+
+    if (level.skipped_blocks > 0) {
+        // The result is for a block that already played silent, and the next
+        // block has no result either. The input of the skipped blocks counts
+        // as silence, so the partitions stay aligned with their blocks
+        const size_t spectrumSize = 2 * (size_t) level.size;
+
+        for (; level.skipped_blocks > 0; --level.skipped_blocks) {
+            level.newest = (level.newest + 1) % level.num_partitions;
+
+            for (int channel = 0; channel < num_channels; ++channel) {
+                float* const spectrum = level.spectra + ((size_t) channel * (size_t) level.num_partitions + (size_t) level.newest) * spectrumSize;
+                std::memset(spectrum, 0, sizeof(float) * spectrumSize);
+            }
+        }
+    } else {
+        level.playing = level.job_result;
+        level.silent = false;
+    }
+
+    level.state.store(Level::idle, std::memory_order_relaxed);
+
+    if (level.job_fading) {
+        level.job_fading = false;
+        --fades_outstanding;
+    }
+    return true;
+}
+
+void Convolver::computeLevelBlock(Level& level)
+{
+    const int size = level.size;
+    const int historySize = history_mask + 1;
+    const size_t spectrumSize = 2 * (size_t) size;
+
+    level.newest = (level.newest + 1) % level.num_partitions;
+
+    // Overlap-save: transform the last two blocks of input and keep the second
+    // half of the inverse
+    const int start = (int) ((level.job_end - 2 * size) & history_mask);
+    const int first = jmin(2 * size, historySize - start);
+
+    float* const accumulatedReal = level.accumulated;
+    float* const accumulatedImaginary = level.accumulated + size;
+
+    for (int channel = 0; channel < num_channels; ++channel) {
+        const float* const channelHistory = history + (size_t) channel * (size_t) historySize;
+        std::memcpy(level.input.getData(), channelHistory + start, sizeof(float) * (size_t) first);
+        std::memcpy(level.input + first, channelHistory, sizeof(float) * (size_t) (2 * size - first));
+
+        const float* const channelSpectra = level.spectra + (size_t) channel * (size_t) level.num_partitions * spectrumSize;
+        float* const spectrum = level.spectra + ((size_t) channel * (size_t) level.num_partitions + (size_t) level.newest) * spectrumSize;
+        level.fft->forward(level.input, spectrum, spectrum + size);
+
+        float* const result = level.results + ((size_t) channel * 2 + (size_t) level.job_result) * (size_t) size;
+
+        if (level.job_fading) {
+            if (level.job_previous != nullptr) {
+                accumulate(level, *level.job_previous, channel % level.job_previous->num_channels, channelSpectra);
+                level.fft->inverse(accumulatedReal, accumulatedImaginary, level.input);
+                std::memcpy(level.faded.getData(), level.input + size, sizeof(float) * (size_t) size);
+            } else {
+                std::memset(level.faded.getData(), 0, sizeof(float) * (size_t) size);
+            }
+        }
+
+        if (level.job_kernel != nullptr) {
+            accumulate(level, *level.job_kernel, channel % level.job_kernel->num_channels, channelSpectra);
+            level.fft->inverse(accumulatedReal, accumulatedImaginary, level.input);
+            std::memcpy(result, level.input + size, sizeof(float) * (size_t) size);
+        } else {
+            std::memset(result, 0, sizeof(float) * (size_t) size);
+        }
+
+        if (level.job_fading) {
+            const float* const faded = level.faded;
+            for (int i = 0; i < size; ++i) {
+                const float ramp = (float) i / size;
+                result[i] = faded[i] + ramp * (result[i] - faded[i]);
+            }
+        }
+    }
+}
+
+void Convolver::accumulate(const Level& level, const Kernel& kernel, int kernelChannel, const float* channelSpectra)
+{
+    const int size = level.size;
+    const size_t spectrumSize = 2 * (size_t) size;
+
+    float* const real = level.accumulated;
+    float* const imaginary = level.accumulated + size;
+    std::memset(real, 0, sizeof(float) * spectrumSize);
+
+    const float* const kernelSpectra = kernel.data + (size_t) kernelChannel * (size_t) kernel_channel_size + level.kernel_offset;
+    const int numPartitions = kernel.num_partitions[level.index];
+
+    // Partition p of the kernel meets the input from p blocks ago
+    for (int partition = 0; partition < numPartitions; ++partition) {
+        const int slot = (level.newest - partition + level.num_partitions) % level.num_partitions;
+        const float* const inputReal = channelSpectra + (size_t) slot * spectrumSize;
+        const float* const inputImaginary = inputReal + size;
+        const float* const kernelReal = kernelSpectra + (size_t) partition * spectrumSize;
+        const float* const kernelImaginary = kernelReal + size;
+
+        // Bin 0 holds the real DC and Nyquist bins
+        real[0] += inputReal[0] * kernelReal[0];
+        imaginary[0] += inputImaginary[0] * kernelImaginary[0];
+
+        for (int bin = 1; bin < size; ++bin) {
+            real[bin] += inputReal[bin] * kernelReal[bin] - inputImaginary[bin] * kernelImaginary[bin];
+            imaginary[bin] += inputReal[bin] * kernelImaginary[bin] + inputImaginary[bin] * kernelReal[bin];
+        }
+    }
+}
@@ -0,0 +1,263 @@
+#ifndef CONVOLVER_H_INCLUDED
+#define CONVOLVER_H_INCLUDED
+
+#include <atomic>
+
+#include "RealFFT.h"
+
+class Semaphore;
+
+/**
+    Convolves audio with long impulse responses, e.g. of reverbs, with no
+    latency and a cost per sample that grows only with the log of their
+    length.
+
+    The impulse response is split into partitions that grow with the delay
+    they sit at:
+
+    - The first headSize samples are a direct FIR filter, so the output has no
+      latency whatever the host block size.
+    - The rest is covered by levels of uniform partitions, each partitionGrowth
+      times longer than the one before. Every level keeps the spectra of its
+      past input blocks and multiplies them with the spectra of its partitions,
+      so each level costs one transform in and one out per block of its size.
+      The first level starts right after the head and runs on the audio thread
+      as soon as a block of input is complete.
+    - Every other level starts at twice its partition size, so its output is
+      only needed one block after its input is complete. With a background
+      thread these levels are computed there in the meantime, so the long
+      transforms are spread out instead of landing on a single audio block.
+      If the thread hasn't started a level by its deadline, the audio thread
+      takes it over. If it is still computing it, the audio thread never waits:
+      the level plays silence until the thread is done, and the block counts
+      in getNumLateBlocks().
+
+    Call prepare() from prepareToPlay(), which allocates everything for
+    impulse responses of up to maximumImpulseLength samples, and process()
+    from the audio thread. process() replaces its input with the convolution,
+    so mix the dry signal in separately.
+
+    loadImpulseResponse() takes an impulse response with one channel per
+    channel, or fewer which are repeated, and transforms it on the calling
+    thread into one of three preallocated kernels. The audio thread switches to
+    it at the next head boundary without allocating, crossfading each part of
+    the response over one block of its size. The kernel it switched from is
+    freed for loading once every part has switched.
+ */
+class Convolver {
+public:
+    /// The length of the direct FIR head and of the first level's partitions.
+    static const int headSize = 64;
+
+    /// The ratio of the partition sizes of consecutive levels.
+    static const int partitionGrowth = 8;
+
+    /// The largest number of levels. The last level takes as many partitions
+    /// as the impulse response needs.
+    static const int maximumLevels = 5;
+
+    Convolver();
+    ~Convolver();
+
+    /** Allocates the convolution of numChannels channels with impulse
+        responses of up to maximumImpulseLength samples, and clears it. Longer
+        impulse responses are cut.
+
+        The levels after the first are computed on a background thread if
+        useBackgroundThread is true, which is started here. The impulse
+        response loaded last, if any, is loaded again right away. Call this
+        from prepareToPlay().
+     */
+    void prepare(int numChannels, int maximumImpulseLength, bool useBackgroundThread);
+
+    /// Stops the background thread. Call this from releaseResources().
+    void release();
+
+    /// Clears the input and output of every level. Only call this from the
+    /// audio thread, or while it isn't processing.
+    void reset();
+
+    /** Transforms an impulse response into a free kernel for the audio thread
+        to switch to. Call this from any thread other than the audio thread,
+        one thread at a time.
+
+        Returns false if no kernel is free, because switches are still fading,
+        in which case try again later. Before prepare() the impulse response is
+        only kept for it.
+     */
+    bool loadImpulseResponse(const AudioSampleBuffer& impulseResponse);
+
+    /// Replaces numSamples samples of each of numChannels channels with their
+    /// convolution. Channels beyond those prepared are left as they are.
+    void process(float* const* channels, int numChannels, int numSamples);
+
+    /// Convolves double precision channels, see above. The convolution itself
+    /// runs in float, so the samples are rounded to float on the way in.
+    void process(double* const* channels, int numChannels, int numSamples);
+
+    /// Returns the number of levels of partitions after the head.
+    int getNumLevels() const { return levels.size(); }
+
+    /// Returns how many times a level wasn't finished by the background thread
+    /// in time, so the audio thread had to compute it or the level went
+    /// silent for a block.
+    int getNumLateBlocks() const { return late_blocks; }
+
+private:
+    class Background;
+
+    /// The spectra of the partitions of an impulse response, and its head.
+    struct Kernel {
+        Kernel()
+        : num_channels(0),
+        in_use(false)
+        {
+        }
+
+        /// For each channel the head, then the partitions of each level with
+        /// the real parts of their bins followed by the imaginary parts.
+        HeapBlock<float> data;
+        int num_channels;
+
+        /// The number of partitions of each level the response reaches.
+        int num_partitions[maximumLevels];
+
+        /// Whether the kernel is loading, waiting or in use by the audio thread.
+        std::atomic<bool> in_use;
+    };
+
+    /// A level of uniform partitions, with the state of its computation.
+    struct Level {
+        enum JobState {
+            idle,
+            queued,
+            running,
+            done
+        };
+
+        Level()
+        : silent(false),
+        skipped_blocks(0),
+        state(idle)
+        {
+        }
+
+        int index;
+        int size;
+        int offset;
+        int num_partitions;
+
+        /// Where the partitions of the level start in a kernel channel.
+        int kernel_offset;
+
+        /// Whether the output of a block plays one block after its input.
+        bool delayed;
+
+        ScopedPointer<RealFFT> fft;
+
+        /// For each channel, the spectra of the last num_partitions blocks of
+        /// input, of which spectrum newest is the latest.
+        HeapBlock<float> spectra;
+        int newest;
+
+        /// For each channel, two blocks of output: the one playing and the one
+        /// being computed.
+        HeapBlock<float> results;
+        int playing;
+
+        /// Whether the level plays silence, because its block wasn't computed
+        /// in time, and the number of blocks it skipped while still busy.
+        bool silent;
+        int skipped_blocks;
+
+        /// Work buffers of a computation.
+        HeapBlock<float> input;
+        HeapBlock<float> accumulated;
+        HeapBlock<float> faded;
+
+        /// The kernel blocks are computed with, and whether the next block
+        /// switches to the active one.
+        const Kernel* kernel;
+        bool switch_pending;
+
+        /// The computation of a block: its end, the kernels and the result
+        /// buffer, owned by whichever thread set state to running.
+        std::atomic<int> state;
+        int64 job_end;
+        const Kernel* job_kernel;
+        const Kernel* job_previous;
+        bool job_fading;
+        int job_result;
+    };
+
+    bool loadKernel(const AudioSampleBuffer& impulseResponse, bool activate);
+    void fillKernel(Kernel& kernel, const AudioSampleBuffer& impulseResponse);
+
+    template <typename FloatType>
+    void processSamples(FloatType* const* channels, int numChannels, int numSamples);
+    template <typename FloatType>
+    void processSegment(int channel, FloatType* samples, int offset, int numSamples);
+    void convolveHead(const Kernel* kernel, int channel, const float* input, float* output, int numSamples) const;
+    void finishHeadBlock();
+    void startLevelBlock(Level& level);
+    bool finishLevelBlock(Level& level);
+    void computeLevelBlock(Level& level);
+    void accumulate(const Level& level, const Kernel& kernel, int kernelChannel, const float* channelSpectra);
+
+    int num_channels;
+    int maximum_length;
+
+    /// The offset of each channel in a kernel's data.
+    int kernel_channel_size;
+
+    OwnedArray<Level> levels;
+
+    /// Three kernels: the active one, the one it fades from and one to load.
+    OwnedArray<Kernel> kernels;
+
+    /// The kernel in use and the one being faded from, or nullptr.
+    Kernel* active;
+    Kernel* retiring;
+
+    /// The index of a loaded kernel waiting to be switched to, or -1.
+    std::atomic<int> pending;
+
+    /// The parts of the response, head and levels, still to fade to active.
+    int fades_outstanding;
+
+    /// The kernel the head fades from over the current head block.
+    const Kernel* head_previous;
+    bool head_fading;
+
+    /// For each channel the last headSize - 1 samples of the previous head
+    /// block followed by the current one.
+    HeapBlock<float> head_history;
+
+    /// For each channel a ring of the latest input, long enough for the
+    /// background thread to read a block while the next is written.
+    HeapBlock<float> history;
+    int history_mask;
+
+    /// Work buffers of a segment on the audio thread.
+    HeapBlock<float> segment;
+    HeapBlock<float> segment_faded;
+
+    /// The number of samples processed since prepare() or reset().
+    int64 position;
+
+    int late_blocks;
+
+    bool prepared;
+
+    /// The impulse response loaded last, loaded again by prepare().
+    AudioSampleBuffer impulse_response;
+    CriticalSection loader_lock;
+
+    ScopedPointer<Background> background;
+    ScopedPointer<Semaphore> work_available;
+
+    JUCE_DECLARE_NON_COPYABLE(Convolver)
+};
+
+
+#endif  // CONVOLVER_H_INCLUDED
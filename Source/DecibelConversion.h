@@ -0,0 +1,367 @@
+#ifndef DECIBELCONVERSION_H_INCLUDED
+#define DECIBELCONVERSION_H_INCLUDED
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define DECIBELCONVERSION_USE_SSE 1
+ #include <immintrin.h>
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+  #define DECIBELCONVERSION_TARGET_AVX2
+ #else
+  #define DECIBELCONVERSION_TARGET_AVX2 __attribute__((target("avx2,fma")))
+ #endif
+#else
+ #define DECIBELCONVERSION_USE_SSE 0
+#endif
+
+/**
+    Conversions between unit voltage (uV) and decibels (dB).
+
+    All audio samples are represented in unit voltage as a float in the range of
+    -1.0 to 1.0. Any value at or below 0.00001 uV, including negative values and
+    NaN, converts to the -100 dB floor. Do not output your samples in decibels.
+
+    The float versions use a polynomial approximation instead of log10 and pow.
+    The scalar functions and every block kernel use the same approximation, so
+    per sample and per block code agree to within the errors below.
+
+    - gainToDecibels: maximum absolute error of 2e-5 dB for results between
+      -100 dB and +100 dB, about the rounding error of a float holding them.
+    - decibelsToGain: maximum relative error of 1e-6 for inputs between -100 dB
+      and +100 dB, and 4e-6 between -758 dB and +764 dB. Inputs outside of that
+      range are clamped to it, and NaN to its bottom.
+
+    The block kernels use AVX2 or SSE2 when available, chosen once at runtime,
+    and fall back to scalar code on other architectures.
+ */
+struct DecibelConversion {
+    /// Converts numSamples values from uV to dB. The source and destination may
+    /// be the same.
+    static void gainToDecibels(const float* source, float* destination, int numSamples)
+    {
+        getKernels().toDecibels(source, destination, numSamples);
+    }
+
+    /// Converts numSamples values from dB to uV. The source and destination may
+    /// be the same.
+    static void decibelsToGain(const float* source, float* destination, int numSamples)
+    {
+        getKernels().toGain(source, destination, numSamples);
+    }
+
+    /// Returns the name of the instruction set used by the block kernels.
+    static const char* getInstructionSetName()
+    {
+        return getKernels().name;
+    }
+
+    /// The signature of a block kernel.
+    typedef void (*Kernel)(const float*, float*, int);
+
+    /// The block kernels of one instruction set.
+    struct Kernels {
+        Kernel toDecibels;
+        Kernel toGain;
+        const char* name;
+    };
+
+    /// Returns the block kernels of every instruction set this machine
+    /// supports, fastest first, and sets numKernels to their number. The first
+    /// are the ones used by gainToDecibels() and decibelsToGain(), the others
+    /// are only useful for comparing them, e.g. in benchmarks.
+    static const Kernels* getSupportedKernels(int& numKernels)
+    {
+        static const Kernels all[] = {
+           #if DECIBELCONVERSION_USE_SSE
+            { toDecibelsAVX2, toGainAVX2, "AVX2" },
+            { toDecibelsSSE2, toGainSSE2, "SSE2" },
+           #endif
+            { toDecibelsScalar, toGainScalar, "Scalar" }
+        };
+       #if DECIBELCONVERSION_USE_SSE
+        static const int first = hasAVX2() ? 0 : 1;
+       #else
+        static const int first = 0;
+       #endif
+
+        numKernels = numElementsInArray(all) - first;
+        return all + first;
+    }
+
+    // =======================================================
+    // Scalar approximations, used for block tails and platforms
+    // without SIMD
+    // =======================================================
+
+    /// Converts a single value from uV to dB.
+    static inline float toDecibels(float gain)
+    {
+        if (! (gain > floorGain)) {
+            return floorDecibels;
+        }
+
+        int32 bits;
+        std::memcpy(&bits, &gain, sizeof(bits));
+
+        int32 exponent = ((bits >> 23) & 0xff) - 127;
+        bits = (bits & 0x007fffff) | 0x3f800000;
+
+        float mantissa;
+        std::memcpy(&mantissa, &bits, sizeof(mantissa));
+
+        if (mantissa > sqrtTwo) {
+            mantissa *= 0.5f;
+            exponent += 1;
+        }
+
+        const float t = (mantissa - 1.f) / (mantissa + 1.f);
+        const float t2 = t * t;
+        const float logMantissa = t * (logC1 + t2 * (logC3 + t2 * (logC5 + t2 * logC7)));
+
+        return ((float) exponent * lnTwo + logMantissa) * decibelsPerNeper;
+    }
+
+    /// Converts a single value from dB to uV.
+    static inline float toGain(float decibels)
+    {
+        // Written so NaN clamps to the bottom like the kernels, as converting
+        // it to an integer is undefined
+        float y = decibels * log2PerDecibel;
+        y = y > -126.f ? (y > 127.f ? 127.f : y) : -126.f;
+
+        const float rounded = (float) (int32) (y + (y >= 0.f ? 0.5f : -0.5f));
+        const float f = (y - rounded) * lnTwo;
+        const float p = 1.f + f * (1.f + f * (expC2 + f * (expC3 + f * (expC4 + f * (expC5 + f * expC6)))));
+
+        const int32 scaleBits = ((int32) rounded + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &scaleBits, sizeof(scale));
+        return p * scale;
+    }
+
+private:
+    // Constants of the approximations
+    static constexpr float floorGain        = 0.00001f;
+    static constexpr float floorDecibels    = -100.f;
+    static constexpr float sqrtTwo          = 1.41421356f;
+    static constexpr float lnTwo            = 0.693147181f;
+    static constexpr float decibelsPerNeper = 8.68588964f;     // 20 / ln(10)
+    static constexpr float log2PerDecibel   = 0.166096405f;    // log2(10) / 20
+    static constexpr float logC1 = 2.f;
+    static constexpr float logC3 = 2.f / 3.f;
+    static constexpr float logC5 = 2.f / 5.f;
+    static constexpr float logC7 = 2.f / 7.f;
+    static constexpr float expC2 = 1.f / 2.f;
+    static constexpr float expC3 = 1.f / 6.f;
+    static constexpr float expC4 = 1.f / 24.f;
+    static constexpr float expC5 = 1.f / 120.f;
+    static constexpr float expC6 = 1.f / 720.f;
+
+    /// Returns the block kernels, detecting the instruction set on first use.
+    static const Kernels& getKernels()
+    {
+        int numKernels;
+        return *getSupportedKernels(numKernels);
+    }
+
+    static void toDecibelsScalar(const float* source, float* destination, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i) {
+            destination[i] = toDecibels(source[i]);
+        }
+    }
+
+    static void toGainScalar(const float* source, float* destination, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i) {
+            destination[i] = toGain(source[i]);
+        }
+    }
+
+   #if DECIBELCONVERSION_USE_SSE
+    /// Returns true if the CPU and operating system support AVX2 and FMA.
+    static bool hasAVX2()
+    {
+       #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        if (! (osxsave && fma) || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+       #else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+       #endif
+    }
+
+    static void toDecibelsSSE2(const float* source, float* destination, int numSamples)
+    {
+        const __m128 floorGainV = _mm_set1_ps(floorGain);
+        const __m128 floorDecibelsV = _mm_set1_ps(floorDecibels);
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 sqrtTwoV = _mm_set1_ps(sqrtTwo);
+        const __m128i mantissaMask = _mm_set1_epi32(0x007fffff);
+        const __m128i exponentOne = _mm_set1_epi32(0x3f800000);
+        const __m128i bias = _mm_set1_epi32(127);
+
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4) {
+            const __m128 x = _mm_loadu_ps(source + i);
+            const __m128 aboveFloor = _mm_cmpgt_ps(x, floorGainV);
+
+            const __m128i bits = _mm_castps_si128(_mm_max_ps(x, floorGainV));
+            __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(bits, 23), bias);
+            __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissaMask), exponentOne));
+
+            const __m128 large = _mm_cmpgt_ps(mantissa, sqrtTwoV);
+            mantissa = _mm_or_ps(_mm_and_ps(large, _mm_mul_ps(mantissa, half)), _mm_andnot_ps(large, mantissa));
+            exponent = _mm_sub_epi32(exponent, _mm_castps_si128(large));
+
+            const __m128 t = _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one));
+            const __m128 t2 = _mm_mul_ps(t, t);
+            __m128 p = _mm_add_ps(_mm_set1_ps(logC5), _mm_mul_ps(t2, _mm_set1_ps(logC7)));
+            p = _mm_add_ps(_mm_set1_ps(logC3), _mm_mul_ps(t2, p));
+            p = _mm_add_ps(_mm_set1_ps(logC1), _mm_mul_ps(t2, p));
+            p = _mm_mul_ps(t, p);
+
+            __m128 y = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(exponent), _mm_set1_ps(lnTwo)), p);
+            y = _mm_mul_ps(y, _mm_set1_ps(decibelsPerNeper));
+
+            _mm_storeu_ps(destination + i, _mm_or_ps(_mm_and_ps(aboveFloor, y),
+                                                     _mm_andnot_ps(aboveFloor, floorDecibelsV)));
+        }
+
+        toDecibelsScalar(source + i, destination + i, numSamples - i);
+    }
+
+    static void toGainSSE2(const float* source, float* destination, int numSamples)
+    {
+        const __m128 minimum = _mm_set1_ps(-126.f);
+        const __m128 maximum = _mm_set1_ps(127.f);
+        const __m128i bias = _mm_set1_epi32(127);
+
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4) {
+            __m128 y = _mm_mul_ps(_mm_loadu_ps(source + i), _mm_set1_ps(log2PerDecibel));
+            y = _mm_min_ps(_mm_max_ps(y, minimum), maximum);
+
+            const __m128i rounded = _mm_cvtps_epi32(y);
+            const __m128 f = _mm_mul_ps(_mm_sub_ps(y, _mm_cvtepi32_ps(rounded)), _mm_set1_ps(lnTwo));
+
+            __m128 p = _mm_add_ps(_mm_set1_ps(expC5), _mm_mul_ps(f, _mm_set1_ps(expC6)));
+            p = _mm_add_ps(_mm_set1_ps(expC4), _mm_mul_ps(f, p));
+            p = _mm_add_ps(_mm_set1_ps(expC3), _mm_mul_ps(f, p));
+            p = _mm_add_ps(_mm_set1_ps(expC2), _mm_mul_ps(f, p));
+            p = _mm_add_ps(_mm_set1_ps(1.f), _mm_mul_ps(f, p));
+            p = _mm_add_ps(_mm_set1_ps(1.f), _mm_mul_ps(f, p));
+
+            const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(rounded, bias), 23));
+            _mm_storeu_ps(destination + i, _mm_mul_ps(p, scale));
+        }
+
+        toGainScalar(source + i, destination + i, numSamples - i);
+    }
+
+    DECIBELCONVERSION_TARGET_AVX2
+    static void toDecibelsAVX2(const float* source, float* destination, int numSamples)
+    {
+        const __m256 floorGainV = _mm256_set1_ps(floorGain);
+        const __m256 floorDecibelsV = _mm256_set1_ps(floorDecibels);
+        const __m256 one = _mm256_set1_ps(1.f);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 sqrtTwoV = _mm256_set1_ps(sqrtTwo);
+        const __m256i mantissaMask = _mm256_set1_epi32(0x007fffff);
+        const __m256i exponentOne = _mm256_set1_epi32(0x3f800000);
+        const __m256i bias = _mm256_set1_epi32(127);
+
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8) {
+            const __m256 x = _mm256_loadu_ps(source + i);
+            const __m256 aboveFloor = _mm256_cmp_ps(x, floorGainV, _CMP_GT_OQ);
+
+            const __m256i bits = _mm256_castps_si256(_mm256_max_ps(x, floorGainV));
+            __m256i exponent = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), bias);
+            __m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, mantissaMask), exponentOne));
+
+            const __m256 large = _mm256_cmp_ps(mantissa, sqrtTwoV, _CMP_GT_OQ);
+            mantissa = _mm256_blendv_ps(mantissa, _mm256_mul_ps(mantissa, half), large);
+            exponent = _mm256_sub_epi32(exponent, _mm256_castps_si256(large));
+
+            const __m256 t = _mm256_div_ps(_mm256_sub_ps(mantissa, one), _mm256_add_ps(mantissa, one));
+            const __m256 t2 = _mm256_mul_ps(t, t);
+            __m256 p = _mm256_fmadd_ps(t2, _mm256_set1_ps(logC7), _mm256_set1_ps(logC5));
+            p = _mm256_fmadd_ps(t2, p, _mm256_set1_ps(logC3));
+            p = _mm256_fmadd_ps(t2, p, _mm256_set1_ps(logC1));
+            p = _mm256_mul_ps(t, p);
+
+            __m256 y = _mm256_fmadd_ps(_mm256_cvtepi32_ps(exponent), _mm256_set1_ps(lnTwo), p);
+            y = _mm256_mul_ps(y, _mm256_set1_ps(decibelsPerNeper));
+
+            _mm256_storeu_ps(destination + i, _mm256_blendv_ps(floorDecibelsV, y, aboveFloor));
+        }
+
+        toDecibelsScalar(source + i, destination + i, numSamples - i);
+    }
+
+    DECIBELCONVERSION_TARGET_AVX2
+    static void toGainAVX2(const float* source, float* destination, int numSamples)
+    {
+        const __m256 minimum = _mm256_set1_ps(-126.f);
+        const __m256 maximum = _mm256_set1_ps(127.f);
+        const __m256i bias = _mm256_set1_epi32(127);
+
+        int i = 0;
+        for (; i + 8 <= numSamples; i += 8) {
+            __m256 y = _mm256_mul_ps(_mm256_loadu_ps(source + i), _mm256_set1_ps(log2PerDecibel));
+            y = _mm256_min_ps(_mm256_max_ps(y, minimum), maximum);
+
+            const __m256i rounded = _mm256_cvtps_epi32(y);
+            const __m256 f = _mm256_mul_ps(_mm256_sub_ps(y, _mm256_cvtepi32_ps(rounded)), _mm256_set1_ps(lnTwo));
+
+            __m256 p = _mm256_fmadd_ps(f, _mm256_set1_ps(expC6), _mm256_set1_ps(expC5));
+            p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(expC4));
+            p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(expC3));
+            p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(expC2));
+            p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(1.f));
+            p = _mm256_fmadd_ps(f, p, _mm256_set1_ps(1.f));
+
+            const __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(rounded, bias), 23));
+            _mm256_storeu_ps(destination + i, _mm256_mul_ps(p, scale));
+        }
+
+        toGainScalar(source + i, destination + i, numSamples - i);
+    }
+   #endif
+};
+
+/** Helper Functions
+    
+    All audio samples are represented in unit voltage (uV) as a float in the
+    range of -1.0 to 1.0. To convert an audio sample into a decibel (dB) value
+    pass the sample into `dB(x)`. The returned output can be used for audio
+    analysis and dynamic procesing. To convert a decibel value back to unit
+    voltage for output, pass the value into `uV(x)`. Do not output your samples
+    in decibels.
+
+    It is important to keep track of when your values are in decibels or
+    unit voltage. Be sure to label your variables accordingly.
+ 
+    The float versions use the approximations of DecibelConversion, the double
+    versions use log10 and pow. When converting whole blocks, e.g. for metering,
+    use DecibelConversion::gainToDecibels() and decibelsToGain() instead.
+*/
+inline float  dB(float x)  { return DecibelConversion::toDecibels(x); }             // uV -> dB
+inline float  uV(float x)  { return DecibelConversion::toGain(x); }                 // dB -> uV
+inline double dB(double x) { return x > 0.00001 ? 20.0 * std::log10(x) : -100.0; }  // uV -> dB
+inline double uV(double x) { return std::pow(10.0, x / 20.0); }                     // dB -> uV
+
+
+#endif  // DECIBELCONVERSION_H_INCLUDED
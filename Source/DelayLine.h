@@ -0,0 +1,299 @@
+#ifndef DELAYLINE_H_INCLUDED
+#define DELAYLINE_H_INCLUDED
+
+#include <cmath>
+#include <cstring>
+
+/**
+    A multichannel delay line for lookahead, chorus, comb filters and reverbs.
+
+    Each channel is a ring buffer of a power of two size, so positions wrap with
+    a mask instead of a modulo. The buffer is mirrored: every sample is written
+    twice, one buffer size apart. Any run of samples starting inside the buffer
+    is therefore contiguous in memory, so reads are plain loops over pointers
+    that copy or vectorize without checking for the wrap.
+
+    Allocate the buffers from prepareToPlay() with prepare(). Then, for each
+    block:
+
+    1. write() the input of every channel.
+    2. read the delayed output of every channel, with any of the read functions.
+    3. advance() by the number of samples written.
+
+    A delay of d samples returns the input from d samples before the output
+    sample, so a delay of 0 returns the input just written. Fractional delays
+    are interpolated:
+
+    - readLinear(): linear interpolation, cheap but it dulls high frequencies.
+      Also available with one delay per sample, e.g. for modulated delays.
+    - readLagrange(): third order Lagrange interpolation, flatter up to higher
+      frequencies. The delay must be at least 1 sample.
+    - readAllpass(): first order all-pass interpolation, with a flat magnitude
+      response, for fixed delays inside feedback loops. It keeps state per
+      channel, so read each channel with it only once per block.
+
+    Constant delays read through contiguous pointers, so those loops vectorize.
+
+    Samples are float, or double if prepare() was asked for double precision.
+    Every write and read then takes samples of that type, so the same code
+    serves both processBlock() overloads.
+ */
+class DelayLine {
+public:
+    DelayLine()
+    : num_channels(0),
+    size(0),
+    mask(0),
+    maximum_delay(0),
+    maximum_block_size(0),
+    sample_size(sizeof(float)),
+    write_position(0)
+    {
+    }
+
+    /** Allocates numChannels buffers able to delay by up to maximumDelay
+        samples, written in blocks of up to maximumBlockSize samples, and
+        clears them. The samples are double if doublePrecision is true.
+
+        Only allocates if the buffers need to grow, so it is safe to call again
+        from every prepareToPlay().
+     */
+    void prepare(int numChannels, int maximumDelay, int maximumBlockSize, bool doublePrecision = false)
+    {
+        num_channels = jmax(1, numChannels);
+        maximum_delay = jmax(0, maximumDelay);
+        maximum_block_size = jmax(1, maximumBlockSize);
+        sample_size = doublePrecision ? sizeof(double) : sizeof(float);
+
+        // Room for the oldest sample read by Lagrange interpolation at the
+        // maximum delay, while the newest block is already written
+        size = nextPowerOfTwo(maximum_delay + maximum_block_size + 3);
+        mask = size - 1;
+
+        const size_t numBytes = (size_t) num_channels * 2 * (size_t) size * sample_size;
+        if (numBytes > allocated_bytes) {
+            buffer.malloc(numBytes);
+            allocated_bytes = numBytes;
+        }
+
+        if (num_channels > allocated_channels) {
+            allpass_states.malloc((size_t) num_channels);
+            allocated_channels = num_channels;
+        }
+
+        reset();
+    }
+
+    /// Clears the delayed samples and the interpolation state.
+    void reset()
+    {
+        std::memset(buffer.getData(), 0, sample_size * (size_t) num_channels * 2 * (size_t) size);
+        for (int channel = 0; channel < num_channels; ++channel) {
+            allpass_states[channel] = AllpassState();
+        }
+        write_position = 0;
+    }
+
+    /// Returns the number of channels.
+    int getNumChannels() const { return num_channels; }
+
+    /// Returns the largest delay in samples.
+    int getMaximumDelay() const { return maximum_delay; }
+
+    /// Writes numSamples samples of input to a channel, starting at the current
+    /// position.
+    template <typename FloatType>
+    void write(int channel, const FloatType* input, int numSamples)
+    {
+        jassert(isPositiveAndBelow(channel, num_channels) && numSamples <= maximum_block_size);
+
+        FloatType* const samples = getChannel<FloatType>(channel);
+        const int first = jmin(numSamples, size - write_position);
+        const int second = numSamples - first;
+
+        std::memcpy(samples + write_position, input, sizeof(FloatType) * (size_t) first);
+        std::memcpy(samples + write_position + size, input, sizeof(FloatType) * (size_t) first);
+        std::memcpy(samples, input + first, sizeof(FloatType) * (size_t) second);
+        std::memcpy(samples + size, input + first, sizeof(FloatType) * (size_t) second);
+    }
+
+    /// Moves the current position on by numSamples, after every channel of the
+    /// block was written and read.
+    void advance(int numSamples)
+    {
+        write_position = (write_position + numSamples) & mask;
+    }
+
+    /// Reads numSamples samples of a channel delayed by a whole number of
+    /// samples.
+    template <typename FloatType>
+    void read(int channel, FloatType* output, int numSamples, int delay) const
+    {
+        std::memcpy(output, getDelayed<FloatType>(channel, delay), sizeof(FloatType) * (size_t) numSamples);
+    }
+
+    /// Reads numSamples samples of a channel delayed by a fractional number of
+    /// samples, interpolated linearly.
+    template <typename FloatType>
+    void readLinear(int channel, FloatType* output, int numSamples, float delay) const
+    {
+        const int whole = (int) delay;
+        const FloatType fraction = (FloatType) (delay - (float) whole);
+        const FloatType* const newer = getDelayed<FloatType>(channel, whole);
+        const FloatType* const older = newer - 1;
+
+        for (int i = 0; i < numSamples; ++i) {
+            output[i] = newer[i] + fraction * (older[i] - newer[i]);
+        }
+    }
+
+    /// Reads numSamples samples of a channel, each delayed by its own number of
+    /// samples from delays, interpolated linearly.
+    template <typename FloatType>
+    void readLinear(int channel, FloatType* output, int numSamples, const float* delays) const
+    {
+        const FloatType* const samples = getChannel<FloatType>(channel);
+
+        for (int i = 0; i < numSamples; ++i) {
+            jassert(delays[i] >= 0.f && delays[i] <= (float) maximum_delay);
+
+            const int whole = (int) delays[i];
+            const FloatType fraction = (FloatType) (delays[i] - (float) whole);
+            const FloatType* const older = samples + ((write_position + i - whole - 1) & mask);
+            output[i] = older[1] + fraction * (older[0] - older[1]);
+        }
+    }
+
+    /// Reads numSamples samples of a channel delayed by a fractional number of
+    /// samples, with third order Lagrange interpolation. The delay must be at
+    /// least 1.
+    template <typename FloatType>
+    void readLagrange(int channel, FloatType* output, int numSamples, float delay) const
+    {
+        jassert(delay >= 1.f);
+
+        // Four taps delayed by whole to whole + 3 samples, so the delay d
+        // measured from the first tap is between 1 and 2, where the
+        // interpolation is most accurate
+        const int whole = (int) delay - 1;
+        const FloatType d = (FloatType) (delay - (float) whole);
+        const FloatType d1 = d - 1, d2 = d - 2, d3 = d - 3;
+
+        const FloatType h0 = -d1 * d2 * d3 / 6;
+        const FloatType h1 = d * d2 * d3 / 2;
+        const FloatType h2 = -d * d1 * d3 / 2;
+        const FloatType h3 = d * d1 * d2 / 6;
+
+        const FloatType* const x0 = getDelayed<FloatType>(channel, whole);
+        const FloatType* const x1 = x0 - 1;
+        const FloatType* const x2 = x0 - 2;
+        const FloatType* const x3 = x0 - 3;
+
+        for (int i = 0; i < numSamples; ++i) {
+            output[i] = h0 * x0[i] + h1 * x1[i] + h2 * x2[i] + h3 * x3[i];
+        }
+    }
+
+    /// Reads numSamples samples of a channel delayed by a fractional number of
+    /// samples, with first order all-pass interpolation. The delay must be at
+    /// least 1. Changing the delay resets the state of the channel, so keep it
+    /// fixed or change it rarely.
+    template <typename FloatType>
+    void readAllpass(int channel, FloatType* output, int numSamples, float delay)
+    {
+        jassert(delay >= 1.f);
+
+        AllpassState& state = allpass_states[channel];
+
+        // Keeping the fraction between 0.5 and 1.5 keeps the coefficient away
+        // from the pole near -1, where the filter rings
+        const int whole = (int) (delay - 0.5f);
+        const float fraction = delay - (float) whole;
+
+        if (fraction != state.fraction) {
+            state.fraction = fraction;
+            state.coefficient = (1.0 - fraction) / (1.0 + fraction);
+            state.previous = 0.0;
+        }
+
+        const FloatType* const newer = getDelayed<FloatType>(channel, whole);
+        const FloatType* const older = newer - 1;
+        const FloatType coefficient = (FloatType) state.coefficient;
+        FloatType previous = (FloatType) state.previous;
+
+        for (int i = 0; i < numSamples; ++i) {
+            previous = coefficient * (newer[i] - previous) + older[i];
+            output[i] = previous;
+        }
+
+        state.previous = previous;
+    }
+
+private:
+    /// The state of the all-pass interpolation of a channel, kept in double
+    /// precision so it serves samples of either type.
+    struct AllpassState {
+        AllpassState()
+        : fraction(-1.f),
+        coefficient(0.0),
+        previous(0.0)
+        {
+        }
+
+        float fraction;
+        double coefficient;
+        double previous;
+    };
+
+    template <typename FloatType>
+    FloatType* getChannel(int channel)
+    {
+        jassert(sizeof(FloatType) == sample_size);
+        return reinterpret_cast<FloatType*>(buffer.getData()) + (size_t) channel * 2 * (size_t) size;
+    }
+
+    template <typename FloatType>
+    const FloatType* getChannel(int channel) const
+    {
+        jassert(sizeof(FloatType) == sample_size);
+        return reinterpret_cast<const FloatType*>(buffer.getData()) + (size_t) channel * 2 * (size_t) size;
+    }
+
+    /// Returns the sample of a channel delay samples before the first sample
+    /// of the current block. The three samples before it and the block after
+    /// it are contiguous.
+    template <typename FloatType>
+    const FloatType* getDelayed(int channel, int delay) const
+    {
+        jassert(isPositiveAndBelow(channel, num_channels) && delay >= 0 && delay <= maximum_delay);
+        return getChannel<FloatType>(channel) + 3 + ((write_position - delay - 3) & mask);
+    }
+
+    /// The mirrored buffers of all channels, 2 * size samples each.
+    HeapBlock<char> buffer;
+    size_t allocated_bytes = 0;
+
+    int num_channels;
+
+    /// The size of each buffer, a power of two, and the mask that wraps it.
+    int size;
+    int mask;
+
+    int maximum_delay;
+    int maximum_block_size;
+
+    /// The size of a sample, of a float or a double.
+    size_t sample_size;
+
+    /// The position the next block is written to.
+    int write_position;
+
+    /// The all-pass interpolation state of each channel.
+    HeapBlock<AllpassState> allpass_states;
+    int allocated_channels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(DelayLine)
+};
+
+
+#endif  // DELAYLINE_H_INCLUDED
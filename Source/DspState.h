@@ -0,0 +1,209 @@
+#ifndef DSPSTATE_H_INCLUDED
+#define DSPSTATE_H_INCLUDED
+
+#include <atomic>
+
+#include "BackgroundCompute.h"
+
+/**
+    Hands immutable DSP states, e.g. FIR coefficients or a wavetable, built on
+    another thread to the audio thread, read-copy-update style.
+
+    A task of BackgroundCompute builds a complete new state and passes it to
+    publish(), which stores it with a single atomic pointer exchange. The
+    processor calls beginBlock() at the start of each block, which takes the
+    latest published state, and the DSP reads it with get() for the rest of
+    the block. A state is never changed once published, so the audio thread
+    reads it without locks.
+
+    The state switched from is handed to BackgroundCompute::retire() and freed
+    on its thread, so the audio thread never frees memory. States published
+    faster than the audio thread takes them are freed by the next publish().
+
+    With a fade length set, the previous state stays available with
+    getPrevious() after a switch. Process the block with both states and mix
+    them with crossfade(), which retires the previous state once the fade is
+    over. No other switch happens while a fade is running.
+
+    State can be any type, get() returns nullptr until the first one arrives.
+ */
+template <typename State>
+class DspState {
+public:
+    DspState()
+    : pending(nullptr),
+    compute(nullptr),
+    current(nullptr),
+    previous(nullptr),
+    retiring(nullptr),
+    fade_time(0.0),
+    fade_length(0),
+    fade_remaining(0)
+    {
+    }
+
+    /// Deletes every state. Stop the BackgroundCompute publishing states first.
+    ~DspState()
+    {
+        delete pending.exchange(nullptr);
+        delete current;
+        delete previous;
+        delete retiring;
+    }
+
+    /// Sets the length of the crossfade from the previous state to a new one,
+    /// 0 to switch instantly. Call this before prepare().
+    void setFadeLength(double seconds)
+    {
+        fade_time = jmax(0.0, seconds);
+    }
+
+    /// Sets the sample rate of the fade and the BackgroundCompute that frees
+    /// retired states. Call this from prepareToPlay().
+    void prepare(double sampleRate, BackgroundCompute& backgroundCompute)
+    {
+        compute = &backgroundCompute;
+        fade_length = (int) (fade_time * sampleRate);
+    }
+
+    /// Makes newState, which this takes ownership of, the state to switch to
+    /// at the start of the next block. Call this from any thread except the
+    /// audio thread, usually from a task of BackgroundCompute.
+    void publish(State* newState)
+    {
+        // A state replaced before the audio thread took it was never seen
+        // there, so it can be freed right here
+        delete pending.exchange(newState, std::memory_order_acq_rel);
+    }
+
+    /** Switches to the latest published state. Returns true if it did.
+
+        Only call this from the audio thread, at the start of a block.
+     */
+    bool beginBlock()
+    {
+        if (retiring != nullptr) {
+            if (! retire(retiring)) {
+                return false;
+            }
+            retiring = nullptr;
+        }
+
+        if (previous != nullptr) {
+            return false;
+        }
+
+        State* const next = pending.exchange(nullptr, std::memory_order_acq_rel);
+        if (next == nullptr) {
+            return false;
+        }
+
+        if (current != nullptr && fade_length > 0) {
+            previous = current;
+            fade_remaining = fade_length;
+        }
+        else if (current != nullptr && ! retire(current)) {
+            retiring = current;
+        }
+
+        current = next;
+        return true;
+    }
+
+    /// Returns the state to process with, or nullptr if none was published.
+    /// Only call this from the audio thread.
+    const State* get() const
+    {
+        return current;
+    }
+
+    /// Returns the state being faded from, or nullptr if no fade is running.
+    /// Only call this from the audio thread.
+    const State* getPrevious() const
+    {
+        return previous;
+    }
+
+    /// Returns true while a fade from the previous state is running.
+    bool isFading() const
+    {
+        return previous != nullptr;
+    }
+
+    /** Mixes a block processed with the previous state into the same block
+        processed with the current one, while a fade is running.
+
+        channels holds numSamples samples of numChannels channels processed
+        with get(), and is replaced by the mix, previousChannels the same
+        samples processed with getPrevious(). Call this for every block of a
+        fade, in order. Only call this from the audio thread.
+     */
+    template <typename FloatType>
+    void crossfade(FloatType* const* channels, const FloatType* const* previousChannels,
+                   int numChannels, int numSamples)
+    {
+        if (previous == nullptr) {
+            return;
+        }
+
+        const int numFaded = jmin(numSamples, fade_remaining);
+        const FloatType step = (FloatType) 1 / (FloatType) fade_length;
+        const FloatType start = (FloatType) (fade_length - fade_remaining) * step;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            FloatType* const samples = channels[channel];
+            const FloatType* const previousSamples = previousChannels[channel];
+
+            for (int i = 0; i < numFaded; ++i) {
+                const FloatType gain = start + step * (FloatType) (i + 1);
+                samples[i] = previousSamples[i] + gain * (samples[i] - previousSamples[i]);
+            }
+        }
+
+        fade_remaining -= numFaded;
+
+        if (fade_remaining == 0) {
+            if (! retire(previous)) {
+                retiring = previous;
+            }
+            previous = nullptr;
+        }
+    }
+
+private:
+    static void destroy(void* state)
+    {
+        delete static_cast<State*>(state);
+    }
+
+    /// Hands a state to the BackgroundCompute to free. Returns false if it
+    /// can't take it now.
+    bool retire(State* state)
+    {
+        return compute != nullptr && compute->retire(state, &destroy);
+    }
+
+    /// The latest published state not yet taken by the audio thread.
+    std::atomic<State*> pending;
+
+    /// Frees retired states.
+    BackgroundCompute* compute;
+
+    /// The states used by the audio thread, and one waiting to be retired
+    /// because the BackgroundCompute had no room for it.
+    State* current;
+    State* previous;
+    State* retiring;
+
+    /// The length of the fade in seconds and samples.
+    double fade_time;
+    int fade_length;
+
+    /// The number of samples left in the fade.
+    int fade_remaining;
+
+    JUCE_DECLARE_NON_COPYABLE(DspState)
+};
+
+
+#endif  // DSPSTATE_H_INCLUDED
@@ -0,0 +1,608 @@
+#ifndef FILTERBANK_H_INCLUDED
+#define FILTERBANK_H_INCLUDED
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define FILTERBANK_USE_SSE 1
+ #include <emmintrin.h>
+#else
+ #define FILTERBANK_USE_SSE 0
+#endif
+
+/**
+    Runs a cascade of second order filters over several channels at once, one
+    channel per SIMD lane.
+
+    A filter on its own is a serial chain: every output sample waits for the
+    previous one, so a scalar filter leaves most of the core idle. The bank
+    puts channels side by side in groups of four lanes instead. Each chunk of a
+    group is transposed so every sample time is one vector of four channels,
+    and each stage then runs over the chunk with its coefficients and state in
+    registers. Four channels cost about as much as one, so 8 or 16 channels
+    gain the most, while stereo fills half the lanes.
+
+    Two topologies are available, chosen with setTopology():
+
+    - biquad: transposed direct form II biquads with the cookbook designs.
+      Cheapest when coefficients are constant.
+    - stateVariable: topology-preserving transform state variable filters.
+      Their coefficients follow cutoff and Q smoothly, so they suit modulation.
+
+    Coefficients are computed by setStage(), which is meant to be called from
+    the callback of the PluginParameter it depends on, or once per sub-block
+    with PluginParameter::getSmoothedValue() while the parameter is smoothing.
+    The next call to process() then interpolates every coefficient linearly
+    from its old to its new value across the block, so changes don't zipper.
+    Blocks without changes skip the interpolation.
+
+    The bank runs in float, or in double when prepared for double precision,
+    with coefficients and state in double too and two SSE2 registers per group
+    of four channels. Allocate it from prepareToPlay() with prepare(). Every
+    other function is meant for the audio thread and never allocates.
+ */
+class FilterBank {
+public:
+    /// The structure of every stage.
+    enum Topology {
+        biquad,
+        stateVariable
+    };
+
+    /// The response of a stage.
+    enum Shape {
+        bypass,
+        lowPass,
+        highPass,
+        bandPass,               ///< 0 dB at the centre frequency
+        notch,
+        allPass,
+        bell,
+        lowShelf,
+        highShelf
+    };
+
+    /// The number of channels processed together.
+    static const int numLanes = 4;
+
+    /// The largest number of cascaded stages.
+    static const int maximumStages = 8;
+
+    FilterBank()
+    : topology(biquad),
+    sample_rate(44100.0),
+    num_channels(0),
+    num_groups(0),
+    num_stages(0),
+    ramping(false),
+    double_precision(false)
+    {
+    }
+
+    /// Sets the topology of every stage. Call this before prepare(), which
+    /// bypasses every stage.
+    void setTopology(Topology newTopology)
+    {
+        topology = newTopology;
+    }
+
+    /// Returns the topology of every stage.
+    Topology getTopology() const { return topology; }
+
+    /// Allocates numStages stages for numChannels channels, bypassed and
+    /// cleared, in double precision if doublePrecision is true, and frees
+    /// those of the other precision.
+    void prepare(double sampleRate, int numChannels, int numStages, bool doublePrecision = false)
+    {
+        sample_rate = sampleRate;
+        num_channels = jmax(1, numChannels);
+        num_groups = (num_channels + numLanes - 1) / numLanes;
+        num_stages = jlimit(1, (int) maximumStages, numStages);
+        double_precision = doublePrecision;
+
+        if (double_precision) {
+            double_stages.calloc((size_t) num_groups * (size_t) num_stages);
+            float_stages.free();
+        } else {
+            float_stages.calloc((size_t) num_groups * (size_t) num_stages);
+            double_stages.free();
+        }
+
+        for (int stage = 0; stage < num_stages; ++stage) {
+            setStage(stage, bypass, 1000.f);
+        }
+
+        if (double_precision) {
+            snapToTargets(double_stages);
+        } else {
+            snapToTargets(float_stages);
+        }
+
+        reset();
+    }
+
+    /// Clears the state of every stage.
+    void reset()
+    {
+        if (double_precision) {
+            clearStates(double_stages);
+        } else {
+            clearStates(float_stages);
+        }
+    }
+
+    /// Returns the number of channels.
+    int getNumChannels() const { return num_channels; }
+
+    /// Returns the number of cascaded stages.
+    int getNumStages() const { return num_stages; }
+
+    /** Sets the response of a stage of every channel, reached over the next
+        call to process().
+
+        frequency is in Hz, q the quality factor and gainDecibels the gain of
+        bell and shelf shapes.
+     */
+    void setStage(int stage, Shape shape, float frequency, float q = 0.70710678f, float gainDecibels = 0.f)
+    {
+        double coefficients[numCoefficients];
+        design(shape, frequency, q, gainDecibels, coefficients);
+
+        for (int channel = 0; channel < num_channels; ++channel) {
+            setTarget(stage, channel, coefficients);
+        }
+    }
+
+    /// Sets the response of a stage of one channel, see above.
+    void setStage(int stage, int channel, Shape shape, float frequency, float q = 0.70710678f, float gainDecibels = 0.f)
+    {
+        double coefficients[numCoefficients];
+        design(shape, frequency, q, gainDecibels, coefficients);
+        setTarget(stage, channel, coefficients);
+    }
+
+    /// Filters numSamples samples of each of numChannels channels in place.
+    /// Channels beyond those prepared are left as they are. FloatType must be
+    /// the precision prepared.
+    template <typename FloatType>
+    void process(FloatType* const* channels, int numChannels, int numSamples)
+    {
+        jassert(double_precision == (sizeof(FloatType) == sizeof(double)));
+
+        numChannels = jmin(numChannels, num_channels);
+
+        if (numSamples <= 0) {
+            return;
+        }
+
+        HeapBlock<Stage<FloatType>>& stages = getStages((FloatType*) nullptr);
+
+        const bool ramp = ramping;
+        if (ramp) {
+            startRamps(stages, numSamples);
+        }
+
+        FloatType work[chunkSize * numLanes];
+
+        for (int group = 0; group < num_groups; ++group) {
+            const int firstChannel = group * numLanes;
+            const int numGroupChannels = jmin((int) numLanes, numChannels - firstChannel);
+            Stage<FloatType>* const groupStages = stages + (size_t) group * (size_t) num_stages;
+
+            for (int start = 0; start < numSamples; start += chunkSize) {
+                const int count = jmin((int) chunkSize, numSamples - start);
+
+                // Transpose into one vector of the group's channels per sample
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    const FloatType* const input = lane < numGroupChannels ? channels[firstChannel + lane] + start : nullptr;
+                    for (int i = 0; i < count; ++i) {
+                        work[i * numLanes + lane] = input != nullptr ? input[i] : FloatType(0);
+                    }
+                }
+
+                for (int stage = 0; stage < num_stages; ++stage) {
+                    if (topology == biquad) {
+                        if (ramp) {
+                            runBiquad<true>(groupStages[stage], work, count);
+                        } else {
+                            runBiquad<false>(groupStages[stage], work, count);
+                        }
+                    } else {
+                        if (ramp) {
+                            runStateVariable<true>(groupStages[stage], work, count);
+                        } else {
+                            runStateVariable<false>(groupStages[stage], work, count);
+                        }
+                    }
+                }
+
+                for (int lane = 0; lane < numGroupChannels; ++lane) {
+                    FloatType* const output = channels[firstChannel + lane] + start;
+                    for (int i = 0; i < count; ++i) {
+                        output[i] = work[i * numLanes + lane];
+                    }
+                }
+            }
+        }
+
+        // Land exactly on the targets, whatever rounding the steps added up
+        if (ramp) {
+            snapToTargets(stages);
+        }
+    }
+
+private:
+    /// The samples of a group transposed at a time.
+    static const int chunkSize = 64;
+
+    /// The coefficients of a stage: b0, b1, b2, a1 and a2 of a biquad, or g, k,
+    /// m0, m1 and m2 of a state variable filter.
+    static const int numCoefficients = 5;
+
+    /// A stage of a group of channels, with every value per lane.
+    template <typename FloatType>
+    struct Stage {
+        FloatType current[numCoefficients][numLanes];
+        FloatType target[numCoefficients][numLanes];
+        FloatType step[numCoefficients][numLanes];
+        FloatType state[2][numLanes];
+    };
+
+   #if FILTERBANK_USE_SSE
+    /// Four lanes of floats.
+    struct FloatLanes {
+        __m128 v;
+
+        static FloatLanes load(const float* p) { FloatLanes l; l.v = _mm_loadu_ps(p); return l; }
+        void store(float* p) const { _mm_storeu_ps(p, v); }
+        static FloatLanes fill(float f) { FloatLanes l; l.v = _mm_set1_ps(f); return l; }
+
+        friend FloatLanes operator+(const FloatLanes& a, const FloatLanes& b) { FloatLanes l; l.v = _mm_add_ps(a.v, b.v); return l; }
+        friend FloatLanes operator-(const FloatLanes& a, const FloatLanes& b) { FloatLanes l; l.v = _mm_sub_ps(a.v, b.v); return l; }
+        friend FloatLanes operator*(const FloatLanes& a, const FloatLanes& b) { FloatLanes l; l.v = _mm_mul_ps(a.v, b.v); return l; }
+        friend FloatLanes operator/(const FloatLanes& a, const FloatLanes& b) { FloatLanes l; l.v = _mm_div_ps(a.v, b.v); return l; }
+
+        FloatLanes& operator+=(const FloatLanes& other) { return *this = *this + other; }
+    };
+
+    /// Four lanes of doubles, in two registers of two.
+    struct DoubleLanes {
+        __m128d lo, hi;
+
+        static DoubleLanes load(const double* p) { DoubleLanes l; l.lo = _mm_loadu_pd(p); l.hi = _mm_loadu_pd(p + 2); return l; }
+        void store(double* p) const { _mm_storeu_pd(p, lo); _mm_storeu_pd(p + 2, hi); }
+        static DoubleLanes fill(double d) { DoubleLanes l; l.lo = l.hi = _mm_set1_pd(d); return l; }
+
+        friend DoubleLanes operator+(const DoubleLanes& a, const DoubleLanes& b) { DoubleLanes l; l.lo = _mm_add_pd(a.lo, b.lo); l.hi = _mm_add_pd(a.hi, b.hi); return l; }
+        friend DoubleLanes operator-(const DoubleLanes& a, const DoubleLanes& b) { DoubleLanes l; l.lo = _mm_sub_pd(a.lo, b.lo); l.hi = _mm_sub_pd(a.hi, b.hi); return l; }
+        friend DoubleLanes operator*(const DoubleLanes& a, const DoubleLanes& b) { DoubleLanes l; l.lo = _mm_mul_pd(a.lo, b.lo); l.hi = _mm_mul_pd(a.hi, b.hi); return l; }
+        friend DoubleLanes operator/(const DoubleLanes& a, const DoubleLanes& b) { DoubleLanes l; l.lo = _mm_div_pd(a.lo, b.lo); l.hi = _mm_div_pd(a.hi, b.hi); return l; }
+
+        DoubleLanes& operator+=(const DoubleLanes& other) { return *this = *this + other; }
+    };
+   #else
+    /// Four lanes of FloatType, one after the other.
+    template <typename FloatType>
+    struct ScalarLanes {
+        FloatType v[numLanes];
+
+        static ScalarLanes load(const FloatType* p) { ScalarLanes l; for (int i = 0; i < numLanes; ++i) { l.v[i] = p[i]; } return l; }
+        void store(FloatType* p) const { for (int i = 0; i < numLanes; ++i) { p[i] = v[i]; } }
+        static ScalarLanes fill(FloatType f) { ScalarLanes l; for (int i = 0; i < numLanes; ++i) { l.v[i] = f; } return l; }
+
+        friend ScalarLanes operator+(const ScalarLanes& a, const ScalarLanes& b) { ScalarLanes l; for (int i = 0; i < numLanes; ++i) { l.v[i] = a.v[i] + b.v[i]; } return l; }
+        friend ScalarLanes operator-(const ScalarLanes& a, const ScalarLanes& b) { ScalarLanes l; for (int i = 0; i < numLanes; ++i) { l.v[i] = a.v[i] - b.v[i]; } return l; }
+        friend ScalarLanes operator*(const ScalarLanes& a, const ScalarLanes& b) { ScalarLanes l; for (int i = 0; i < numLanes; ++i) { l.v[i] = a.v[i] * b.v[i]; } return l; }
+        friend ScalarLanes operator/(const ScalarLanes& a, const ScalarLanes& b) { ScalarLanes l; for (int i = 0; i < numLanes; ++i) { l.v[i] = a.v[i] / b.v[i]; } return l; }
+
+        ScalarLanes& operator+=(const ScalarLanes& other) { return *this = *this + other; }
+    };
+
+    typedef ScalarLanes<float> FloatLanes;
+    typedef ScalarLanes<double> DoubleLanes;
+   #endif
+
+    /// Picks the lanes of a precision, only used in decltype.
+    static FloatLanes lanesOf(float);
+    static DoubleLanes lanesOf(double);
+
+    /// Runs a biquad stage over count transposed samples of work. Stable pairs
+    /// of a1 and a2 form a triangle, so the pairs in between two stable ones
+    /// are stable too and the coefficients can be interpolated directly.
+    template <bool Ramp, typename FloatType>
+    static void runBiquad(Stage<FloatType>& stage, FloatType* work, int count)
+    {
+        typedef decltype(lanesOf(FloatType())) Lanes;
+
+        Lanes b0 = Lanes::load(stage.current[0]);
+        Lanes b1 = Lanes::load(stage.current[1]);
+        Lanes b2 = Lanes::load(stage.current[2]);
+        Lanes a1 = Lanes::load(stage.current[3]);
+        Lanes a2 = Lanes::load(stage.current[4]);
+        Lanes s1 = Lanes::load(stage.state[0]);
+        Lanes s2 = Lanes::load(stage.state[1]);
+
+        const Lanes db0 = Lanes::load(stage.step[0]);
+        const Lanes db1 = Lanes::load(stage.step[1]);
+        const Lanes db2 = Lanes::load(stage.step[2]);
+        const Lanes da1 = Lanes::load(stage.step[3]);
+        const Lanes da2 = Lanes::load(stage.step[4]);
+
+        for (int i = 0; i < count; ++i) {
+            if (Ramp) {
+                b0 += db0;
+                b1 += db1;
+                b2 += db2;
+                a1 += da1;
+                a2 += da2;
+            }
+
+            const Lanes x = Lanes::load(work + i * numLanes);
+            const Lanes y = b0 * x + s1;
+            s1 = b1 * x - a1 * y + s2;
+            s2 = b2 * x - a2 * y;
+            y.store(work + i * numLanes);
+        }
+
+        if (Ramp) {
+            b0.store(stage.current[0]);
+            b1.store(stage.current[1]);
+            b2.store(stage.current[2]);
+            a1.store(stage.current[3]);
+            a2.store(stage.current[4]);
+        }
+
+        s1.store(stage.state[0]);
+        s2.store(stage.state[1]);
+    }
+
+    /// Runs a state variable stage over count transposed samples of work. The
+    /// gains a1 to a3 depend on g and k nonlinearly, so while ramping they are
+    /// derived again every sample instead of being interpolated.
+    template <bool Ramp, typename FloatType>
+    static void runStateVariable(Stage<FloatType>& stage, FloatType* work, int count)
+    {
+        typedef decltype(lanesOf(FloatType())) Lanes;
+
+        Lanes g = Lanes::load(stage.current[0]);
+        Lanes k = Lanes::load(stage.current[1]);
+        Lanes m0 = Lanes::load(stage.current[2]);
+        Lanes m1 = Lanes::load(stage.current[3]);
+        Lanes m2 = Lanes::load(stage.current[4]);
+        Lanes ic1 = Lanes::load(stage.state[0]);
+        Lanes ic2 = Lanes::load(stage.state[1]);
+
+        const Lanes dg = Lanes::load(stage.step[0]);
+        const Lanes dk = Lanes::load(stage.step[1]);
+        const Lanes dm0 = Lanes::load(stage.step[2]);
+        const Lanes dm1 = Lanes::load(stage.step[3]);
+        const Lanes dm2 = Lanes::load(stage.step[4]);
+
+        const Lanes one = Lanes::fill(FloatType(1));
+        const Lanes two = Lanes::fill(FloatType(2));
+
+        Lanes a1 = one / (one + g * (g + k));
+        Lanes a2 = g * a1;
+        Lanes a3 = g * a2;
+
+        for (int i = 0; i < count; ++i) {
+            if (Ramp) {
+                g += dg;
+                k += dk;
+                m0 += dm0;
+                m1 += dm1;
+                m2 += dm2;
+                a1 = one / (one + g * (g + k));
+                a2 = g * a1;
+                a3 = g * a2;
+            }
+
+            const Lanes x = Lanes::load(work + i * numLanes);
+            const Lanes v3 = x - ic2;
+            const Lanes v1 = a1 * ic1 + a2 * v3;
+            const Lanes v2 = ic2 + a2 * ic1 + a3 * v3;
+            ic1 = two * v1 - ic1;
+            ic2 = two * v2 - ic2;
+
+            const Lanes y = m0 * x + m1 * v1 + m2 * v2;
+            y.store(work + i * numLanes);
+        }
+
+        if (Ramp) {
+            g.store(stage.current[0]);
+            k.store(stage.current[1]);
+            m0.store(stage.current[2]);
+            m1.store(stage.current[3]);
+            m2.store(stage.current[4]);
+        }
+
+        ic1.store(stage.state[0]);
+        ic2.store(stage.state[1]);
+    }
+
+    /// Computes the coefficients of a stage for the current topology.
+    void design(Shape shape, float frequency, float q, float gainDecibels, double* coefficients) const
+    {
+        const double f = jlimit(1.0, 0.49 * sample_rate, (double) frequency);
+        const double Q = jmax(0.01, (double) q);
+        const double A = std::pow(10.0, gainDecibels / 40.0);
+
+        if (topology == stateVariable) {
+            double g = std::tan(double_Pi * f / sample_rate);
+            double k = 1.0 / Q;
+            double m0 = 0.0, m1 = 0.0, m2 = 0.0;
+
+            switch (shape) {
+                case bypass:    m0 = 1.0; break;
+                case lowPass:   m2 = 1.0; break;
+                case highPass:  m0 = 1.0; m1 = -k; m2 = -1.0; break;
+                case bandPass:  m1 = k; break;
+                case notch:     m0 = 1.0; m1 = -k; break;
+                case allPass:   m0 = 1.0; m1 = -2.0 * k; break;
+                case bell:      k = 1.0 / (Q * A); m0 = 1.0; m1 = k * (A * A - 1.0); break;
+                case lowShelf:  g /= std::sqrt(A); m0 = 1.0; m1 = k * (A - 1.0); m2 = A * A - 1.0; break;
+                case highShelf: g *= std::sqrt(A); m0 = A * A; m1 = k * (1.0 - A) * A; m2 = 1.0 - A * A; break;
+            }
+
+            coefficients[0] = g;
+            coefficients[1] = k;
+            coefficients[2] = m0;
+            coefficients[3] = m1;
+            coefficients[4] = m2;
+            return;
+        }
+
+        const double w = 2.0 * double_Pi * f / sample_rate;
+        const double cosine = std::cos(w);
+        const double alpha = std::sin(w) / (2.0 * Q);
+        const double shelf = 2.0 * std::sqrt(A) * alpha;
+
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+
+        switch (shape) {
+            case bypass:
+                break;
+            case lowPass:
+                b0 = b2 = (1.0 - cosine) / 2.0; b1 = 1.0 - cosine;
+                a0 = 1.0 + alpha; a1 = -2.0 * cosine; a2 = 1.0 - alpha;
+                break;
+            case highPass:
+                b0 = b2 = (1.0 + cosine) / 2.0; b1 = -(1.0 + cosine);
+                a0 = 1.0 + alpha; a1 = -2.0 * cosine; a2 = 1.0 - alpha;
+                break;
+            case bandPass:
+                b0 = alpha; b1 = 0.0; b2 = -alpha;
+                a0 = 1.0 + alpha; a1 = -2.0 * cosine; a2 = 1.0 - alpha;
+                break;
+            case notch:
+                b0 = b2 = 1.0; b1 = -2.0 * cosine;
+                a0 = 1.0 + alpha; a1 = -2.0 * cosine; a2 = 1.0 - alpha;
+                break;
+            case allPass:
+                b0 = 1.0 - alpha; b1 = -2.0 * cosine; b2 = 1.0 + alpha;
+                a0 = 1.0 + alpha; a1 = -2.0 * cosine; a2 = 1.0 - alpha;
+                break;
+            case bell:
+                b0 = 1.0 + alpha * A; b1 = -2.0 * cosine; b2 = 1.0 - alpha * A;
+                a0 = 1.0 + alpha / A; a1 = -2.0 * cosine; a2 = 1.0 - alpha / A;
+                break;
+            case lowShelf:
+                b0 = A * ((A + 1.0) - (A - 1.0) * cosine + shelf);
+                b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosine);
+                b2 = A * ((A + 1.0) - (A - 1.0) * cosine - shelf);
+                a0 = (A + 1.0) + (A - 1.0) * cosine + shelf;
+                a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosine);
+                a2 = (A + 1.0) + (A - 1.0) * cosine - shelf;
+                break;
+            case highShelf:
+                b0 = A * ((A + 1.0) + (A - 1.0) * cosine + shelf);
+                b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosine);
+                b2 = A * ((A + 1.0) + (A - 1.0) * cosine - shelf);
+                a0 = (A + 1.0) - (A - 1.0) * cosine + shelf;
+                a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosine);
+                a2 = (A + 1.0) - (A - 1.0) * cosine - shelf;
+                break;
+        }
+
+        coefficients[0] = b0 / a0;
+        coefficients[1] = b1 / a0;
+        coefficients[2] = b2 / a0;
+        coefficients[3] = a1 / a0;
+        coefficients[4] = a2 / a0;
+    }
+
+    void setTarget(int stage, int channel, const double* coefficients)
+    {
+        jassert(isPositiveAndBelow(stage, num_stages) && isPositiveAndBelow(channel, num_channels));
+
+        if (double_precision) {
+            setTarget(double_stages, stage, channel, coefficients);
+        } else {
+            setTarget(float_stages, stage, channel, coefficients);
+        }
+    }
+
+    /// Sets the targets of a stage of one channel, rounded to FloatType.
+    template <typename FloatType>
+    void setTarget(HeapBlock<Stage<FloatType>>& stages, int stage, int channel, const double* coefficients)
+    {
+        Stage<FloatType>& s = stages[(size_t) (channel / numLanes) * (size_t) num_stages + (size_t) stage];
+        const int lane = channel % numLanes;
+
+        for (int i = 0; i < numCoefficients; ++i) {
+            const FloatType coefficient = (FloatType) coefficients[i];
+            if (s.target[i][lane] != coefficient) {
+                s.target[i][lane] = coefficient;
+                ramping = true;
+            }
+        }
+    }
+
+    /// Sets the steps that take every coefficient to its target in numSamples.
+    template <typename FloatType>
+    void startRamps(HeapBlock<Stage<FloatType>>& stages, int numSamples)
+    {
+        const FloatType scale = FloatType(1) / numSamples;
+
+        for (int i = 0; i < num_groups * num_stages; ++i) {
+            Stage<FloatType>& s = stages[i];
+            for (int c = 0; c < numCoefficients; ++c) {
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    s.step[c][lane] = (s.target[c][lane] - s.current[c][lane]) * scale;
+                }
+            }
+        }
+    }
+
+    template <typename FloatType>
+    void snapToTargets(HeapBlock<Stage<FloatType>>& stages)
+    {
+        for (int i = 0; i < num_groups * num_stages; ++i) {
+            Stage<FloatType>& s = stages[i];
+            for (int c = 0; c < numCoefficients; ++c) {
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    s.current[c][lane] = s.target[c][lane];
+                    s.step[c][lane] = FloatType(0);
+                }
+            }
+        }
+
+        ramping = false;
+    }
+
+    template <typename FloatType>
+    void clearStates(HeapBlock<Stage<FloatType>>& stages)
+    {
+        for (int i = 0; i < num_groups * num_stages; ++i) {
+            for (int lane = 0; lane < numLanes; ++lane) {
+                stages[i].state[0][lane] = FloatType(0);
+                stages[i].state[1][lane] = FloatType(0);
+            }
+        }
+    }
+
+    HeapBlock<Stage<float>>& getStages(float*) { return float_stages; }
+    HeapBlock<Stage<double>>& getStages(double*) { return double_stages; }
+
+    Topology topology;
+    double sample_rate;
+
+    int num_channels;
+    int num_groups;
+    int num_stages;
+
+    /// The stages of every group, group by group, in the precision prepared.
+    HeapBlock<Stage<float>> float_stages;
+    HeapBlock<Stage<double>> double_stages;
+
+    /// Whether any target changed since the last process().
+    bool ramping;
+
+    /// Whether double_stages is in use rather than float_stages.
+    bool double_precision;
+
+    JUCE_DECLARE_NON_COPYABLE(FilterBank)
+};
+
+
+#endif  // FILTERBANK_H_INCLUDED
@@ -0,0 +1,123 @@
+#ifndef LATENCYREPORTER_H_INCLUDED
+#define LATENCYREPORTER_H_INCLUDED
+
+#include <atomic>
+
+/**
+    Adds up the latency of every stage of the DSP and reports the total to the
+    host when it changes.
+
+    Each stage that delays the output, e.g. oversampling filters or the
+    lookahead of a limiter, registers as a source with addSource() and sets its
+    latency in samples at the plugin's sample rate, from any thread.
+
+    The audio thread calls update() once per block, which rounds the total and
+    only notes a change. Telling the host with
+    AudioProcessor::setLatencySamples() calls host callbacks under a lock, so
+    that is left to report(), which a timer calls on the message thread. Call
+    report() directly where blocking is fine, e.g. in prepareToPlay().
+ */
+class LatencyReporter : private Timer {
+public:
+    /// The largest number of sources.
+    static const int maximumSources = 8;
+
+    /// How often the message thread checks for a change to report, in
+    /// milliseconds.
+    static const int reportInterval = 50;
+
+    explicit LatencyReporter(AudioProcessor& owner)
+    : processor(owner),
+    num_sources(0),
+    total(-1),
+    unreported(-1)
+    {
+        for (int i = 0; i < maximumSources; ++i) {
+            latencies[i].store(0.0, std::memory_order_relaxed);
+        }
+        startTimer(reportInterval);
+    }
+
+    /// Adds a source with no latency and returns its index. Call this from the
+    /// constructor of the processor.
+    int addSource()
+    {
+        jassert(num_sources < maximumSources);
+        return jmin(num_sources++, maximumSources - 1);
+    }
+
+    /// Sets the latency of a source in samples. Safe to call from any thread.
+    void setLatency(int source, double samples)
+    {
+        jassert(isPositiveAndBelow(source, num_sources));
+        latencies[source].store(jmax(0.0, samples), std::memory_order_relaxed);
+    }
+
+    /// Returns the latency of a source in samples.
+    double getLatency(int source) const
+    {
+        return latencies[source].load(std::memory_order_relaxed);
+    }
+
+    /// Returns the total latency of all sources, rounded to whole samples.
+    int getTotalLatency() const
+    {
+        double sum = 0.0;
+        for (int i = 0; i < num_sources; ++i) {
+            sum += latencies[i].load(std::memory_order_relaxed);
+        }
+        return roundToInt(sum);
+    }
+
+    /// Notes the total latency for report() if it changed since the last
+    /// call. Returns true if it did. This never locks, so call it once per
+    /// block from the audio thread.
+    bool update()
+    {
+        const int newTotal = getTotalLatency();
+        if (newTotal == total) {
+            return false;
+        }
+
+        total = newTotal;
+        unreported.store(newTotal, std::memory_order_release);
+        return true;
+    }
+
+    /// Tells the host the total noted by update(), if it wasn't reported yet.
+    /// Returns true if it did. Never call this from the audio thread.
+    bool report()
+    {
+        const int newTotal = unreported.exchange(-1, std::memory_order_acquire);
+        if (newTotal < 0) {
+            return false;
+        }
+
+        processor.setLatencySamples(newTotal);
+        return true;
+    }
+
+private:
+    void timerCallback() override
+    {
+        report();
+    }
+
+    /// The processor whose host is told the latency.
+    AudioProcessor& processor;
+
+    std::atomic<double> latencies[maximumSources];
+    int num_sources;
+
+    /// The total noted by the last update(), or -1 before the first. Only
+    /// used by the thread calling update().
+    int total;
+
+    /// The total to report, or -1 if it was reported.
+    std::atomic<int> unreported;
+
+    JUCE_DECLARE_NON_COPYABLE(LatencyReporter)
+};
+
+
+#endif  // LATENCYREPORTER_H_INCLUDED
@@ -0,0 +1,303 @@
+#ifndef LEVELMETER_H_INCLUDED
+#define LEVELMETER_H_INCLUDED
+
+#include <cmath>
+#include <cstring>
+
+#include "TripleBuffer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define LEVELMETER_USE_SSE 1
+ #include <emmintrin.h>
+#else
+ #define LEVELMETER_USE_SSE 0
+#endif
+
+/**
+    Measures the peak, RMS and true peak level of each channel on the audio
+    thread and hands them to the editor without locking.
+
+    The processor calls process() once per block. It makes a single SIMD pass
+    over each channel that finds the peak, the sum of squares and the true peak.
+    The editor calls read() from its timer to take the levels measured since its
+    previous call, so no peak is missed between timer callbacks.
+
+    Levels are published through a triple buffer. The audio thread always has a
+    slot of its own to write to, and the editor always has a slot of its own to
+    read from, so neither side ever waits for the other and the editor never
+    sees a partially written set of levels.
+
+    The true peak follows ITU-R BS.1770-4: the signal is oversampled by 4 with
+    the 48 tap polyphase interpolation filter of the recommendation, and the
+    true peak is the largest absolute value of the oversampled signal or of the
+    samples themselves.
+
+    Peak hold, release and RMS integration are left to the editor, see
+    MeterBallistics, so the audio thread only does the reduction.
+ */
+class LevelMeter {
+public:
+    /// The largest number of channels metered, enough for a 7.1.4 bed.
+    static const int maximumChannels = 16;
+
+    /// The levels measured since the editor last read them, as linear gains.
+    struct Levels {
+        /// The number of channels measured.
+        int numChannels;
+
+        /// The number of samples the levels were measured over.
+        int numSamples;
+
+        /// The largest absolute sample value of each channel.
+        float peak[maximumChannels];
+
+        /// The root mean square of each channel.
+        float rms[maximumChannels];
+
+        /// The largest absolute value of each channel oversampled by 4.
+        float truePeak[maximumChannels];
+    };
+
+    LevelMeter()
+    : maximum_samples(44100),
+    num_channels(0),
+    num_samples(0)
+    {
+        reset();
+    }
+
+    /// Sets the sample rate. Levels that the editor has not read within a second
+    /// are discarded. Call this from prepareToPlay().
+    void prepare(double sampleRate)
+    {
+        maximum_samples = jmax(1, roundToInt(sampleRate));
+        reset();
+    }
+
+    /// Clears the measurements and the oversampling filter history. Only call
+    /// this while the audio thread is not running process().
+    void reset()
+    {
+        std::memset(history, 0, sizeof(history));
+        clearMeasurements();
+    }
+
+    /// Measures the first numChannels channels of buffer and publishes the
+    /// levels. Double samples are measured in float, which is plenty for a
+    /// meter. Only call this from the audio thread.
+    template <typename FloatType>
+    void process(const AudioBuffer<FloatType>& buffer, int numChannels)
+    {
+        const int numSamples = buffer.getNumSamples();
+        numChannels = jmin(numChannels, buffer.getNumChannels(), (int) maximumChannels);
+
+        if (numSamples <= 0 || numChannels <= 0) {
+            return;
+        }
+
+        // Start over once the editor has taken the previous levels, or if nobody
+        // has read them for a while
+        if (! published.hasUnreadValue()
+            || num_samples >= maximum_samples || numChannels != num_channels) {
+            clearMeasurements();
+            num_channels = numChannels;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            measureChannel(buffer.getReadPointer(channel), numSamples, channel);
+        }
+
+        num_samples += numSamples;
+
+        Levels& levels = published.getWriteBuffer();
+        levels.numChannels = num_channels;
+        levels.numSamples = num_samples;
+
+        for (int channel = 0; channel < num_channels; ++channel) {
+            levels.peak[channel] = peak[channel];
+            levels.rms[channel] = (float) std::sqrt(sum_of_squares[channel] / num_samples);
+            levels.truePeak[channel] = true_peak[channel];
+        }
+
+        published.publish();
+    }
+
+    /// Copies the levels measured since the previous call to levels and returns
+    /// true, or returns false if nothing was measured since. Never blocks. Only
+    /// call this from the editor's thread.
+    bool read(Levels& levels)
+    {
+        return published.read(levels);
+    }
+
+private:
+    /// The number of taps of each phase of the true peak filter.
+    static const int truePeakTaps = 12;
+
+    /// The number of samples measured at a time, with the filter history in
+    /// front of them.
+    static const int chunkSize = 64;
+
+    void clearMeasurements()
+    {
+        num_samples = 0;
+
+        for (int channel = 0; channel < maximumChannels; ++channel) {
+            peak[channel] = 0.f;
+            sum_of_squares[channel] = 0.0;
+            true_peak[channel] = 0.f;
+        }
+    }
+
+    /// Finds the peak, sum of squares and true peak of a channel in one pass,
+    /// and adds them to the measurements.
+    template <typename FloatType>
+    void measureChannel(const FloatType* samples, int numSamples, int channel)
+    {
+        float window[truePeakTaps - 1 + chunkSize];
+        float* const channelHistory = history[channel];
+
+        float channelPeak = peak[channel];
+        float channelTruePeak = true_peak[channel];
+        double channelSum = sum_of_squares[channel];
+
+        std::memcpy(window, channelHistory, sizeof(float) * (truePeakTaps - 1));
+
+        for (int offset = 0; offset < numSamples; offset += chunkSize) {
+            const int n = jmin(chunkSize, numSamples - offset);
+            copyToWindow(window + truePeakTaps - 1, samples + offset, n);
+
+            float chunkSum = 0.f;
+            measureChunk(window, n, channelPeak, chunkSum, channelTruePeak);
+            channelSum += chunkSum;
+
+            std::memmove(window, window + n, sizeof(float) * (truePeakTaps - 1));
+        }
+
+        std::memcpy(channelHistory, window, sizeof(float) * (truePeakTaps - 1));
+
+        peak[channel] = channelPeak;
+        true_peak[channel] = jmax(channelTruePeak, channelPeak);
+        sum_of_squares[channel] = channelSum;
+    }
+
+    static void copyToWindow(float* window, const float* samples, int numSamples)
+    {
+        std::memcpy(window, samples, sizeof(float) * (size_t) numSamples);
+    }
+
+    static void copyToWindow(float* window, const double* samples, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i) {
+            window[i] = (float) samples[i];
+        }
+    }
+
+    /// Measures numSamples samples that follow truePeakTaps - 1 samples of
+    /// history in window.
+    static void measureChunk(const float* window, int numSamples,
+                             float& maximum, float& sumOfSquares, float& truePeak)
+    {
+        const float* const x = window + truePeakTaps - 1;
+        int i = 0;
+
+       #if LEVELMETER_USE_SSE
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 peak4 = _mm_set1_ps(maximum);
+        __m128 sum4 = _mm_setzero_ps();
+        __m128 truePeak4 = _mm_set1_ps(truePeak);
+
+        __m128 taps[truePeakTaps];
+        for (int k = 0; k < truePeakTaps; ++k) {
+            taps[k] = _mm_loadu_ps(getTruePeakCoefficients()[k]);
+        }
+
+        // The four phases of the filter are computed together, one per lane
+        for (; i < numSamples; ++i) {
+            __m128 phases = _mm_setzero_ps();
+            for (int k = 0; k < truePeakTaps; ++k) {
+                phases = _mm_add_ps(phases, _mm_mul_ps(taps[k], _mm_set1_ps(x[i - k])));
+            }
+            truePeak4 = _mm_max_ps(truePeak4, _mm_and_ps(phases, signMask));
+
+            if ((i & 3) == 3) {
+                const __m128 samples4 = _mm_loadu_ps(x + i - 3);
+                peak4 = _mm_max_ps(peak4, _mm_and_ps(samples4, signMask));
+                sum4 = _mm_add_ps(sum4, _mm_mul_ps(samples4, samples4));
+            }
+        }
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, peak4);
+        maximum = jmax(jmax(lanes[0], lanes[1]), jmax(lanes[2], lanes[3]));
+        _mm_storeu_ps(lanes, sum4);
+        sumOfSquares += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        _mm_storeu_ps(lanes, truePeak4);
+        truePeak = jmax(jmax(lanes[0], lanes[1]), jmax(lanes[2], lanes[3]));
+
+        // Samples that did not fill a vector of four
+        i = numSamples & ~3;
+       #else
+        for (int j = 0; j < numSamples; ++j) {
+            float phases[4] = {0.f, 0.f, 0.f, 0.f};
+            for (int k = 0; k < truePeakTaps; ++k) {
+                for (int phase = 0; phase < 4; ++phase) {
+                    phases[phase] += getTruePeakCoefficients()[k][phase] * x[j - k];
+                }
+            }
+            for (int phase = 0; phase < 4; ++phase) {
+                truePeak = jmax(truePeak, std::abs(phases[phase]));
+            }
+        }
+       #endif
+
+        for (; i < numSamples; ++i) {
+            maximum = jmax(maximum, std::abs(x[i]));
+            sumOfSquares += x[i] * x[i];
+        }
+    }
+
+    /// The interpolation filter of ITU-R BS.1770-4 Annex 2, indexed by tap and
+    /// then phase.
+    static const float (*getTruePeakCoefficients())[4]
+    {
+        static const float coefficients[truePeakTaps][4] = {
+            {  0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+            {  0.0109863281250f,  0.0292968750000f,  0.0330810546875f,  0.0148925781250f },
+            { -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+            {  0.0332031250000f,  0.0891113281250f,  0.1015625000000f,  0.0476074218750f },
+            { -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+            {  0.1373291015625f,  0.4650878906250f,  0.7797851562500f,  0.9721679687500f },
+            {  0.9721679687500f,  0.7797851562500f,  0.4650878906250f,  0.1373291015625f },
+            { -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+            {  0.0476074218750f,  0.1015625000000f,  0.0891113281250f,  0.0332031250000f },
+            { -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+            {  0.0148925781250f,  0.0330810546875f,  0.0292968750000f,  0.0109863281250f },
+            { -0.0083007812500f, -0.0189208984375f, -0.0291748046875f,  0.0017089843750f }
+        };
+        return coefficients;
+    }
+
+    /// The levels handed from process() to read().
+    TripleBuffer<Levels> published;
+
+    /// The measurements since the editor last read the levels.
+    float peak[maximumChannels];
+    double sum_of_squares[maximumChannels];
+    float true_peak[maximumChannels];
+
+    /// The last samples of each channel, for the true peak filter.
+    float history[maximumChannels][truePeakTaps - 1];
+
+    /// The number of samples after which unread levels are discarded.
+    int maximum_samples;
+
+    /// The number of channels and samples measured.
+    int num_channels;
+    int num_samples;
+
+    JUCE_DECLARE_NON_COPYABLE(LevelMeter)
+};
+
+
+#endif  // LEVELMETER_H_INCLUDED
@@ -0,0 +1,79 @@
+#ifndef MAPPEDPARAMETER_H_INCLUDED
+#define MAPPEDPARAMETER_H_INCLUDED
+
+#include "PluginParameter.h"
+#include "ParameterMapping.h"
+
+/**
+    A PluginParameter whose actual range is mapped by a ParameterMapping chosen
+    at compile time, e.g. logarithmic for frequencies.
+
+    @code
+    addParameter (cutoff = new MappedParameter<ParameterMapping::Logarithmic> (
+        "cutoff", 1000.f, ParameterMapping::Logarithmic (20.f, 20000.f), "Cutoff", "Hz", 0, cutoffCallback));
+    @endcode
+
+    The class is final, so calls to calculateActualValue() and calculateValue()
+    through a MappedParameter pointer inline the mapping instead of going
+    through the vtable. Keep the parameter as a MappedParameter in the
+    processor to read it on the audio thread. Wrap expensive curves in a
+    ParameterMapping::Table to replace exp, log or pow with an interpolated
+    lookup:
+
+    @code
+    typedef ParameterMapping::Table<ParameterMapping::Logarithmic> CutoffMapping;
+    MappedParameter<CutoffMapping>* cutoff;
+    @endcode
+
+    Text, smoothing, saved state and host automation all go through the
+    mapping, as they use the virtual conversions of PluginParameter.
+ */
+template <typename Mapping>
+class MappedParameter final : public PluginParameter {
+public:
+    /// Creates a parameter from an actual default value and a mapping of the
+    /// actual range.
+    MappedParameter(Identifier parameterId,
+                    float actualDefaultValue,
+                    const Mapping& parameterMapping,
+                    const String& parameterName,
+                    const String& parameterLabel = String::empty,
+                    const int precision = 0,
+                    std::function<void(float)> callback = nullptr)
+    : PluginParameter(parameterId, parameterMapping.toNormalized(actualDefaultValue),
+                      parameterName, parameterLabel, precision, callback),
+    mapping(parameterMapping)
+    {
+        setActualRange(mapping.getMinimum(), mapping.getMaximum());
+    }
+
+    /// Returns the normalized value of an actual value through the mapping.
+    float calculateValue(float actualValue) const override
+    {
+        return mapping.toNormalized(actualValue);
+    }
+
+    /// Returns the actual value of a normalized value through the mapping.
+    float calculateActualValue(float value) const override
+    {
+        return mapping.toActual(value);
+    }
+
+    /// Returns the number of steps of the mapping, e.g. of a Stepped mapping.
+    int getNumSteps() const override
+    {
+        return mapping.getNumSteps();
+    }
+
+    /// Returns the mapping.
+    const Mapping& getMapping() const
+    {
+        return mapping;
+    }
+
+private:
+    const Mapping mapping;
+};
+
+
+#endif  // MAPPEDPARAMETER_H_INCLUDED
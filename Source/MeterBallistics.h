@@ -0,0 +1,169 @@
+#ifndef METERBALLISTICS_H_INCLUDED
+#define METERBALLISTICS_H_INCLUDED
+
+#include <cmath>
+
+#include "DecibelConversion.h"
+#include "LevelMeter.h"
+
+/**
+    Turns the levels read from a LevelMeter into the values a meter displays.
+
+    This runs in the editor, so the audio thread only measures. Call update()
+    from the editor's timer with the levels read since the previous call, or
+    nullptr if there were none, and the time elapsed since the previous call:
+
+    - Peak: rises instantly and falls at the release rate.
+    - Peak hold: the highest peak, held for the hold time before it falls.
+    - RMS: the mean square integrated with the RMS time constant.
+    - True peak maximum: the highest true peak since resetTruePeak(), e.g. for
+      a clip indicator.
+
+    All values are returned in decibels, with a floor of -100 dB.
+ */
+class MeterBallistics {
+public:
+    MeterBallistics()
+    : hold_time(1.5f),
+    release_rate(20.f),
+    rms_time(0.3f),
+    num_channels(0)
+    {
+        for (int channel = 0; channel < LevelMeter::maximumChannels; ++channel) {
+            peak[channel] = floorDecibels;
+            peak_hold[channel] = floorDecibels;
+            hold_countdown[channel] = 0.f;
+            mean_square[channel] = 0.f;
+            rms[channel] = floorDecibels;
+            true_peak_maximum[channel] = floorDecibels;
+        }
+    }
+
+    /// Sets how long the peak hold stays at the highest peak, in seconds.
+    void setPeakHoldTime(float seconds)
+    {
+        hold_time = jmax(0.f, seconds);
+    }
+
+    /// Sets how fast the peak and peak hold fall, in decibels per second.
+    void setPeakReleaseRate(float decibelsPerSecond)
+    {
+        release_rate = jmax(0.f, decibelsPerSecond);
+    }
+
+    /// Sets the time constant of the RMS integration, in seconds. 0.3 seconds
+    /// is close to a VU meter.
+    void setRmsTime(float seconds)
+    {
+        rms_time = jmax(0.001f, seconds);
+    }
+
+    /// Advances the meter by elapsedSeconds with the levels measured during that
+    /// time, or with silence if levels is nullptr. Returns true if any displayed
+    /// value changed by more than a hundredth of a decibel.
+    bool update(const LevelMeter::Levels* levels, float elapsedSeconds)
+    {
+        if (levels != nullptr) {
+            num_channels = jlimit(0, (int) LevelMeter::maximumChannels, levels->numChannels);
+        }
+
+        const float release = release_rate * elapsedSeconds;
+        const float integration = 1.f - std::exp(-jmax(0.f, elapsedSeconds) / rms_time);
+        bool changed = false;
+
+        for (int channel = 0; channel < num_channels; ++channel) {
+            const bool hasLevels = levels != nullptr;
+            const float newPeak = hasLevels ? dB(levels->peak[channel]) : floorDecibels;
+            const float newRms = hasLevels ? levels->rms[channel] : 0.f;
+            const float newTruePeak = hasLevels ? dB(levels->truePeak[channel]) : floorDecibels;
+
+            const float lastPeak = peak[channel];
+            const float lastPeakHold = peak_hold[channel];
+            const float lastRms = rms[channel];
+
+            peak[channel] = jmax(newPeak, lastPeak - release, floorDecibels);
+
+            if (newPeak >= peak_hold[channel]) {
+                peak_hold[channel] = newPeak;
+                hold_countdown[channel] = hold_time;
+            } else if (hold_countdown[channel] > 0.f) {
+                hold_countdown[channel] -= elapsedSeconds;
+            } else {
+                peak_hold[channel] = jmax(peak[channel], peak_hold[channel] - release);
+            }
+
+            mean_square[channel] += integration * (newRms * newRms - mean_square[channel]);
+            rms[channel] = dB(std::sqrt(mean_square[channel]));
+
+            if (newTruePeak > true_peak_maximum[channel]) {
+                true_peak_maximum[channel] = newTruePeak;
+                changed = true;
+            }
+
+            changed = changed
+                   || std::abs(peak[channel] - lastPeak) > 0.01f
+                   || std::abs(peak_hold[channel] - lastPeakHold) > 0.01f
+                   || std::abs(rms[channel] - lastRms) > 0.01f;
+        }
+
+        return changed;
+    }
+
+    /// Clears the true peak maximum of every channel.
+    void resetTruePeak()
+    {
+        for (int channel = 0; channel < LevelMeter::maximumChannels; ++channel) {
+            true_peak_maximum[channel] = floorDecibels;
+        }
+    }
+
+    /// Returns the number of channels metered.
+    int getNumChannels() const
+    {
+        return num_channels;
+    }
+
+    /// Returns the peak of a channel in dB.
+    float getPeak(int channel) const
+    {
+        return peak[channel];
+    }
+
+    /// Returns the held peak of a channel in dB.
+    float getPeakHold(int channel) const
+    {
+        return peak_hold[channel];
+    }
+
+    /// Returns the integrated RMS level of a channel in dB.
+    float getRms(int channel) const
+    {
+        return rms[channel];
+    }
+
+    /// Returns the highest true peak of a channel since resetTruePeak() in dB.
+    float getTruePeakMaximum(int channel) const
+    {
+        return true_peak_maximum[channel];
+    }
+
+private:
+    /// The lowest level displayed, matching dB().
+    static constexpr float floorDecibels = -100.f;
+
+    float hold_time;
+    float release_rate;
+    float rms_time;
+
+    int num_channels;
+
+    float peak[LevelMeter::maximumChannels];
+    float peak_hold[LevelMeter::maximumChannels];
+    float hold_countdown[LevelMeter::maximumChannels];
+    float mean_square[LevelMeter::maximumChannels];
+    float rms[LevelMeter::maximumChannels];
+    float true_peak_maximum[LevelMeter::maximumChannels];
+};
+
+
+#endif  // METERBALLISTICS_H_INCLUDED
@@ -0,0 +1,84 @@
+#ifndef MIDIDISPATCHER_H_INCLUDED
+#define MIDIDISPATCHER_H_INCLUDED
+
+/**
+    Splits the processing of a block at the timestamps of its MIDI events, so
+    each event takes effect at its own sample instead of at the start of the
+    sub-block it falls in.
+
+    Create one per block and call nextSegment() for consecutive segments from
+    the start of the block. It hands the events due before the segment to a
+    handler and returns where the segment must end for the next event. The
+    MidiBuffer is only walked once per block, and events are passed as their
+    raw bytes in the buffer, so no MidiMessage is built or allocated.
+
+    An event ends the segment only if it is at least the minimum segment size
+    after its start. Closer events are handled at the start of the segment, at
+    most minimumSegmentSize - 1 samples early, so however dense the MIDI is the
+    number of segments, and the overhead each one costs, stays bounded. Events
+    are never handled late.
+ */
+class MidiDispatcher {
+public:
+    /// Prepares to split a block of numSamples samples at the events of
+    /// midiMessages. Events timestamped outside the block are clamped to it.
+    MidiDispatcher(const MidiBuffer& midiMessages, int numSamples, int minimumSegmentSize)
+    : iterator(midiMessages),
+    data(nullptr),
+    num_bytes(0),
+    position(0),
+    has_event(false),
+    num_samples(numSamples),
+    minimum_segment_size(jmax(1, minimumSegmentSize))
+    {
+        readNextEvent();
+    }
+
+    /** Handles the events due before the segment at startSample and returns the
+        length of the segment, at most maximumSamples.
+
+        handleEvent is called with the bytes of each event and its sample
+        position, as
+        `handleEvent(const uint8* data, int numBytes, int samplePosition)`. The
+        segment ends at the next remaining event, if it falls within
+        maximumSamples. Start the next segment where this one ends.
+     */
+    template <typename Handler>
+    int nextSegment(int startSample, int maximumSamples, Handler&& handleEvent)
+    {
+        const int handledBefore = startSample + jmin(minimum_segment_size, maximumSamples);
+
+        while (has_event && position < handledBefore) {
+            handleEvent(data, num_bytes, position);
+            readNextEvent();
+        }
+
+        return has_event && position < startSample + maximumSamples
+             ? position - startSample
+             : maximumSamples;
+    }
+
+private:
+    void readNextEvent()
+    {
+        has_event = iterator.getNextEvent(data, num_bytes, position);
+        position = jlimit(0, jmax(0, num_samples - 1), position);
+    }
+
+    MidiBuffer::Iterator iterator;
+
+    /// The bytes of the next event and its sample position, valid if has_event
+    /// is true.
+    const uint8* data;
+    int num_bytes;
+    int position;
+    bool has_event;
+
+    int num_samples;
+    int minimum_segment_size;
+
+    JUCE_DECLARE_NON_COPYABLE(MidiDispatcher)
+};
+
+
+#endif  // MIDIDISPATCHER_H_INCLUDED
@@ -0,0 +1,198 @@
+#ifndef MIDILEARN_H_INCLUDED
+#define MIDILEARN_H_INCLUDED
+
+#include <atomic>
+
+#include "TripleBuffer.h"
+
+/**
+    Maps MIDI controller numbers to parameter indices, for controllers that
+    automate parameters.
+
+    The editor changes the mapping on the message thread, either directly with
+    setController() or by learning: startLearning() arms a parameter and the
+    next controller the audio thread receives is mapped to it once the editor
+    calls finishLearning() from its timer. Every change is published as a whole
+    table through a TripleBuffer, which the audio thread takes at the start of
+    a block with beginBlock(), so neither side ever waits or allocates.
+
+    Each controller maps to at most one parameter and each parameter to at most
+    one controller. Controller values are 7 bits, mapped linearly to the
+    normalized range of the parameter.
+ */
+class MidiLearn {
+public:
+    /// The number of MIDI controller numbers.
+    static const int numControllers = 128;
+
+    MidiLearn()
+    : mapping(),
+    active(),
+    learning_parameter(-1),
+    learning_sequence(0),
+    received_sequence(0),
+    last_received(0)
+    {
+    }
+
+    // =======================================================
+    // Message thread
+    // =======================================================
+
+    /// Maps a controller to a parameter, replacing any other controller of the
+    /// parameter and any other parameter of the controller.
+    void setController(int controller, int parameterIndex)
+    {
+        jassert(isPositiveAndBelow(controller, numControllers));
+        jassert(isPositiveAndBelow(parameterIndex, 0xffff));
+
+        removeParameter(parameterIndex);
+        mapping.parameters[controller] = (uint16) (parameterIndex + 1);
+        publish();
+    }
+
+    /// Removes the mapping of a controller.
+    void removeController(int controller)
+    {
+        jassert(isPositiveAndBelow(controller, numControllers));
+
+        mapping.parameters[controller] = 0;
+        publish();
+    }
+
+    /// Removes all mappings.
+    void clear()
+    {
+        mapping = Table();
+        publish();
+    }
+
+    /// Returns the controller mapped to a parameter, or -1 if there is none.
+    int getController(int parameterIndex) const
+    {
+        for (int controller = 0; controller < numControllers; ++controller) {
+            if (mapping.parameters[controller] == parameterIndex + 1) {
+                return controller;
+            }
+        }
+        return -1;
+    }
+
+    /// Maps the next controller received to parameterIndex, see
+    /// finishLearning().
+    void startLearning(int parameterIndex)
+    {
+        learning_parameter = parameterIndex;
+        learning_sequence = last_received.load(std::memory_order_acquire) / numControllers;
+    }
+
+    /// Stops learning without changing the mapping.
+    void stopLearning()
+    {
+        learning_parameter = -1;
+    }
+
+    /// Returns the parameter being learned, or -1.
+    int getLearningParameter() const
+    {
+        return learning_parameter;
+    }
+
+    /// Maps the parameter being learned to the last controller received since
+    /// startLearning(). Returns true if it did, which ends learning. Call this
+    /// from the editor's timer.
+    bool finishLearning()
+    {
+        if (learning_parameter < 0) {
+            return false;
+        }
+
+        const uint32 received = last_received.load(std::memory_order_acquire);
+        if (received / numControllers == learning_sequence) {
+            return false;
+        }
+
+        setController((int) (received % numControllers), learning_parameter);
+        learning_parameter = -1;
+        return true;
+    }
+
+    // =======================================================
+    // Audio thread
+    // =======================================================
+
+    /// Takes the latest mapping published by the message thread. Call this once
+    /// at the start of each block.
+    void beginBlock()
+    {
+        tables.read(active);
+    }
+
+    /// Returns the index of the parameter a controller is mapped to, or -1.
+    int getParameterIndex(int controller) const
+    {
+        return isPositiveAndBelow(controller, numControllers)
+             ? (int) active.parameters[controller] - 1
+             : -1;
+    }
+
+    /// Notes a controller that was received, for learning. This is a single
+    /// atomic store.
+    void controllerReceived(int controller)
+    {
+        ++received_sequence;
+        last_received.store(received_sequence * numControllers + (uint32) (controller & (numControllers - 1)),
+                            std::memory_order_release);
+    }
+
+private:
+    /// A parameter index plus one per controller, 0 for none, so a table
+    /// initialised to zero maps nothing.
+    struct Table {
+        uint16 parameters[numControllers];
+    };
+
+    /// Removes every controller mapped to a parameter, without publishing.
+    void removeParameter(int parameterIndex)
+    {
+        for (int controller = 0; controller < numControllers; ++controller) {
+            if (mapping.parameters[controller] == parameterIndex + 1) {
+                mapping.parameters[controller] = 0;
+            }
+        }
+    }
+
+    /// Hands a copy of mapping to the audio thread.
+    void publish()
+    {
+        tables.getWriteBuffer() = mapping;
+        tables.publish();
+    }
+
+    /// The mapping as changed on the message thread.
+    Table mapping;
+
+    /// The mapping used on the audio thread, taken in beginBlock().
+    Table active;
+
+    /// Hands mapping from the message thread to the audio thread.
+    TripleBuffer<Table> tables;
+
+    /// The parameter being learned, or -1. Only used on the message thread.
+    int learning_parameter;
+
+    /// The sequence number of last_received when learning started.
+    uint32 learning_sequence;
+
+    /// The number of controllers received. Only used on the audio thread.
+    uint32 received_sequence;
+
+    /// The sequence number times numControllers plus the number of the last
+    /// controller received, so both are read together.
+    std::atomic<uint32> last_received;
+
+    JUCE_DECLARE_NON_COPYABLE(MidiLearn)
+};
+
+
+#endif  // MIDILEARN_H_INCLUDED
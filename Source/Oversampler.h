@@ -0,0 +1,738 @@
+#ifndef OVERSAMPLER_H_INCLUDED
+#define OVERSAMPLER_H_INCLUDED
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define OVERSAMPLER_USE_SSE 1
+ #include <emmintrin.h>
+#else
+ #define OVERSAMPLER_USE_SSE 0
+#endif
+
+/**
+    Oversamples audio by 2x, 4x or 8x using a cascade of polyphase half-band
+    filters.
+
+    Each stage doubles the sample rate on the way up and halves it on the way
+    down. Two filter types are available:
+
+    - firFilter: linear phase, windowed-sinc half-band FIR filters. Only the non
+      zero taps are computed, and outputs are computed eight at a time with SIMD.
+    - iirFilter: minimum latency, two-path polyphase allpass half-band filters.
+      The phase is not linear, and the reported latency is the group delay at DC.
+      The allpasses are serial, so channels run side by side in groups of four,
+      one per SIMD lane, like FilterBank.
+
+    All buffers are allocated in prepare(), so up and downsampling never
+    allocates. The number of stages can be changed at a block boundary from the
+    audio thread with setNumStages(), which resets the filter states.
+
+    Audio is float or double, as chosen in prepare(). The filters and their
+    states then run in that precision, and only its buffers are allocated.
+ */
+class Oversampler {
+public:
+    /// The half-band filter design used by every stage.
+    enum FilterType {
+        firFilter,
+        iirFilter
+    };
+
+    /// The largest number of stages, i.e. 8x oversampling.
+    static const int maximumStages = 3;
+
+    Oversampler()
+    : filter_type(firFilter),
+    num_stages(0),
+    num_channels(0),
+    maximum_block_size(0),
+    double_precision(false)
+    {
+    }
+
+    /// Sets the filter design. Call this before prepare().
+    void setFilterType(FilterType type)
+    {
+        filter_type = type;
+    }
+
+    /// Allocates the buffers and filter states of every stage for up to
+    /// numChannels channels and maximumBlockSize samples at the base rate, in
+    /// double precision if doublePrecision is true, and frees those of the
+    /// other precision.
+    void prepare(int numChannels, int maximumBlockSize, bool doublePrecision = false)
+    {
+        num_channels = jmax(1, numChannels);
+        maximum_block_size = jmax(1, maximumBlockSize);
+        double_precision = doublePrecision;
+
+        if (double_precision) {
+            double_path.prepare(filter_type, num_channels, maximum_block_size);
+            float_path.release();
+        }
+        else {
+            float_path.prepare(filter_type, num_channels, maximum_block_size);
+            double_path.release();
+        }
+
+        reset();
+    }
+
+    /// Clears the filter states of every stage.
+    void reset()
+    {
+        if (double_precision) {
+            double_path.reset();
+        }
+        else {
+            float_path.reset();
+        }
+    }
+
+    /// Sets the number of stages, from 0 (no oversampling) to maximumStages,
+    /// and resets the filter states if it changed.
+    void setNumStages(int numStages)
+    {
+        numStages = jlimit(0, (int) maximumStages, numStages);
+
+        if (numStages != num_stages) {
+            num_stages = numStages;
+            reset();
+        }
+    }
+
+    /// Returns the number of stages in use.
+    int getNumStages() const
+    {
+        return num_stages;
+    }
+
+    /// Returns the oversampling factor, 1, 2, 4 or 8.
+    int getFactor() const
+    {
+        return 1 << num_stages;
+    }
+
+    /// Returns the latency of up and downsampling at the base sample rate for
+    /// the current number of stages and filter type.
+    float getLatencyInSamples() const
+    {
+        float latency = 0.f;
+        for (int stage = 0; stage < num_stages; ++stage) {
+            const float groupDelay = double_precision ? double_path.stages[stage].getGroupDelay()
+                                                      : float_path.stages[stage].getGroupDelay();
+
+            // Each stage delays by its group delay twice, at twice its input rate
+            latency += 2.f * groupDelay / (float) (2 << stage);
+        }
+        return latency;
+    }
+
+    /// Returns the buffer holding the oversampled audio after upsample(), of
+    /// the precision prepared.
+    template <typename FloatType>
+    AudioBuffer<FloatType>& getOversampledBuffer()
+    {
+        jassert(num_stages > 0);
+        return getPath((FloatType*) nullptr).levels[num_stages - 1];
+    }
+
+    /// Upsamples numSamples samples of each channel into the oversampled buffer,
+    /// which then holds numSamples * getFactor() samples per channel. FloatType
+    /// must be the precision prepared.
+    template <typename FloatType>
+    void upsample(const AudioBuffer<FloatType>& source, int startSample, int numSamples, int numChannels)
+    {
+        jassert(numSamples <= maximum_block_size && numChannels <= num_channels);
+        jassert(double_precision == (sizeof(FloatType) == sizeof(double)));
+
+        Path<FloatType>& path = getPath((FloatType*) nullptr);
+
+        for (int stage = 0; stage < num_stages; ++stage) {
+            const int inputSize = numSamples << stage;
+
+            for (int firstChannel = 0; firstChannel < numChannels; firstChannel += numLanes) {
+                const int numGroupChannels = jmin((int) numLanes, numChannels - firstChannel);
+                const FloatType* inputs[numLanes];
+                FloatType* outputs[numLanes];
+
+                for (int lane = 0; lane < numGroupChannels; ++lane) {
+                    const int channel = firstChannel + lane;
+                    inputs[lane] = stage == 0
+                                 ? source.getReadPointer(channel, startSample)
+                                 : path.levels[stage - 1].getReadPointer(channel);
+                    outputs[lane] = path.levels[stage].getWritePointer(channel);
+                }
+
+                path.stages[stage].upsample(firstChannel, inputs, outputs, numGroupChannels, inputSize);
+            }
+        }
+    }
+
+    /// Downsamples the oversampled buffer back into numSamples samples of each
+    /// channel of the destination.
+    template <typename FloatType>
+    void downsample(AudioBuffer<FloatType>& destination, int startSample, int numSamples, int numChannels)
+    {
+        Path<FloatType>& path = getPath((FloatType*) nullptr);
+
+        for (int stage = num_stages - 1; stage >= 0; --stage) {
+            const int outputSize = numSamples << stage;
+
+            for (int firstChannel = 0; firstChannel < numChannels; firstChannel += numLanes) {
+                const int numGroupChannels = jmin((int) numLanes, numChannels - firstChannel);
+                const FloatType* inputs[numLanes];
+                FloatType* outputs[numLanes];
+
+                for (int lane = 0; lane < numGroupChannels; ++lane) {
+                    const int channel = firstChannel + lane;
+                    inputs[lane] = path.levels[stage].getReadPointer(channel);
+                    outputs[lane] = stage == 0
+                                  ? destination.getWritePointer(channel, startSample)
+                                  : path.levels[stage - 1].getWritePointer(channel);
+                }
+
+                path.stages[stage].downsample(firstChannel, inputs, outputs, numGroupChannels, outputSize);
+            }
+        }
+    }
+
+private:
+    /// The number of channels the IIR filters process together.
+    static const int numLanes = 4;
+
+    /**
+        A single 2x stage, holding the filter states of all channels for both
+        directions.
+
+        The FIR filters are half-band filters with 4 * K - 1 taps, where every
+        other tap is zero except for the centre tap of 0.5. Upsampling computes
+        even outputs as a 2 * K tap convolution of the input and copies odd
+        outputs from the delayed input. Downsampling convolves the even inputs
+        and adds the delayed odd inputs.
+
+        The IIR filters are two parallel chains of first order allpass filters
+        running at the lower rate, designed as elliptic half-band filters. Their
+        states are kept per group of numLanes channels, one value per lane, and
+        each allpass runs over a transposed chunk of the group at a time.
+
+        The filters are designed in double precision and run in FloatType.
+     */
+    template <typename FloatType>
+    class Stage {
+    public:
+        /// The number of coefficients of the FIR (pairs of taps) and IIR filters
+        /// of each stage. Later stages run on signals that are already band
+        /// limited, so they need fewer coefficients.
+        static int getNumFIRCoefficients(int stage) { return stage == 0 ? 16 : (stage == 1 ? 8 : 6); }
+        static int getNumIIRCoefficients(int stage) { return stage == 0 ? 8 : (stage == 1 ? 5 : 4); }
+
+        /// Designs the filter and allocates the state for numChannels channels
+        /// of up to maximumInputSize samples at the lower rate.
+        void prepare(FilterType type, int stage, int numChannels, int maximumInputSize)
+        {
+            filter_type = type;
+            num_channels = numChannels;
+            maximum_size = maximumInputSize;
+
+            if (filter_type == firFilter) {
+                designFIR(getNumFIRCoefficients(stage));
+            }
+            else {
+                designIIR(getNumIIRCoefficients(stage), stage == 0 ? 0.04 : 0.15);
+            }
+
+            stride = num_taps + maximum_size;
+
+            up_buffer.calloc((size_t) (num_channels * stride));
+            even_buffer.calloc((size_t) (num_channels * stride));
+            odd_buffer.calloc((size_t) (num_channels * stride));
+            scratch.calloc((size_t) maximum_size);
+
+            num_groups = (num_channels + numLanes - 1) / numLanes;
+            state_size = 2 * numLanes * num_iir_coefficients;
+            up_state.calloc((size_t) jmax(1, num_groups * state_size));
+            down_state.calloc((size_t) jmax(1, num_groups * state_size));
+        }
+
+        /// Frees the filters and states.
+        void release()
+        {
+            taps.free();
+            half_taps.free();
+            up_buffer.free();
+            even_buffer.free();
+            odd_buffer.free();
+            scratch.free();
+            iir_coefficients.free();
+            up_state.free();
+            down_state.free();
+            num_channels = 0;
+        }
+
+        /// Clears the filter states.
+        void reset()
+        {
+            if (num_channels == 0) {
+                return;
+            }
+
+            up_buffer.clear((size_t) (num_channels * stride));
+            even_buffer.clear((size_t) (num_channels * stride));
+            odd_buffer.clear((size_t) (num_channels * stride));
+            up_state.clear((size_t) jmax(1, num_groups * state_size));
+            down_state.clear((size_t) jmax(1, num_groups * state_size));
+        }
+
+        /// Returns half the delay of upsampling followed by downsampling, in
+        /// samples at the higher rate.
+        float getGroupDelay() const
+        {
+            return group_delay;
+        }
+
+        /// Writes 2 * numSamples samples to each output, for up to numLanes
+        /// channels starting at firstChannel, which is a multiple of numLanes.
+        void upsample(int firstChannel, const FloatType* const* inputs, FloatType* const* outputs,
+                      int numChannels, int numSamples)
+        {
+            if (filter_type == firFilter) {
+                for (int lane = 0; lane < numChannels; ++lane) {
+                    upsampleFIR(firstChannel + lane, inputs[lane], outputs[lane], numSamples);
+                }
+            }
+            else {
+                upsampleIIR(firstChannel, inputs, outputs, numChannels, numSamples);
+            }
+        }
+
+        /// Reads 2 * numSamples samples from each input, for up to numLanes
+        /// channels starting at firstChannel, which is a multiple of numLanes.
+        void downsample(int firstChannel, const FloatType* const* inputs, FloatType* const* outputs,
+                        int numChannels, int numSamples)
+        {
+            if (filter_type == firFilter) {
+                for (int lane = 0; lane < numChannels; ++lane) {
+                    downsampleFIR(firstChannel + lane, inputs[lane], outputs[lane], numSamples);
+                }
+            }
+            else {
+                downsampleIIR(firstChannel, inputs, outputs, numChannels, numSamples);
+            }
+        }
+
+    private:
+        /// Designs a Kaiser windowed half-band filter with 4 * K - 1 taps and
+        /// stores its 2 * K non zero side taps for the upsampler.
+        void designFIR(int K)
+        {
+            num_taps = 2 * K;
+            taps.malloc((size_t) num_taps);
+            half_taps.malloc((size_t) num_taps);
+
+            const double beta = 8.0;
+            const double centre = 2 * K - 1;
+            double sum = 0.0;
+
+            for (int j = 0; j < K; ++j) {
+                const double d = 2 * j + 1;
+                const double ratio = d / (centre + 1.0);
+                const double window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+                const double tap = window / (double_Pi * d) * (j % 2 == 0 ? 1.0 : -1.0);
+
+                half_taps[K - 1 - j] = half_taps[K + j] = (FloatType) tap;
+                sum += 2.0 * tap;
+            }
+
+            // Normalize the side taps to 0.5 so the DC gain is exactly one
+            for (int i = 0; i < num_taps; ++i) {
+                half_taps[i] = (FloatType) (half_taps[i] * 0.5 / sum);
+                taps[i] = 2 * half_taps[i];
+            }
+
+            num_iir_coefficients = 0;
+            group_delay = (float) centre;
+        }
+
+        /// Designs the allpass coefficients of an elliptic half-band filter
+        /// with the given number of coefficients and normalized transition width.
+        void designIIR(int numCoefficients, double transition)
+        {
+            jassert(numCoefficients <= maximumIIRCoefficients);
+            num_iir_coefficients = numCoefficients;
+            num_taps = 0;
+            iir_coefficients.malloc((size_t) numCoefficients);
+
+            double k = std::tan((1.0 - transition * 2.0) * double_Pi / 4.0);
+            k *= k;
+            const double kksqrt = std::pow(1.0 - k * k, 0.25);
+            const double e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+            const double e4 = e * e * e * e;
+            const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+            const int order = numCoefficients * 2 + 1;
+
+            double evenDelay = 0.0;
+            double oddDelay = 1.0;
+
+            for (int index = 0; index < numCoefficients; ++index) {
+                const double c = index + 1;
+
+                double numerator = 0.0;
+                double sign = 1.0;
+                for (int i = 0; i < 32; ++i, sign = -sign) {
+                    numerator += std::pow(q, i * (i + 1)) * std::sin((2 * i + 1) * c * double_Pi / order) * sign;
+                }
+
+                double denominator = 0.5;
+                sign = -1.0;
+                for (int i = 1; i < 32; ++i, sign = -sign) {
+                    denominator += std::pow(q, i * i) * std::cos(2 * i * c * double_Pi / order) * sign;
+                }
+
+                const double ww = numerator * std::pow(q, 0.25) / denominator;
+                const double wwsq = ww * ww;
+                const double x = std::sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+                const double a = (1.0 - x) / (1.0 + x);
+
+                iir_coefficients[index] = (FloatType) a;
+
+                // Group delay at DC of each allpass, in samples at the higher rate
+                (index % 2 == 0 ? evenDelay : oddDelay) += 2.0 * (1.0 - a) / (1.0 + a);
+            }
+
+            // The downsampler's output lines up with the odd input of each pair,
+            // which takes one sample at the higher rate off the round trip
+            group_delay = (float) (0.5 * (evenDelay + oddDelay) - 0.5);
+        }
+
+        static double besselI0(double x)
+        {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; ++k) {
+                const double t = x / (2.0 * k);
+                term *= t * t;
+                sum += term;
+            }
+            return sum;
+        }
+
+        /// Computes output[n] = sum of coefficients[i] * input[n + i], four or
+        /// eight outputs at a time.
+        static void convolve(const float* input, const float* coefficients, int numCoefficients,
+                             float* output, int numOutputs)
+        {
+            int n = 0;
+
+           #if OVERSAMPLER_USE_SSE
+            for (; n + 8 <= numOutputs; n += 8) {
+                __m128 a = _mm_setzero_ps();
+                __m128 b = _mm_setzero_ps();
+
+                for (int i = 0; i < numCoefficients; ++i) {
+                    const __m128 c = _mm_set1_ps(coefficients[i]);
+                    a = _mm_add_ps(a, _mm_mul_ps(c, _mm_loadu_ps(input + n + i)));
+                    b = _mm_add_ps(b, _mm_mul_ps(c, _mm_loadu_ps(input + n + i + 4)));
+                }
+
+                _mm_storeu_ps(output + n, a);
+                _mm_storeu_ps(output + n + 4, b);
+            }
+           #endif
+
+            for (; n < numOutputs; ++n) {
+                float sum = 0.f;
+                for (int i = 0; i < numCoefficients; ++i) {
+                    sum += coefficients[i] * input[n + i];
+                }
+                output[n] = sum;
+            }
+        }
+
+        /// Computes output[n] = sum of coefficients[i] * input[n + i] in double
+        /// precision, four outputs at a time.
+        static void convolve(const double* input, const double* coefficients, int numCoefficients,
+                             double* output, int numOutputs)
+        {
+            int n = 0;
+
+           #if OVERSAMPLER_USE_SSE
+            for (; n + 4 <= numOutputs; n += 4) {
+                __m128d a = _mm_setzero_pd();
+                __m128d b = _mm_setzero_pd();
+
+                for (int i = 0; i < numCoefficients; ++i) {
+                    const __m128d c = _mm_set1_pd(coefficients[i]);
+                    a = _mm_add_pd(a, _mm_mul_pd(c, _mm_loadu_pd(input + n + i)));
+                    b = _mm_add_pd(b, _mm_mul_pd(c, _mm_loadu_pd(input + n + i + 2)));
+                }
+
+                _mm_storeu_pd(output + n, a);
+                _mm_storeu_pd(output + n + 2, b);
+            }
+           #endif
+
+            for (; n < numOutputs; ++n) {
+                double sum = 0.0;
+                for (int i = 0; i < numCoefficients; ++i) {
+                    sum += coefficients[i] * input[n + i];
+                }
+                output[n] = sum;
+            }
+        }
+
+        void upsampleFIR(int channel, const FloatType* input, FloatType* output, int numSamples)
+        {
+            FloatType* const buffer = up_buffer + channel * stride;
+            const int historyLength = num_taps - 1;
+            const int K = num_taps / 2;
+
+            FloatVectorOperations::copy(buffer + historyLength, input, numSamples);
+            convolve(buffer, taps, num_taps, scratch, numSamples);
+
+            for (int i = 0; i < numSamples; ++i) {
+                output[2 * i] = scratch[i];
+                output[2 * i + 1] = buffer[i + K];
+            }
+
+            std::memmove(buffer, buffer + numSamples, sizeof(FloatType) * (size_t) historyLength);
+        }
+
+        void downsampleFIR(int channel, const FloatType* input, FloatType* output, int numSamples)
+        {
+            FloatType* const even = even_buffer + channel * stride;
+            FloatType* const odd = odd_buffer + channel * stride;
+            const int historyLength = num_taps - 1;
+            const int K = num_taps / 2;
+
+            for (int i = 0; i < numSamples; ++i) {
+                even[historyLength + i] = input[2 * i];
+                odd[K + i] = input[2 * i + 1];
+            }
+
+            convolve(even, half_taps, num_taps, output, numSamples);
+            FloatVectorOperations::addWithMultiply(output, odd, (FloatType) 0.5, numSamples);
+
+            std::memmove(even, even + numSamples, sizeof(FloatType) * (size_t) historyLength);
+            std::memmove(odd, odd + numSamples, sizeof(FloatType) * (size_t) K);
+        }
+
+        /// The samples of a group transposed at a time, at the lower rate.
+        static const int chunkSize = 64;
+
+        /// The largest number of IIR coefficients of a stage.
+        static const int maximumIIRCoefficients = 8;
+
+        // Vectors of as many lanes as SIMD holds of FloatType, or single lanes
+        // where there is no SIMD
+       #if OVERSAMPLER_USE_SSE
+        static __m128 loadLanes(const float* p) { return _mm_loadu_ps(p); }
+        static __m128d loadLanes(const double* p) { return _mm_loadu_pd(p); }
+        static void storeLanes(float* p, __m128 v) { _mm_storeu_ps(p, v); }
+        static void storeLanes(double* p, __m128d v) { _mm_storeu_pd(p, v); }
+        static __m128 fillLanes(float v) { return _mm_set1_ps(v); }
+        static __m128d fillLanes(double v) { return _mm_set1_pd(v); }
+        static __m128 allpass(__m128 c, __m128 x, __m128 x1, __m128 y1) { return _mm_add_ps(_mm_mul_ps(c, _mm_sub_ps(x, y1)), x1); }
+        static __m128d allpass(__m128d c, __m128d x, __m128d x1, __m128d y1) { return _mm_add_pd(_mm_mul_pd(c, _mm_sub_pd(x, y1)), x1); }
+       #else
+        static FloatType loadLanes(const FloatType* p) { return *p; }
+        static void storeLanes(FloatType* p, FloatType v) { *p = v; }
+        static FloatType fillLanes(FloatType v) { return v; }
+        static FloatType allpass(FloatType c, FloatType x, FloatType x1, FloatType y1) { return c * (x - y1) + x1; }
+       #endif
+
+        typedef decltype(fillLanes(FloatType())) Lanes;
+        static const int lanesPerVector = (int) (sizeof(Lanes) / sizeof(FloatType));
+
+        /** Runs count vectors of numLanes samples through the two allpass
+            chains, first through the even coefficients and second through the
+            odd ones. Vectors of lanes beyond numChannels are skipped.
+
+            Each sample runs through every allpass before the next, with the
+            states in registers, so the allpasses of both chains overlap
+            instead of waiting on one recurrence at a time.
+         */
+        void runAllpasses(FloatType* first, FloatType* second, int count, FloatType* state, int numChannels) const
+        {
+            const int numCoefficients = num_iir_coefficients;
+
+            for (int lane = 0; lane < numChannels; lane += lanesPerVector) {
+                Lanes c[maximumIIRCoefficients], x1[maximumIIRCoefficients], y1[maximumIIRCoefficients];
+                for (int j = 0; j < numCoefficients; ++j) {
+                    c[j] = fillLanes(iir_coefficients[j]);
+                    x1[j] = loadLanes(state + 2 * j * numLanes + lane);
+                    y1[j] = loadLanes(state + (2 * j + 1) * numLanes + lane);
+                }
+
+                for (int i = 0; i < count; ++i) {
+                    FloatType* const a = first + i * numLanes + lane;
+                    FloatType* const b = second + i * numLanes + lane;
+
+                    Lanes x = loadLanes(a);
+                    for (int j = 0; j < numCoefficients; j += 2) {
+                        const Lanes y = allpass(c[j], x, x1[j], y1[j]);
+                        x1[j] = x;
+                        y1[j] = y;
+                        x = y;
+                    }
+                    storeLanes(a, x);
+
+                    x = loadLanes(b);
+                    for (int j = 1; j < numCoefficients; j += 2) {
+                        const Lanes y = allpass(c[j], x, x1[j], y1[j]);
+                        x1[j] = x;
+                        y1[j] = y;
+                        x = y;
+                    }
+                    storeLanes(b, x);
+                }
+
+                for (int j = 0; j < numCoefficients; ++j) {
+                    storeLanes(state + 2 * j * numLanes + lane, x1[j]);
+                    storeLanes(state + (2 * j + 1) * numLanes + lane, y1[j]);
+                }
+            }
+        }
+
+        void upsampleIIR(int firstChannel, const FloatType* const* inputs, FloatType* const* outputs,
+                         int numChannels, int numSamples)
+        {
+            FloatType* const state = up_state + (firstChannel / numLanes) * state_size;
+            FloatType even[chunkSize * numLanes];
+            FloatType odd[chunkSize * numLanes];
+
+            for (int start = 0; start < numSamples; start += chunkSize) {
+                const int count = jmin((int) chunkSize, numSamples - start);
+
+                // Transpose into one vector of the group's channels per sample,
+                // with unused lanes silent
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    const FloatType* const input = lane < numChannels ? inputs[lane] + start : nullptr;
+                    for (int i = 0; i < count; ++i) {
+                        even[i * numLanes + lane] = input != nullptr ? input[i] : (FloatType) 0;
+                    }
+                }
+                std::memcpy(odd, even, sizeof(FloatType) * (size_t) (count * numLanes));
+
+                runAllpasses(even, odd, count, state, numChannels);
+
+                for (int lane = 0; lane < numChannels; ++lane) {
+                    FloatType* const output = outputs[lane] + 2 * start;
+                    for (int i = 0; i < count; ++i) {
+                        output[2 * i] = even[i * numLanes + lane];
+                        output[2 * i + 1] = odd[i * numLanes + lane];
+                    }
+                }
+            }
+        }
+
+        void downsampleIIR(int firstChannel, const FloatType* const* inputs, FloatType* const* outputs,
+                           int numChannels, int numSamples)
+        {
+            FloatType* const state = down_state + (firstChannel / numLanes) * state_size;
+            FloatType even[chunkSize * numLanes];
+            FloatType odd[chunkSize * numLanes];
+
+            for (int start = 0; start < numSamples; start += chunkSize) {
+                const int count = jmin((int) chunkSize, numSamples - start);
+
+                for (int lane = 0; lane < numLanes; ++lane) {
+                    const FloatType* const input = lane < numChannels ? inputs[lane] + 2 * start : nullptr;
+                    for (int i = 0; i < count; ++i) {
+                        even[i * numLanes + lane] = input != nullptr ? input[2 * i] : (FloatType) 0;
+                        odd[i * numLanes + lane] = input != nullptr ? input[2 * i + 1] : (FloatType) 0;
+                    }
+                }
+
+                runAllpasses(odd, even, count, state, numChannels);
+
+                for (int lane = 0; lane < numChannels; ++lane) {
+                    FloatType* const output = outputs[lane] + start;
+                    for (int i = 0; i < count; ++i) {
+                        output[i] = (FloatType) 0.5 * (odd[i * numLanes + lane] + even[i * numLanes + lane]);
+                    }
+                }
+            }
+        }
+
+        FilterType filter_type = firFilter;
+        int num_channels = 0;
+        int maximum_size = 0;
+
+        /// FIR side taps for upsampling, and the same taps halved for
+        /// downsampling.
+        HeapBlock<FloatType> taps, half_taps;
+        int num_taps = 0;
+
+        /// Per channel input histories followed by room for one block.
+        HeapBlock<FloatType> up_buffer, even_buffer, odd_buffer;
+        int stride = 0;
+
+        /// Even outputs of the upsampler before interleaving.
+        HeapBlock<FloatType> scratch;
+
+        /// IIR allpass coefficients, and states per group of numLanes channels
+        /// holding x1 and y1 of each allpass for every lane.
+        HeapBlock<FloatType> iir_coefficients;
+        HeapBlock<FloatType> up_state, down_state;
+        int num_iir_coefficients = 0;
+        int num_groups = 0;
+        int state_size = 0;
+
+        /// Half the round trip delay in samples at the higher rate.
+        float group_delay = 0.f;
+    };
+
+    /// The stages of one precision, with their outputs.
+    template <typename FloatType>
+    struct Path {
+        void prepare(FilterType type, int numChannels, int maximumBlockSize)
+        {
+            for (int stage = 0; stage < maximumStages; ++stage) {
+                const int inputSize = maximumBlockSize << stage;
+                stages[stage].prepare(type, stage, numChannels, inputSize);
+                levels[stage].setSize(numChannels, inputSize * 2);
+            }
+        }
+
+        void release()
+        {
+            for (int stage = 0; stage < maximumStages; ++stage) {
+                stages[stage].release();
+                levels[stage].setSize(0, 0);
+            }
+        }
+
+        void reset()
+        {
+            for (int stage = 0; stage < maximumStages; ++stage) {
+                stages[stage].reset();
+            }
+        }
+
+        Stage<FloatType> stages[maximumStages];
+
+        /// The output of each upsampling stage, at 2x, 4x and 8x the base rate.
+        AudioBuffer<FloatType> levels[maximumStages];
+    };
+
+    Path<float>& getPath(float*) { return float_path; }
+    Path<double>& getPath(double*) { return double_path; }
+
+    Path<float> float_path;
+    Path<double> double_path;
+
+    FilterType filter_type;
+    int num_stages;
+    int num_channels;
+    int maximum_block_size;
+
+    /// Whether double_path is in use rather than float_path.
+    bool double_precision;
+
+    JUCE_DECLARE_NON_COPYABLE(Oversampler)
+};
+
+
+#endif  // OVERSAMPLER_H_INCLUDED
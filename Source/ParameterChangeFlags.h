@@ -0,0 +1,95 @@
+#ifndef PARAMETERCHANGEFLAGS_H_INCLUDED
+#define PARAMETERCHANGEFLAGS_H_INCLUDED
+
+#include <atomic>
+#include <new>
+
+/**
+    A bitset marking which parameters changed since their reader last looked.
+
+    PluginParameter::setValue() marks its parameter from whatever thread sets
+    it. The processor keeps two sets: one the audio thread takes at the start
+    of a block to run the callbacks of changed parameters, and one the editor's
+    timer takes to update only the controls that need it. Both read the values
+    themselves from the parameters, so only the latest value of a parameter is
+    ever acted on. Marking is a single atomic OR, so any number of threads can
+    mark at once, and reading an unchanged set costs one load per 32
+    parameters.
+ */
+class ParameterChangeFlags {
+public:
+    ParameterChangeFlags()
+    : num_parameters(0),
+    num_words(0)
+    {
+    }
+
+    /// Allocates a flag for each of numParameters parameters, all cleared. Call
+    /// this before any parameter is marked.
+    void setSize(int numParameters)
+    {
+        num_parameters = jmax(0, numParameters);
+        num_words = (num_parameters + 31) / 32;
+        words.malloc((size_t) jmax(1, num_words));
+
+        for (int i = 0; i < jmax(1, num_words); ++i) {
+            new (words + i) std::atomic<uint32>(0);
+        }
+    }
+
+    /// Marks a parameter as changed. Safe to call from any thread.
+    void mark(int parameterIndex)
+    {
+        if (isPositiveAndBelow(parameterIndex, num_parameters)) {
+            words[parameterIndex >> 5].fetch_or(1u << (parameterIndex & 31), std::memory_order_release);
+        }
+    }
+
+    /// Marks every parameter as changed, e.g. to refresh a newly opened editor.
+    void markAll()
+    {
+        for (int i = 0; i < num_words; ++i) {
+            words[i].store(0xffffffffu, std::memory_order_release);
+        }
+    }
+
+    /// Clears the flags and calls callback(int parameterIndex) for each
+    /// parameter marked since the last call. Returns true if any was marked.
+    /// Only call this from one thread, the one reading the set. It never
+    /// allocates, so that may be the audio thread.
+    template <typename Callback>
+    bool forEachChanged(Callback&& callback)
+    {
+        bool changed = false;
+
+        for (int i = 0; i < num_words; ++i) {
+            if (words[i].load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+
+            uint32 bits = words[i].exchange(0, std::memory_order_acquire);
+            changed = changed || bits != 0;
+
+            for (int index = i * 32; bits != 0; ++index, bits >>= 1) {
+                if ((bits & 1) != 0 && index < num_parameters) {
+                    callback(index);
+                }
+            }
+        }
+
+        return changed;
+    }
+
+private:
+    /// The flags, 32 parameters per word.
+    HeapBlock<std::atomic<uint32>> words;
+
+    /// The number of parameters and of words holding their flags.
+    int num_parameters;
+    int num_words;
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterChangeFlags)
+};
+
+
+#endif  // PARAMETERCHANGEFLAGS_H_INCLUDED
@@ -0,0 +1,357 @@
+#ifndef PARAMETERMAPPING_H_INCLUDED
+#define PARAMETERMAPPING_H_INCLUDED
+
+#include <cmath>
+
+/**
+    Mappings between normalized parameter values and actual values.
+
+    Each mapping is a small class with the same interface, so MappedParameter
+    can take one as a template argument and inline its conversions:
+
+    - float toActual(float value) const: the actual value of a normalized one.
+    - float toNormalized(float actualValue) const: the inverse.
+    - getMinimum(), getMaximum(): the actual range.
+    - int getNumSteps() const: the number of steps for the host.
+
+    Every mapping returns exactly the minimum and maximum for normalized values
+    of 0 and 1, and exactly 0 and 1 for the minimum and maximum, whatever the
+    rounding of the curve in between. Values outside the range are clamped.
+    The minimum must be below the maximum.
+
+    Curves that need exp, log or pow per conversion can be wrapped in a Table,
+    which interpolates a precomputed curve instead.
+ */
+struct ParameterMapping {
+    /// Maps the range evenly, e.g. for pan or mix.
+    class Linear {
+    public:
+        Linear(float actualMinimum, float actualMaximum)
+        : minimum(actualMinimum),
+        maximum(actualMaximum),
+        range(actualMaximum - actualMinimum)
+        {
+            jassert(minimum < maximum);
+        }
+
+        float toActual(float value) const
+        {
+            if (value <= 0.f) {
+                return minimum;
+            }
+            if (value >= 1.f) {
+                return maximum;
+            }
+            return minimum + range * value;
+        }
+
+        float toNormalized(float actualValue) const
+        {
+            if (actualValue <= minimum) {
+                return 0.f;
+            }
+            if (actualValue >= maximum) {
+                return 1.f;
+            }
+            return (actualValue - minimum) / range;
+        }
+
+        float getMinimum() const { return minimum; }
+        float getMaximum() const { return maximum; }
+        int getNumSteps() const { return AudioProcessor::getDefaultNumParameterSteps(); }
+
+    private:
+        float minimum, maximum, range;
+    };
+
+    /// Maps the range so equal steps of the normalized value are equal ratios
+    /// of the actual value, e.g. for frequencies. The minimum must be above 0.
+    class Logarithmic {
+    public:
+        Logarithmic(float actualMinimum, float actualMaximum)
+        : minimum(actualMinimum),
+        maximum(actualMaximum),
+        log_ratio(std::log(actualMaximum / actualMinimum))
+        {
+            jassert(minimum > 0.f && minimum < maximum);
+        }
+
+        float toActual(float value) const
+        {
+            if (value <= 0.f) {
+                return minimum;
+            }
+            if (value >= 1.f) {
+                return maximum;
+            }
+            return minimum * std::exp(log_ratio * value);
+        }
+
+        float toNormalized(float actualValue) const
+        {
+            if (actualValue <= minimum) {
+                return 0.f;
+            }
+            if (actualValue >= maximum) {
+                return 1.f;
+            }
+            return std::log(actualValue / minimum) / log_ratio;
+        }
+
+        float getMinimum() const { return minimum; }
+        float getMaximum() const { return maximum; }
+        int getNumSteps() const { return AudioProcessor::getDefaultNumParameterSteps(); }
+
+    private:
+        float minimum, maximum, log_ratio;
+    };
+
+    /// Maps the range through a power curve, like the skew of JUCE's
+    /// NormalisableRange. A skew below 1 gives more of the normalized range to
+    /// the low end, e.g. for times.
+    class Skewed {
+    public:
+        Skewed(float actualMinimum, float actualMaximum, float skew)
+        : minimum(actualMinimum),
+        maximum(actualMaximum),
+        range(actualMaximum - actualMinimum),
+        skew_factor(skew),
+        inverse_skew(1.f / skew)
+        {
+            jassert(minimum < maximum && skew > 0.f);
+        }
+
+        /// Returns the mapping whose normalized value of 0.5 is centre.
+        static Skewed withCentre(float actualMinimum, float actualMaximum, float centre)
+        {
+            const float proportion = (centre - actualMinimum) / (actualMaximum - actualMinimum);
+            return Skewed(actualMinimum, actualMaximum, std::log(0.5f) / std::log(proportion));
+        }
+
+        float toActual(float value) const
+        {
+            if (value <= 0.f) {
+                return minimum;
+            }
+            if (value >= 1.f) {
+                return maximum;
+            }
+            return minimum + range * std::pow(value, inverse_skew);
+        }
+
+        float toNormalized(float actualValue) const
+        {
+            if (actualValue <= minimum) {
+                return 0.f;
+            }
+            if (actualValue >= maximum) {
+                return 1.f;
+            }
+            return std::pow((actualValue - minimum) / range, skew_factor);
+        }
+
+        float getMinimum() const { return minimum; }
+        float getMaximum() const { return maximum; }
+        int getNumSteps() const { return AudioProcessor::getDefaultNumParameterSteps(); }
+
+    private:
+        float minimum, maximum, range, skew_factor, inverse_skew;
+    };
+
+    /// Maps the range through an exponential curve whose curvature sets how
+    /// steep it is, e.g. for gains and envelope times. Positive curvatures
+    /// rise slowly then fast, negative ones the other way round, and 0 is
+    /// linear.
+    class Exponential {
+    public:
+        Exponential(float actualMinimum, float actualMaximum, float curvature)
+        : minimum(actualMinimum),
+        maximum(actualMaximum),
+        range(actualMaximum - actualMinimum),
+        curve(std::abs(curvature) < 1.0e-4f ? 0.f : curvature),
+        scale(curve == 0.f ? 1.f : std::exp(curve) - 1.f)
+        {
+            jassert(minimum < maximum);
+        }
+
+        float toActual(float value) const
+        {
+            if (value <= 0.f) {
+                return minimum;
+            }
+            if (value >= 1.f) {
+                return maximum;
+            }
+            if (curve == 0.f) {
+                return minimum + range * value;
+            }
+            return minimum + range * (std::exp(curve * value) - 1.f) / scale;
+        }
+
+        float toNormalized(float actualValue) const
+        {
+            if (actualValue <= minimum) {
+                return 0.f;
+            }
+            if (actualValue >= maximum) {
+                return 1.f;
+            }
+
+            const float proportion = (actualValue - minimum) / range;
+            if (curve == 0.f) {
+                return proportion;
+            }
+            return std::log(1.f + proportion * scale) / curve;
+        }
+
+        float getMinimum() const { return minimum; }
+        float getMaximum() const { return maximum; }
+        int getNumSteps() const { return AudioProcessor::getDefaultNumParameterSteps(); }
+
+    private:
+        float minimum, maximum, range, curve, scale;
+    };
+
+    /// Maps the range to numSteps evenly spaced values, e.g. for choices where
+    /// the actual value is the index of the choice.
+    class Stepped {
+    public:
+        Stepped(float actualMinimum, float actualMaximum, int numberOfSteps)
+        : minimum(actualMinimum),
+        maximum(actualMaximum),
+        step_size((actualMaximum - actualMinimum) / (float) (numberOfSteps - 1)),
+        last_step((float) (numberOfSteps - 1)),
+        num_steps(numberOfSteps)
+        {
+            jassert(minimum < maximum && numberOfSteps >= 2);
+        }
+
+        float toActual(float value) const
+        {
+            if (value <= 0.f) {
+                return minimum;
+            }
+            if (value >= 1.f) {
+                return maximum;
+            }
+            return minimum + step_size * std::floor(value * last_step + 0.5f);
+        }
+
+        float toNormalized(float actualValue) const
+        {
+            if (actualValue <= minimum) {
+                return 0.f;
+            }
+            if (actualValue >= maximum) {
+                return 1.f;
+            }
+            return std::floor((actualValue - minimum) / step_size + 0.5f) / last_step;
+        }
+
+        float getMinimum() const { return minimum; }
+        float getMaximum() const { return maximum; }
+        int getNumSteps() const { return num_steps; }
+
+    private:
+        float minimum, maximum, step_size, last_step;
+        int num_steps;
+    };
+
+    /// Maps the range to the powers of two from 2^minimumExponent to
+    /// 2^maximumExponent, one step each, e.g. for oversampling factors or FFT
+    /// sizes.
+    class PowersOfTwo {
+    public:
+        PowersOfTwo(int minimumExponent, int maximumExponent)
+        : minimum_exponent(minimumExponent),
+        last_step((float) (maximumExponent - minimumExponent)),
+        minimum(std::ldexp(1.f, minimumExponent)),
+        maximum(std::ldexp(1.f, maximumExponent))
+        {
+            jassert(minimumExponent < maximumExponent);
+        }
+
+        float toActual(float value) const
+        {
+            if (value <= 0.f) {
+                return minimum;
+            }
+            if (value >= 1.f) {
+                return maximum;
+            }
+            return std::ldexp(1.f, minimum_exponent + (int) std::floor(value * last_step + 0.5f));
+        }
+
+        float toNormalized(float actualValue) const
+        {
+            if (actualValue <= minimum) {
+                return 0.f;
+            }
+            if (actualValue >= maximum) {
+                return 1.f;
+            }
+            return std::floor(std::log2(actualValue) - (float) minimum_exponent + 0.5f) / last_step;
+        }
+
+        float getMinimum() const { return minimum; }
+        float getMaximum() const { return maximum; }
+        int getNumSteps() const { return (int) last_step + 1; }
+
+    private:
+        int minimum_exponent;
+        float last_step, minimum, maximum;
+    };
+
+    /**
+        Interpolates a precomputed curve of another mapping, so toActual() costs
+        a multiply and a linear interpolation instead of exp, log or pow.
+
+        The curve is sampled at Size + 1 evenly spaced normalized values. The
+        error between them depends on how bent the curve is, e.g. about 1e-4
+        relative for a 20 Hz to 20 kHz Logarithmic with 256 points. The
+        endpoints stay exact, and toNormalized() uses the exact inverse as it is
+        rarely called on the audio thread.
+     */
+    template <typename Mapping, int Size = 256>
+    class Table {
+    public:
+        explicit Table(const Mapping& mappingToSample)
+        : mapping(mappingToSample)
+        {
+            for (int i = 0; i <= Size; ++i) {
+                points[i] = mapping.toActual((float) i / Size);
+            }
+        }
+
+        float toActual(float value) const
+        {
+            if (value <= 0.f) {
+                return points[0];
+            }
+            if (value >= 1.f) {
+                return points[Size];
+            }
+
+            const float position = value * Size;
+            const int index = (int) position;
+            const float fraction = position - (float) index;
+            return points[index] + (points[index + 1] - points[index]) * fraction;
+        }
+
+        float toNormalized(float actualValue) const
+        {
+            return mapping.toNormalized(actualValue);
+        }
+
+        float getMinimum() const { return mapping.getMinimum(); }
+        float getMaximum() const { return mapping.getMaximum(); }
+        int getNumSteps() const { return mapping.getNumSteps(); }
+
+    private:
+        Mapping mapping;
+        float points[Size + 1];
+    };
+};
+
+
+#endif  // PARAMETERMAPPING_H_INCLUDED
@@ -0,0 +1,188 @@
+#ifndef PARAMETERREGISTRY_H_INCLUDED
+#define PARAMETERREGISTRY_H_INCLUDED
+
+#include <atomic>
+#include <new>
+
+/**
+    Keeps the normalized values of all parameters in one contiguous array, so
+    reading them all touches a few cache lines instead of one heap object per
+    parameter.
+
+    Values are stored by parameter index in a cache line aligned array of
+    atomics, which PluginParameter::getValue() and setValue() use once the
+    parameter is connected with PluginParameter::setRegistry(). Nothing else
+    is stored with them, so the values of neighbouring parameters share as
+    few cache lines as possible.
+
+    read() copies every value into a Snapshot in a single pass. Writers count
+    the writes they start and finish, and the copy is repeated if a write
+    happened during it, so a snapshot is a consistent view of all values
+    without writers or readers ever waiting on a lock. Slots of parameters that
+    are not PluginParameters stay 0.
+ */
+class ParameterRegistry {
+public:
+    /// The size of the cache lines the values are aligned to.
+    static const int cacheLineSize = 64;
+
+    /// The values of all parameters at one point in time, by parameter index.
+    class Snapshot {
+    public:
+        Snapshot()
+        : values(nullptr),
+        num_values(0)
+        {
+        }
+
+        /// Allocates room for numValues values, all 0.
+        void setSize(int numValues)
+        {
+            num_values = jmax(0, numValues);
+            values = allocateAligned<float>(storage, num_values);
+
+            for (int i = 0; i < num_values; ++i) {
+                values[i] = 0.f;
+            }
+        }
+
+        /// Returns the number of values.
+        int size() const { return num_values; }
+
+        /// Returns the normalized value of the parameter at parameterIndex.
+        float operator[](int parameterIndex) const
+        {
+            jassert(isPositiveAndBelow(parameterIndex, num_values));
+            return values[parameterIndex];
+        }
+
+        /// Returns all values, by parameter index.
+        const float* getValues() const { return values; }
+
+        /// Replaces the value of the parameter at parameterIndex, e.g. when a
+        /// MIDI controller changes it within the block.
+        void set(int parameterIndex, float value)
+        {
+            jassert(isPositiveAndBelow(parameterIndex, num_values));
+            values[parameterIndex] = value;
+        }
+
+    private:
+        friend class ParameterRegistry;
+
+        HeapBlock<char> storage;
+        float* values;
+        int num_values;
+
+        JUCE_DECLARE_NON_COPYABLE(Snapshot)
+    };
+
+    ParameterRegistry()
+    : values(nullptr),
+    num_values(0),
+    writes_started(0),
+    writes_finished(0)
+    {
+    }
+
+    /// Allocates a slot for each parameter and copies the current values of
+    /// the PluginParameters, which may be nullptr for parameters of other
+    /// types. Call this once after all parameters have been added,
+    /// then connect each PluginParameter with PluginParameter::setRegistry().
+    template <typename ParameterType>
+    void setParameters(const Array<ParameterType*>& parameters)
+    {
+        num_values = parameters.size();
+        values = allocateAligned<std::atomic<float>>(value_storage, num_values);
+
+        for (int i = 0; i < num_values; ++i) {
+            const ParameterType* const parameter = parameters[i];
+            new (values + i) std::atomic<float>(parameter != nullptr ? parameter->getValue() : 0.f);
+        }
+    }
+
+    /// Returns the number of slots, one per parameter.
+    int size() const { return num_values; }
+
+    /// Returns the current normalized value of the parameter at parameterIndex.
+    /// Safe to call from any thread.
+    float getValue(int parameterIndex) const
+    {
+        jassert(isPositiveAndBelow(parameterIndex, num_values));
+        return values[parameterIndex].load(std::memory_order_relaxed);
+    }
+
+    /// Sets the normalized value of the parameter at parameterIndex. Safe to
+    /// call from any thread, any number of threads at once.
+    void setValue(int parameterIndex, float value)
+    {
+        jassert(isPositiveAndBelow(parameterIndex, num_values));
+
+        writes_started.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        values[parameterIndex].store(value, std::memory_order_relaxed);
+        writes_finished.fetch_add(1, std::memory_order_release);
+    }
+
+    /** Copies all values into snapshot.
+
+        The copy is repeated up to maximumAttempts times while values are being
+        written during it. Returns true if the snapshot is consistent, or false
+        if writes kept overlapping, in which case each value is still valid but
+        some may be newer than others.
+
+        The snapshot is only allocated if its size differs, so size it with
+        Snapshot::setSize(size()) beforehand to read from the audio thread.
+     */
+    bool read(Snapshot& snapshot, int maximumAttempts = 4) const
+    {
+        if (snapshot.size() != num_values) {
+            snapshot.setSize(num_values);
+        }
+
+        float* const destination = snapshot.values;
+
+        for (int attempt = 0; attempt < jmax(1, maximumAttempts); ++attempt) {
+            const uint32 started = writes_started.load(std::memory_order_acquire);
+            const uint32 finished = writes_finished.load(std::memory_order_acquire);
+
+            for (int i = 0; i < num_values; ++i) {
+                destination[i] = values[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (started == finished && writes_started.load(std::memory_order_relaxed) == started) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    /// Allocates numElements elements of type T from storage, starting at a
+    /// cache line boundary. The elements are not constructed.
+    template <typename T>
+    static T* allocateAligned(HeapBlock<char>& storage, int numElements)
+    {
+        storage.malloc((size_t) jmax(1, numElements) * sizeof(T) + cacheLineSize);
+        const pointer_sized_int address = reinterpret_cast<pointer_sized_int>(storage.getData());
+        return reinterpret_cast<T*>((address + cacheLineSize - 1) & ~(pointer_sized_int) (cacheLineSize - 1));
+    }
+
+    /// The hot values, by parameter index.
+    HeapBlock<char> value_storage;
+    std::atomic<float>* values;
+    int num_values;
+
+    /// The number of writes started and finished, compared by read() to tell
+    /// whether its copy overlapped a write.
+    std::atomic<uint32> writes_started;
+    std::atomic<uint32> writes_finished;
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterRegistry)
+};
+
+
+#endif  // PARAMETERREGISTRY_H_INCLUDED
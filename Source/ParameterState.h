@@ -0,0 +1,280 @@
+#ifndef PARAMETERSTATE_H_INCLUDED
+#define PARAMETERSTATE_H_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "PluginParameter.h"
+
+/**
+    Saves and restores PluginParameter values in a compact, versioned binary
+    format.
+
+    The format is a 16 byte header followed by one fixed size entry per
+    parameter, all little endian:
+
+    | Offset | Size | Header field                                         |
+    |--------|------|------------------------------------------------------|
+    | 0      | 4    | Magic number, "PPST"                                 |
+    | 4      | 2    | Format version                                       |
+    | 6      | 2    | Entry size in bytes, 12 for version 1                |
+    | 8      | 4    | Number of entries                                    |
+    | 12     | 4    | FNV-1a checksum of all entries                       |
+
+    | Offset | Size | Entry field                                          |
+    |--------|------|------------------------------------------------------|
+    | 0      | 8    | FNV-1a hash of PluginParameter::getIdentifier()      |
+    | 8      | 4    | Normalized value as float bits                       |
+
+    Entries are matched to parameters by identifier hash, so parameters can be
+    added, removed or reordered between versions of a plugin. Entries of unknown
+    parameters are skipped and parameters without an entry are reset to their
+    default.
+
+    New fields are appended to each entry without changing the version, and
+    older readers skip them using the entry size. The version only changes for
+    layouts older readers cannot skip, so states with a newer version than
+    this class writes are rejected.
+
+    Saving writes straight into the destination block in a single pass and
+    loading reads straight from the source data, so neither allocates per
+    parameter. Values can be saved from a ParameterRegistry::Snapshot, so the
+    state is a consistent view of all parameters.
+ */
+class ParameterState {
+public:
+    /// The magic number at the start of every state, "PPST".
+    static const uint32 magic = 0x54535050;
+
+    /// The format version written by this class.
+    static const uint16 version = 1;
+
+    /// The size of the header in bytes.
+    static const int headerSize = 16;
+
+    /// The size of an entry written by this version in bytes.
+    static const int entrySize = 12;
+
+    /// Builds the lookup table from identifier hash to parameter. Call this once
+    /// after all parameters have been added. Entries that are nullptr, i.e. not
+    /// PluginParameters, are ignored.
+    void setParameters(const Array<PluginParameter*>& pluginParameters)
+    {
+        parameters.clear();
+        for (int i = 0; i < pluginParameters.size(); ++i) {
+            if (pluginParameters[i] != nullptr) {
+                parameters.add(pluginParameters[i]);
+            }
+        }
+
+        const int numParameters = parameters.size();
+        lookup.malloc((size_t) jmax(1, numParameters));
+        restored.calloc((size_t) jmax(1, numParameters));
+
+        identifier_hashes.malloc((size_t) jmax(1, numParameters));
+        parameter_indices.malloc((size_t) jmax(1, numParameters));
+
+        for (int i = 0; i < numParameters; ++i) {
+            identifier_hashes[i] = parameters[i]->getIdentifierHash();
+            parameter_indices[i] = parameters[i]->getParameterIndex();
+            lookup[i].hash = identifier_hashes[i];
+            lookup[i].index = i;
+        }
+
+        std::sort(lookup.getData(), lookup.getData() + numParameters);
+
+        // Identifiers must be unique
+        for (int i = 1; i < numParameters; ++i) {
+            jassert(lookup[i - 1].hash != lookup[i].hash);
+        }
+    }
+
+    /// Writes the values of all parameters to destination, replacing its
+    /// contents.
+    void save(MemoryBlock& destination) const
+    {
+        write(destination, [this] (int i) { return parameters[i]->getValue(); });
+    }
+
+    /// Writes the values of a snapshot of all parameters to destination,
+    /// replacing its contents.
+    void save(MemoryBlock& destination, const ParameterRegistry::Snapshot& snapshot) const
+    {
+        write(destination, [&] (int i) { return snapshot[parameter_indices[i]]; });
+    }
+
+    /// Restores the parameters from data written by save(). Returns false and
+    /// leaves the parameters untouched if the data is not a valid state or was
+    /// written by a newer, incompatible version.
+    bool load(const void* source, size_t size)
+    {
+        return read(source, size, restored, [this] (int i, float value) { parameters[i]->setValue(value); });
+    }
+
+    /// Decodes data written by save() into values, indexed by parameter index,
+    /// without touching the parameters. Values of parameters that are not
+    /// PluginParameters are left as they are. Returns false and leaves values
+    /// untouched if the data is not a valid state. Does not allocate, and is
+    /// safe to call from any thread while the state is not being loaded.
+    bool decode(const void* source, size_t size, float* values) const
+    {
+        return read(source, size, nullptr, [&] (int i, float value) { values[parameter_indices[i]] = value; });
+    }
+
+private:
+    /// An entry of the lookup table, sorted by hash.
+    struct Lookup {
+        uint64 hash;
+        int index;
+
+        bool operator<(const Lookup& other) const
+        {
+            return hash < other.hash;
+        }
+    };
+
+    /// Reads a state, calling setValue(int i, float value) with the value of
+    /// the i-th saved parameter, or its default if the state has no entry.
+    /// Without restoredFlags to track the entries, every parameter is first
+    /// set to its default.
+    template <typename SetValue>
+    bool read(const void* source, size_t size, bool* restoredFlags, SetValue setValue) const
+    {
+        const uint8* const data = static_cast<const uint8*>(source);
+
+        if (data == nullptr || size < (size_t) headerSize || readUInt32(data) != magic) {
+            return false;
+        }
+
+        const int storedVersion = readUInt16(data + 4);
+        const int storedEntrySize = readUInt16(data + 6);
+        const uint32 numEntries = readUInt32(data + 8);
+
+        if (storedVersion < 1 || storedVersion > version
+            || storedEntrySize < entrySize
+            || (size - headerSize) / (size_t) storedEntrySize < numEntries
+            || readUInt32(data + 12) != checksum(data + headerSize, (size_t) numEntries * storedEntrySize)) {
+            return false;
+        }
+
+        const int numParameters = parameters.size();
+
+        for (int i = 0; i < numParameters; ++i) {
+            if (restoredFlags != nullptr) {
+                restoredFlags[i] = false;
+            }
+            else {
+                setValue(i, parameters[i]->getDefaultValue());
+            }
+        }
+
+        const uint8* entry = data + headerSize;
+        for (uint32 i = 0; i < numEntries; ++i, entry += storedEntrySize) {
+            const int index = findParameter(readUInt64(entry), (int) i);
+            if (index < 0) {
+                continue;
+            }
+
+            const uint32 bits = readUInt32(entry + 8);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+
+            if (std::isfinite(value)) {
+                setValue(index, jlimit(0.f, 1.f, value));
+                if (restoredFlags != nullptr) {
+                    restoredFlags[index] = true;
+                }
+            }
+        }
+
+        for (int i = 0; restoredFlags != nullptr && i < numParameters; ++i) {
+            if (! restoredFlags[i]) {
+                setValue(i, parameters[i]->getDefaultValue());
+            }
+        }
+
+        return true;
+    }
+
+    /// Writes the state with getValue(int i) returning the normalized value of
+    /// the i-th saved parameter.
+    template <typename GetValue>
+    void write(MemoryBlock& destination, GetValue getValue) const
+    {
+        const int numParameters = parameters.size();
+        destination.setSize((size_t) (headerSize + numParameters * entrySize), false);
+
+        uint8* const data = static_cast<uint8*>(destination.getData());
+        uint8* entry = data + headerSize;
+
+        for (int i = 0; i < numParameters; ++i, entry += entrySize) {
+            const float value = getValue(i);
+            uint32 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            writeUInt64(entry, identifier_hashes[i]);
+            writeUInt32(entry + 8, bits);
+        }
+
+        writeUInt32(data, magic);
+        writeUInt16(data + 4, version);
+        writeUInt16(data + 6, (uint16) entrySize);
+        writeUInt32(data + 8, (uint32) numParameters);
+        writeUInt32(data + 12, checksum(data + headerSize, (size_t) numParameters * entrySize));
+    }
+
+    /// Returns the index of the parameter with the given hash, or -1. States
+    /// are usually loaded by the same version of the plugin, so the parameter
+    /// at the entry's position is tried first.
+    int findParameter(uint64 hash, int position) const
+    {
+        const int numParameters = parameters.size();
+
+        if (position < numParameters && identifier_hashes[position] == hash) {
+            return position;
+        }
+
+        Lookup key;
+        key.hash = hash;
+        const Lookup* const begin = lookup.getData();
+        const Lookup* const end = begin + numParameters;
+        const Lookup* const found = std::lower_bound(begin, end, key);
+
+        return found != end && found->hash == hash ? found->index : -1;
+    }
+
+    static uint32 checksum(const uint8* data, size_t size)
+    {
+        uint32 hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    static void writeUInt16(uint8* d, uint16 v) { d[0] = (uint8) v; d[1] = (uint8) (v >> 8); }
+    static void writeUInt32(uint8* d, uint32 v) { writeUInt16(d, (uint16) v); writeUInt16(d + 2, (uint16) (v >> 16)); }
+    static void writeUInt64(uint8* d, uint64 v) { writeUInt32(d, (uint32) v); writeUInt32(d + 4, (uint32) (v >> 32)); }
+
+    static uint16 readUInt16(const uint8* d) { return (uint16) (d[0] | (d[1] << 8)); }
+    static uint32 readUInt32(const uint8* d) { return readUInt16(d) | ((uint32) readUInt16(d + 2) << 16); }
+    static uint64 readUInt64(const uint8* d) { return readUInt32(d) | ((uint64) readUInt32(d + 4) << 32); }
+
+    /// The PluginParameters in the order they are saved.
+    Array<PluginParameter*> parameters;
+
+    /// The identifier hash and parameter index of each parameter, in the order
+    /// they are saved.
+    HeapBlock<uint64> identifier_hashes;
+    HeapBlock<int> parameter_indices;
+
+    /// Identifier hashes sorted for lookup when loading.
+    HeapBlock<Lookup> lookup;
+
+    /// Whether each parameter had an entry in the state being loaded.
+    HeapBlock<bool> restored;
+};
+
+
+#endif  // PARAMETERSTATE_H_INCLUDED
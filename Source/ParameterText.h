@@ -0,0 +1,303 @@
+#ifndef PARAMETERTEXT_H_INCLUDED
+#define PARAMETERTEXT_H_INCLUDED
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+/**
+    Formats and parses actual parameter values as text without allocating.
+
+    Values are formatted with a fixed number of decimal places into a char
+    buffer on the stack, and parsed straight from the characters of a String,
+    so neither uses streams, the locale or the heap. The decimal point is always
+    written as a full stop, and parsed from either a full stop or a comma.
+
+    Each unit formats the actual value in its own way:
+
+    - plain: the number alone, e.g. "0.50". Hosts append the label themselves.
+    - decibels: the value in dB, e.g. "-6.0 dB".
+    - hertz: the value in Hz, shown in kHz from 1000 Hz, e.g. "440 Hz" and
+      "2.50 kHz".
+    - seconds: the value in seconds, shown in ms below 1 s, e.g. "12.5 ms" and
+      "1.50 s".
+    - percent: a fraction shown as a percentage, e.g. 0.5 is "50 %".
+
+    The larger unit of hertz and seconds shows two more decimal places than the
+    precision. Parsing accepts the same text, with or without the unit and in
+    any case. Numbers without a unit are in Hz, ms or percent respectively, and
+    "-inf" parses as negative infinity for the caller to clamp.
+ */
+struct ParameterText {
+    /// How an actual value is shown.
+    enum Unit {
+        plain,
+        decibels,
+        hertz,
+        seconds,
+        percent
+    };
+
+    /// The size of the buffer format() writes to, enough for any float.
+    static const int maximumLength = 64;
+
+    /// The largest number of decimal places formatted.
+    static const int maximumPrecision = 6;
+
+    /// Writes actualValue as text with precision decimal places to text, which
+    /// must hold maximumLength chars, and returns the length of the text.
+    static int format(float actualValue, Unit unit, int precision, char* text)
+    {
+        double value = actualValue;
+        const char* suffix = "";
+
+        switch (unit) {
+            case decibels:
+                suffix = " dB";
+                break;
+
+            case hertz:
+                if (std::abs(value) >= 1000.0) {
+                    value *= 0.001;
+                    precision += 2;
+                    suffix = " kHz";
+                }
+                else {
+                    suffix = " Hz";
+                }
+                break;
+
+            case seconds:
+                if (std::abs(value) < 1.0) {
+                    value *= 1000.0;
+                    suffix = " ms";
+                }
+                else {
+                    precision += 2;
+                    suffix = " s";
+                }
+                break;
+
+            case percent:
+                value *= 100.0;
+                suffix = " %";
+                break;
+
+            case plain:
+                break;
+        }
+
+        int length = formatNumber(value, precision, text);
+        while (*suffix != 0) {
+            text[length++] = *suffix++;
+        }
+        text[length] = 0;
+        return length;
+    }
+
+    /// Parses text formatted by format() or typed by the user. Returns false if
+    /// it does not start with a number.
+    static bool parse(const char* text, Unit unit, float& actualValue)
+    {
+        double value;
+        text = parseNumber(skipSpaces(text), value);
+
+        if (text == nullptr) {
+            return false;
+        }
+
+        text = skipSpaces(text);
+
+        switch (unit) {
+            case hertz:
+                if (startsWith(text, "k")) {
+                    value *= 1000.0;
+                }
+                break;
+
+            case seconds:
+                if (startsWith(text, "ms") || ! startsWith(text, "s")) {
+                    value *= 0.001;
+                }
+                break;
+
+            case percent:
+                value *= 0.01;
+                break;
+
+            case plain:
+            case decibels:
+                break;
+        }
+
+        actualValue = (float) value;
+        return true;
+    }
+
+    /// Writes value with precision decimal places to text, which must hold
+    /// maximumLength chars, and returns the length of the text. Values too large
+    /// for fixed point are written in scientific notation.
+    static int formatNumber(double value, int precision, char* text)
+    {
+        precision = jlimit(0, (int) maximumPrecision, precision);
+
+        uint64 scale = 1;
+        for (int i = 0; i < precision; ++i) {
+            scale *= 10;
+        }
+
+        if (value != value) {
+            return copy("nan", text);
+        }
+
+        if (std::abs(value) * (double) scale >= 1.0e18) {
+            if (std::isinf(value)) {
+                return copy(value < 0.0 ? "-inf" : "inf", text);
+            }
+
+            // Rare enough not to be worth a fast path
+            return snprintf(text, (size_t) maximumLength, "%.*e", precision, value);
+        }
+
+        int length = 0;
+
+        // Rounded to the last decimal place, so e.g. -0.001 with one decimal
+        // place is "0.0" rather than "-0.0"
+        const uint64 scaled = (uint64) (std::abs(value) * (double) scale + 0.5);
+
+        if (value < 0.0 && scaled != 0) {
+            text[length++] = '-';
+        }
+
+        length += formatInteger(scaled / scale, text + length);
+
+        if (precision > 0) {
+            text[length++] = '.';
+
+            uint64 fraction = scaled % scale;
+            for (int i = precision; --i >= 0;) {
+                text[length + i] = (char) ('0' + fraction % 10);
+                fraction /= 10;
+            }
+            length += precision;
+        }
+
+        text[length] = 0;
+        return length;
+    }
+
+    /// Parses a decimal number, optionally signed and with an exponent, or inf.
+    /// Returns the character after the number, or nullptr if there is none.
+    static const char* parseNumber(const char* text, double& value)
+    {
+        bool negative = false;
+        if (*text == '-' || *text == '+') {
+            negative = *text++ == '-';
+        }
+
+        if (startsWith(text, "inf")) {
+            value = negative ? -std::numeric_limits<double>::infinity()
+                             : std::numeric_limits<double>::infinity();
+            return text + 3;
+        }
+
+        double mantissa = 0.0;
+        int exponent = 0;
+        bool hasDigits = false;
+
+        for (; isDigit(*text); ++text) {
+            mantissa = mantissa * 10.0 + (*text - '0');
+            hasDigits = true;
+        }
+
+        if (*text == '.' || *text == ',') {
+            for (++text; isDigit(*text); ++text) {
+                mantissa = mantissa * 10.0 + (*text - '0');
+                --exponent;
+                hasDigits = true;
+            }
+        }
+
+        if (! hasDigits) {
+            return nullptr;
+        }
+
+        if ((*text == 'e' || *text == 'E') && (isDigit(text[1])
+                                                 || ((text[1] == '-' || text[1] == '+') && isDigit(text[2])))) {
+            const bool negativeExponent = *++text == '-';
+            if (*text == '-' || *text == '+') {
+                ++text;
+            }
+
+            int written = 0;
+            for (; isDigit(*text); ++text) {
+                written = jmin(written * 10 + (*text - '0'), 1000);
+            }
+            exponent += negativeExponent ? -written : written;
+        }
+
+        value = mantissa * std::pow(10.0, (double) exponent);
+        if (negative) {
+            value = -value;
+        }
+        return text;
+    }
+
+private:
+    static bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    static const char* skipSpaces(const char* text)
+    {
+        while (*text == ' ' || *text == '\t') {
+            ++text;
+        }
+        return text;
+    }
+
+    /// Returns true if text starts with prefix, ignoring the case of text.
+    /// prefix must be lower case.
+    static bool startsWith(const char* text, const char* prefix)
+    {
+        for (; *prefix != 0; ++text, ++prefix) {
+            const char c = (*text >= 'A' && *text <= 'Z') ? (char) (*text - 'A' + 'a') : *text;
+            if (c != *prefix) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static int copy(const char* source, char* text)
+    {
+        int length = 0;
+        while (source[length] != 0) {
+            text[length] = source[length];
+            ++length;
+        }
+        text[length] = 0;
+        return length;
+    }
+
+    /// Writes the decimal digits of value and returns their number.
+    static int formatInteger(uint64 value, char* text)
+    {
+        char digits[20];
+        int numDigits = 0;
+
+        do {
+            digits[numDigits++] = (char) ('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+
+        for (int i = 0; i < numDigits; ++i) {
+            text[i] = digits[numDigits - 1 - i];
+        }
+        return numDigits;
+    }
+};
+
+
+#endif  // PARAMETERTEXT_H_INCLUDED
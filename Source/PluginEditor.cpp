@@ -1,120 +1,241 @@
-/*
-  ==============================================================================
-
-  This is an automatically generated GUI class created by the Introjucer!
-
-  Be careful when adding custom code to these files, as only the code within
-  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
-  and re-saved.
-
-  Created with Introjucer version: 4.0.2
-
-  ------------------------------------------------------------------------------
-
-  The Introjucer is part of the JUCE library - "Jules' Utility Class Extensions"
-  Copyright (c) 2015 - ROLI Ltd.
-
-  ==============================================================================
-*/
-
-//[Headers] You can add your own extra header files here...
-//[/Headers]
-
-#include "PluginEditor.h"
-
-
-//[MiscUserDefs] You can add your own user definitions and misc code here...
-//[/MiscUserDefs]
-
-//==============================================================================
-PluginEditor::PluginEditor (PluginAudioProcessor& p)
-    : AudioProcessorEditor (&p), processor (p)
-{
-    //[Constructor_pre] You can add your own custom stuff here..
-    //[/Constructor_pre]
-
-
-    //[UserPreSize]
-    //[/UserPreSize]
-
-    setSize (600, 400);
-
-
-    //[Constructor] You can add your own custom stuff here..
-    startTimer (30);
-    //[/Constructor]
-}
-
-PluginEditor::~PluginEditor()
-{
-    //[Destructor_pre]. You can add your own custom destruction code here..
-    //[/Destructor_pre]
-
-
-
-    //[Destructor]. You can add your own custom destruction code here..
-    //[/Destructor]
-}
-
-//==============================================================================
-void PluginEditor::paint (Graphics& g)
-{
-    //[UserPrePaint] Add your own custom painting code here..
-    //[/UserPrePaint]
-
-    g.fillAll (Colour (0xff272727));
-
-    //[UserPaint] Add your own custom painting code here..
-    //[/UserPaint]
-}
-
-void PluginEditor::resized()
-{
-    //[UserPreResize] Add your own custom resize code here..
-    //[/UserPreResize]
-
-    //[UserResized] Add your own custom resize handling here..
-    //[/UserResized]
-}
-
-
-
-//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
-
-/**
-    Updates GUI elements to match host values in an AudioProcessorParameter.
-
-    Timer conflicts cause stuttering when using elements, this is due to
-    the values not being mapped correctly.
-*/
-void PluginEditor::timerCallback() {
-    // E.g. mySlider->setValue(processor.myParam->getActualValue(), dontSendNotification);
-}
-
-//[/MiscUserCode]
-
-
-//==============================================================================
-#if 0
-/*  -- Introjucer information section --
-
-    This is where the Introjucer stores the metadata that describe this GUI layout, so
-    make changes in here at your peril!
-
-BEGIN_JUCER_METADATA
-
-<JUCER_COMPONENT documentType="Component" className="PluginEditor" componentName=""
-                 parentClasses="public AudioProcessorEditor, public Timer" constructorParams="PluginAudioProcessor&amp; p"
-                 variableInitialisers="AudioProcessorEditor (&amp;p), processor (p)"
-                 snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
-                 fixedSize="0" initialWidth="600" initialHeight="400">
-  <BACKGROUND backgroundColour="ff272727"/>
-</JUCER_COMPONENT>
-
-END_JUCER_METADATA
-*/
-#endif
-
-
-//[EndFile] You can add extra defines here...
-//[/EndFile]
+/*
+  ==============================================================================
+
+  This is an automatically generated GUI class created by the Introjucer!
+
+  Be careful when adding custom code to these files, as only the code within
+  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
+  and re-saved.
+
+  Created with Introjucer version: 4.0.2
+
+  ------------------------------------------------------------------------------
+
+  The Introjucer is part of the JUCE library - "Jules' Utility Class Extensions"
+  Copyright (c) 2015 - ROLI Ltd.
+
+  ==============================================================================
+*/
+
+//[Headers] You can add your own extra header files here...
+//[/Headers]
+
+#include "PluginEditor.h"
+
+
+//[MiscUserDefs] You can add your own user definitions and misc code here...
+
+// The timer runs at the active interval while anything changes, and backs off
+// to the idle interval after idleTicksBeforeBackOff callbacks without changes
+static const int activeTimerInterval = 30;
+static const int idleTimerInterval = 250;
+static const int idleTicksBeforeBackOff = 30;
+
+// Returns the y position of a level in a meter bar showing -60 dB to +6 dB
+static float getMeterY (const Rectangle<float>& bar, float decibels)
+{
+    return bar.getBottom() - bar.getHeight() * jlimit (0.f, 1.f, (decibels + 60.f) / 66.f);
+}
+
+//[/MiscUserDefs]
+
+//==============================================================================
+PluginEditor::PluginEditor (PluginAudioProcessor& p)
+    : AudioProcessorEditor (&p), processor (p)
+{
+    //[Constructor_pre] You can add your own custom stuff here..
+    //[/Constructor_pre]
+
+
+    //[UserPreSize]
+    //[/UserPreSize]
+
+    setSize (600, 400);
+
+
+    //[Constructor] You can add your own custom stuff here..
+    lastTimerTime = Time::getMillisecondCounterHiRes();
+    idleTicks = 0;
+
+    profile.numZones = 0;
+    for (int zone = 0; zone < ZoneProfiler::maximumZones; ++zone)
+        worstLoads[zone] = 0.f;
+
+    // Bring every control up to date on the first timer callback
+    processor.getParameterChanges().markAll();
+    startTimer (activeTimerInterval);
+    //[/Constructor]
+}
+
+PluginEditor::~PluginEditor()
+{
+    //[Destructor_pre]. You can add your own custom destruction code here..
+    //[/Destructor_pre]
+
+
+
+    //[Destructor]. You can add your own custom destruction code here..
+    //[/Destructor]
+}
+
+//==============================================================================
+void PluginEditor::paint (Graphics& g)
+{
+    //[UserPrePaint] Add your own custom painting code here..
+    //[/UserPrePaint]
+
+    g.fillAll (Colour (0xff272727));
+
+    //[UserPaint] Add your own custom painting code here..
+
+    // Output meters, one bar per channel filled to the RMS level, with lines at
+    // the peak and held peak. The top turns red once the true peak went over 0 dB
+    const int numChannels = meterBallistics.getNumChannels();
+    const float barWidth = (float) meterBounds.getWidth() / jmax (1, numChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const Rectangle<float> bar (meterBounds.getX() + channel * barWidth, (float) meterBounds.getY(),
+                                    barWidth - 2.f, (float) meterBounds.getHeight());
+
+        g.setColour (Colour (0xff1b1b1b));
+        g.fillRect (bar);
+
+        g.setColour (Colour (0xff3fae5a));
+        g.fillRect (bar.withTop (getMeterY (bar, meterBallistics.getRms (channel))));
+
+        g.setColour (Colour (0xffd8d8d8));
+        g.fillRect (bar.withY (getMeterY (bar, meterBallistics.getPeak (channel))).withHeight (1.f));
+        g.fillRect (bar.withY (getMeterY (bar, meterBallistics.getPeakHold (channel))).withHeight (2.f));
+
+        if (meterBallistics.getTruePeakMaximum (channel) > 0.f)
+        {
+            g.setColour (Colour (0xffe04040));
+            g.fillRect (bar.withHeight (4.f));
+        }
+    }
+
+    // Processing load of each profiled zone as a percentage of the block
+    // deadline: the average and maximum of the last interval, and the worst
+    // spike since the editor was opened. Only shown when profiling is enabled
+    g.setFont (12.f);
+
+    for (int zone = 0; zone < profile.numZones; ++zone)
+    {
+        const ZoneProfiler::ZoneStatistics& statistics = profile.zones[zone];
+        Rectangle<int> line = profilerBounds.withY (profilerBounds.getY() + zone * 16).withHeight (16);
+
+        g.setColour (worstLoads[zone] >= 1.f ? Colour (0xffe04040) : Colour (0xffd8d8d8));
+        g.drawText (processor.getProfiler().getZoneName (zone), line.removeFromLeft (100), Justification::centredLeft, true);
+        g.drawText (String (statistics.averageLoad * 100.f, 1) + "%", line.removeFromLeft (60), Justification::centredRight, false);
+        g.drawText (String (statistics.maximumLoad * 100.f, 1) + "%", line.removeFromLeft (60), Justification::centredRight, false);
+        g.drawText (String (worstLoads[zone] * 100.f, 1) + "%", line.removeFromLeft (60), Justification::centredRight, false);
+    }
+
+
+    //[/UserPaint]
+}
+
+void PluginEditor::resized()
+{
+    //[UserPreResize] Add your own custom resize code here..
+    //[/UserPreResize]
+
+    //[UserResized] Add your own custom resize handling here..
+    meterBounds = Rectangle<int> (getWidth() - 56, 16, 40, getHeight() - 32);
+    profilerBounds = Rectangle<int> (16, getHeight() - 16 - 16 * ZoneProfiler::maximumZones, 280, 16 * ZoneProfiler::maximumZones);
+    //[/UserResized]
+}
+
+
+
+//[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
+
+/**
+    Updates GUI elements to match host values in an AudioProcessorParameter.
+
+    Only parameters whose value was set since the last callback are handled, see
+    parameterChanged(), and only the meter and profiler areas are repainted, so
+    an editor with nothing changing does almost no work. The timer then backs
+    off until something changes again.
+*/
+void PluginEditor::timerCallback() {
+    const bool parametersChanged = processor.getParameterChanges().forEachChanged ([this] (int index) {
+        parameterChanged (index);
+    });
+
+    // Map a parameter armed for MIDI learn, e.g. from a control's popup menu with
+    // processor.getMidiLearn().startLearning (index), to the controller moved since
+    const bool controllerLearned = processor.getMidiLearn().finishLearning();
+
+    // Take the levels measured since the last callback, this never blocks the
+    // audio thread. Without new levels the meters fall as if the output was silent
+    const double now = Time::getMillisecondCounterHiRes();
+    const float elapsedSeconds = (float) ((now - lastTimerTime) * 0.001);
+    lastTimerTime = now;
+
+    const bool hasLevels = processor.getLevelMeter().read (meterLevels);
+    const bool metersChanged = meterBallistics.update (hasLevels ? &meterLevels : nullptr, elapsedSeconds);
+
+    if (metersChanged)
+        repaint (meterBounds);
+
+    // Take the load statistics published since the last callback, if profiling
+    // is enabled
+    const bool profileChanged = processor.getProfiler().read (profile);
+
+    if (profileChanged) {
+        for (int zone = 0; zone < profile.numZones; ++zone)
+            worstLoads[zone] = jmax (worstLoads[zone], profile.zones[zone].maximumLoad);
+
+        repaint (profilerBounds);
+    }
+
+    if (parametersChanged || controllerLearned || metersChanged || profileChanged) {
+        idleTicks = 0;
+        if (getTimerInterval() != activeTimerInterval)
+            startTimer (activeTimerInterval);
+    }
+    else if (++idleTicks >= idleTicksBeforeBackOff && getTimerInterval() < idleTimerInterval) {
+        startTimer (jmin (getTimerInterval() * 2, idleTimerInterval));
+    }
+}
+
+/**
+    Updates the control of a parameter whose value changed.
+
+    Setting the value of a control repaints only that control. Don't send a
+    notification, as the change came from the parameter.
+*/
+void PluginEditor::parameterChanged (int parameterIndex) {
+    // E.g. if (parameterIndex == processor.myParam->getParameterIndex())
+    //          mySlider->setValue(processor.myParam->getActualValue(), dontSendNotification);
+}
+
+//[/MiscUserCode]
+
+
+//==============================================================================
+#if 0
+/*  -- Introjucer information section --
+
+    This is where the Introjucer stores the metadata that describe this GUI layout, so
+    make changes in here at your peril!
+
+BEGIN_JUCER_METADATA
+
+<JUCER_COMPONENT documentType="Component" className="PluginEditor" componentName=""
+                 parentClasses="public AudioProcessorEditor, public Timer" constructorParams="PluginAudioProcessor&amp; p"
+                 variableInitialisers="AudioProcessorEditor (&amp;p), processor (p)"
+                 snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
+                 fixedSize="0" initialWidth="600" initialHeight="400">
+  <BACKGROUND backgroundColour="ff272727"/>
+</JUCER_COMPONENT>
+
+END_JUCER_METADATA
+*/
+#endif
+
+
+//[EndFile] You can add extra defines here...
+//[/EndFile]
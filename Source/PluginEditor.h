@@ -1,75 +1,93 @@
-/*
-  ==============================================================================
-
-  This is an automatically generated GUI class created by the Introjucer!
-
-  Be careful when adding custom code to these files, as only the code within
-  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
-  and re-saved.
-
-  Created with Introjucer version: 4.0.2
-
-  ------------------------------------------------------------------------------
-
-  The Introjucer is part of the JUCE library - "Jules' Utility Class Extensions"
-  Copyright (c) 2015 - ROLI Ltd.
-
-  ==============================================================================
-*/
-
-#ifndef __JUCE_HEADER_F1B68972952BE4__
-#define __JUCE_HEADER_F1B68972952BE4__
-
-//[Headers]     -- You can add your own extra header files here --
-#include "JuceHeader.h"
-#include "PluginProcessor.h"
-//[/Headers]
-
-
-
-//==============================================================================
-/**
-                                                                    //[Comments]
-    Your plugin GUI editor.
-
-    Describe your class and how it works here!
-                                                                    //[/Comments]
-*/
-class PluginEditor  : public AudioProcessorEditor,
-                      public Timer
-{
-public:
-    //==============================================================================
-    PluginEditor (PluginAudioProcessor& p);
-    ~PluginEditor();
-
-    //==============================================================================
-    //[UserMethods]     -- You can add your own custom methods in this section.
-    void timerCallback();
-    //[/UserMethods]
-
-    void paint (Graphics& g);
-    void resized();
-
-
-
-private:
-    //[UserVariables]   -- You can add your own custom variables in this section.
-
-    // This reference is provided as a quick way for your editor to access the
-    // processor object that created it.
-    PluginAudioProcessor& processor;
-
-    //[/UserVariables]
-
-    //==============================================================================
-
-
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEditor)
-};
-
-//[EndFile] You can add extra defines here...
-//[/EndFile]
-
-#endif   // __JUCE_HEADER_F1B68972952BE4__
+/*
+  ==============================================================================
+
+  This is an automatically generated GUI class created by the Introjucer!
+
+  Be careful when adding custom code to these files, as only the code within
+  the "//[xyz]" and "//[/xyz]" sections will be retained when the file is loaded
+  and re-saved.
+
+  Created with Introjucer version: 4.0.2
+
+  ------------------------------------------------------------------------------
+
+  The Introjucer is part of the JUCE library - "Jules' Utility Class Extensions"
+  Copyright (c) 2015 - ROLI Ltd.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_HEADER_F1B68972952BE4__
+#define __JUCE_HEADER_F1B68972952BE4__
+
+//[Headers]     -- You can add your own extra header files here --
+#include "JuceHeader.h"
+#include "PluginProcessor.h"
+#include "MeterBallistics.h"
+//[/Headers]
+
+
+
+//==============================================================================
+/**
+                                                                    //[Comments]
+    Your plugin GUI editor.
+
+    Describe your class and how it works here!
+                                                                    //[/Comments]
+*/
+class PluginEditor  : public AudioProcessorEditor,
+                      public Timer
+{
+public:
+    //==============================================================================
+    PluginEditor (PluginAudioProcessor& p);
+    ~PluginEditor();
+
+    //==============================================================================
+    //[UserMethods]     -- You can add your own custom methods in this section.
+    void timerCallback();
+    void parameterChanged (int parameterIndex);
+    //[/UserMethods]
+
+    void paint (Graphics& g);
+    void resized();
+
+
+
+private:
+    //[UserVariables]   -- You can add your own custom variables in this section.
+
+    // This reference is provided as a quick way for your editor to access the
+    // processor object that created it.
+    PluginAudioProcessor& processor;
+
+    // The output levels last read from the processor, and the meter values
+    // shown for them
+    LevelMeter::Levels meterLevels;
+    MeterBallistics meterBallistics;
+    Rectangle<int> meterBounds;
+    double lastTimerTime;
+
+    // The processing load last read from the profiler, and the highest load
+    // of each zone since the editor was opened
+    ZoneProfiler::Snapshot profile;
+    float worstLoads[ZoneProfiler::maximumZones];
+    Rectangle<int> profilerBounds;
+
+    // The number of timer callbacks in a row in which nothing changed
+    int idleTicks;
+
+    //[/UserVariables]
+
+    //==============================================================================
+
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEditor)
+};
+
+//[EndFile] You can add extra defines here...
+//[/EndFile]
+
+#endif   // __JUCE_HEADER_F1B68972952BE4__
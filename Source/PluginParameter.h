@@ -1,260 +1,670 @@
-#ifndef PLUGINPARAMETER_H_INCLUDED
-#define PLUGINPARAMETER_H_INCLUDED
-
-#include <functional>
-#include <iomanip>
-#include <sstream>
-
-/** 
-    Handles all parameter value mapping and conversion.
- 
-    JUCE handles all parameters as normalized float values, but parameters are eaiser
-    to understand using their actual values. This class abstracts the handling and
-    conversion between the parameters normalized and actual values.
- 
-    The parameter value is wrapped using JUCE's Atomic class to make the value thread
-    safe.
- 
-    Requires C++11.
- */
-class PluginParameter : public AudioProcessorParameter {
-private:
-    /// The parameter identifier, or id. This value is never changed after
-    /// construction.
-    Identifier identifier;
-    
-    /// The name of the parameter.
-    String name;
-    
-    /// The suffix label, e.g. the unit of the actual value. This value is
-    /// never changed after construction.
-    String label;
-    
-    /// The normalized default parameter value, used by JUCE. This value is
-    /// never changed after construction.
-    float default_value;
-    
-    /// The normalized parameter value, used by JUCE.
-    Atomic<float> value;
-    
-    /// The minimum actual parameter value. This value is never changed after
-    /// construction.
-    float actual_minimum;
-    
-    /// The maximum actual parameter value. This value is never changed after
-    /// construction.
-    float actual_maximum;
-    
-    /// The precision of the actual value displayed as text. The number of decimal
-    /// places printed.
-    int precision;
-    
-    /// The callback used after the parameter value has been updated. The argument
-    /// passed to this callback is the actual parameter value.
-    std::function<void(float)> callback;
-    
-public:
-    /** 
-        Creates a parameter from a normalized value.
-     
-        The given identifier must be unique and never change in code. It is used
-        for keeping track of parameters when saving and loading state.
-     
-        The formatString is not checked, so if it is not valid the parameter value
-        may not be formatted correctly, or even display, when calling getText().
-     */
-    PluginParameter (Identifier parameterId,
-                     float defaultParameterValue,
-                     const String& parameterName,
-                     const String& parameterLabel = String::empty,
-                     const int precision = 0,
-                     std::function<void(float)> callback = nullptr)
-    : identifier(parameterId),
-    name(parameterName),
-    label(parameterLabel),
-    default_value(defaultParameterValue),
-    precision(precision),
-    callback(callback)
-    {
-        actual_minimum = 0.f;
-        actual_maximum = 1.f;
-        setValue(defaultParameterValue);
-    }
-    
-    /** 
-        Creates a parameter from an actual value and range.
-     
-        Creates a parameter from an actual value and range, the actual value
-        will be set to the default and the normalized values will be calculated.
-        The given identifier must be unique and never change in code. It is used
-        for keeping track of parameters when saving and loading state.
-     */
-    PluginParameter(Identifier parameterId,
-                    float actualDefaultValue,
-                    float actualMinimum,
-                    float actualMaximum,
-                    const String& parameterName,
-                    const String& parameterLabel = String::empty,
-                    const int precision = 0,
-                    std::function<void(float)> callback = nullptr)
-    : identifier(parameterId),
-    name(parameterName),
-    label(parameterLabel),
-    actual_minimum(actualMinimum),
-    actual_maximum(actualMaximum),
-    precision(precision),
-    callback(callback)
-    {
-        default_value = calculateValue(actualDefaultValue);
-        setValue(default_value);
-    }
-    
-    /// Default destructor
-    virtual ~PluginParameter() {};
-    
-    /// Returns the parameter identifier
-    Identifier getIdentifier() const
-    {
-        return identifier;
-    }
-
-    /** Returns the normalized value corresponding to the given actual value.
-     
-        Returns the normalized value corresponding to the given value within the
-        range of the actual parameter values.
-     
-        This class does not provide any set methods using actual parameter values,
-        so use this to convert actual values to normalized values for usage in
-        general JUCE code and to set the parameter value.
-     
-        One such case occurs when assigning slider values to parameters from an
-        audio plugin editor.
-     
-        `parameter->setValueNotifyingHost(processor->calculateValue(actual_value));`
-     
-        This approach allows works so long as the range of the actual parameter values
-        has been specified prior and if the given actual value is within the range.
-     */
-    float calculateValue(float actualValue) const
-    {
-        return (actualValue - actual_minimum) / (actual_maximum - actual_minimum);
-    }
-    
-    /// Returns the actual value corresponding to the given normalized value within
-    /// the range of the actual parameter values.
-    float calculateActualValue(float value) const
-    {
-        return actual_minimum + (actual_maximum - actual_minimum) * value;
-    }
-    
-    /// Returns the actual parameter value calculated from the parameter range and
-    /// normalized value.
-    float getActualValue() const
-    {
-        return calculateActualValue(value.get());
-    }
-
-    /// Returns the actual default parameter value calculated from the parameter
-    /// range and normalized default value.
-    float getActualDefaultValue() const
-    {
-        return calculateActualValue(default_value);
-    }
-    
-    /// Returns the acutal minimum value of the parameter.
-    float getActualMinimum() const
-    {
-        return actual_minimum;
-    }
-    
-    /// Returns the actual maximum value of the parameter.
-    float getActualMaximum() const
-    {
-        return actual_maximum;
-    }
-
-    /// Prints the values of all private variables. This is for debugging purposes.
-    void printState()
-    {
-        std::cout
-        << "PluginParameter\n"
-        << "\tName: " << name
-        << "\tLabel: " << label << "\n"
-        << "\tValue: " << value.get() << "\tDefault: " << default_value
-        << "\tActual: " << calculateActualValue(value.get()) << label
-        << "\tDefault: " << calculateActualValue(default_value) << label
-        << "\tRange: [" << actual_minimum << label
-        << ", " << actual_maximum << label << "]\n";
-    }
-
-    // =======================================================
-    // Inherited from AudioProcessorParameter
-    // =======================================================
-    
-    /// Returns the value of the parameter.
-    ///
-    /// The return value is a normalized float within 0 - 1.f.
-    float getValue() const override
-    {
-        return value.get();
-    }
-    
-    /// Sets the value of the parameter.
-    ///
-    /// The new value must be a float within 0 - 1.f.
-    void setValue(float newValue) override
-    {
-        value.set(newValue);
-        if (callback != nullptr) {
-            callback(getValue());
-        }
-    }
-
-    /// Returns the default value of the parameter.
-    ///
-    /// The return value is a normalized float within 0 - 1.f.
-    float getDefaultValue() const override
-    {
-        return default_value;
-    }
-    
-    /// Returns the name of the parameter, made to fit a given stirng length.
-    String getName(int maximumStringLength) const override
-    {
-        if (maximumStringLength < name.length()) {
-            return name.substring(0, maximumStringLength - 1);
-        }
-        else {
-            return name;
-        }
-        
-    }
-    
-    /// Returns the label of a parameter.
-    String getLabel() const override
-    {
-        return label;
-    }
-    
-    /// Returns the actual parameter value as a string with a label.
-    virtual String getText(float value, int stringLength) const override
-    {
-        std::ostringstream ss;
-        ss  << std::fixed
-            << std::setprecision(precision)
-            << calculateActualValue(value);
-        return ss.str();
-    }
-    
-    /// Parses a string and returns interpreted normalized value.
-    virtual float getValueForText(const String& text) const override
-    {
-        return text.getFloatValue();
-    }
-    
-    // getNumStemps() is not implemented for continuous ranges, default implementation
-    // calls getDefaultNumParameterSteps().
-};
-
-
-#endif  // PLUGINPARAMETER_H_INCLUDED
+#ifndef PLUGINPARAMETER_H_INCLUDED
+#define PLUGINPARAMETER_H_INCLUDED
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+#include "ParameterChangeFlags.h"
+#include "ParameterRegistry.h"
+#include "ParameterText.h"
+
+/** 
+    Handles all parameter value mapping and conversion.
+ 
+    JUCE handles all parameters as normalized float values, but parameters are eaiser
+    to understand using their actual values. This class abstracts the handling and
+    conversion between the parameters normalized and actual values.
+ 
+    The parameter value is wrapped using JUCE's Atomic class to make the value thread
+    safe. Once connected to a ParameterRegistry, the value is kept in the
+    registry's contiguous array instead, so the processor can snapshot all
+    values at once.
+ 
+    Values are shown as text in the unit chosen with setUnit(), without streams
+    or allocations, see ParameterText. The text of the last value is cached, as
+    hosts ask for it again every time they redraw.
+ 
+    Parameters can optionally be smoothed for use on the audio thread. Choose a
+    smoothing type with setSmoothing(), allocate the smoothing buffer from
+    prepareToPlay() with prepareSmoothing(), then call smoothBlock() once per
+    processed block to get a per sample ramp of actual values.
+ 
+    If the parameter is connected to callback flags, setValue() only stores the
+    value and marks the parameter, and the processor runs the callback later on
+    the audio thread with the value stored last. Any number of threads can set
+    values at once, e.g. host automation, the editor and a state being loaded.
+    If it is connected to change flags, setValue() also marks it as changed for
+    the editor.
+ 
+    Requires C++11.
+ */
+class PluginParameter : public AudioProcessorParameter {
+public:
+    /// The shape of the ramp used when smoothing parameter changes.
+    enum SmoothingType {
+        noSmoothing,                ///< Changes jump at the start of the next block
+        linearSmoothing,            ///< The actual value ramps linearly
+        multiplicativeSmoothing     ///< The actual value ramps exponentially, e.g. for
+                                    ///< frequencies. The range must not include zero.
+    };
+    
+private:
+    /// The parameter identifier, or id. This value is never changed after
+    /// construction.
+    Identifier identifier;
+    
+    /// The FNV-1a hash of the identifier, used to find the parameter when
+    /// loading state. This value is never changed after construction.
+    uint64 identifier_hash;
+    
+    /// The name of the parameter.
+    String name;
+    
+    /// The suffix label, e.g. the unit of the actual value. This value is
+    /// never changed after construction.
+    String label;
+    
+    /// The normalized default parameter value, used by JUCE. This value is
+    /// never changed after construction.
+    float default_value;
+    
+    /// The normalized parameter value, used by JUCE while the parameter is
+    /// not connected to a registry.
+    Atomic<float> value;
+    
+    /// The registry holding the normalized value, or nullptr to use value.
+    ParameterRegistry* registry = nullptr;
+    
+    /// The slot of the value in registry, i.e. the parameter index.
+    int registry_slot = 0;
+    
+    /// The minimum actual parameter value. This value is never changed after
+    /// construction.
+    float actual_minimum;
+    
+    /// The maximum actual parameter value. This value is never changed after
+    /// construction.
+    float actual_maximum;
+    
+    /// The precision of the actual value displayed as text. The number of decimal
+    /// places printed.
+    int precision;
+    
+    /// The unit the actual value is shown in as text.
+    ParameterText::Unit unit = ParameterText::plain;
+    
+    /// The normalized value whose text is cached, or NaN if none is.
+    mutable float cached_text_value = std::numeric_limits<float>::quiet_NaN();
+    
+    /// The text of cached_text_value.
+    mutable String cached_text;
+    
+    /// Guards the cached text, as hosts may ask for it from several threads.
+    mutable SpinLock text_cache_lock;
+    
+    /// The callback used after the parameter value has been updated. The argument
+    /// passed to this callback is the actual parameter value.
+    std::function<void(float)> callback;
+    
+    /// The flags marked for the processor to run the callback, or nullptr to
+    /// run the callback directly from setValue().
+    ParameterChangeFlags* callback_flags = nullptr;
+    
+    /// The flags marked when the value is set, or nullptr.
+    ParameterChangeFlags* change_flags = nullptr;
+    
+    /// The type of ramp used to smooth changes of the actual value.
+    SmoothingType smoothing_type = noSmoothing;
+    
+    /// The length of a ramp in seconds.
+    float smoothing_time = 0.f;
+    
+    /// The length of a ramp in samples, calculated in prepareSmoothing().
+    int smoothing_steps = 0;
+    
+    /// The actual value being ramped towards. Only used on the audio thread.
+    float smoothed_target = 0.f;
+    
+    /// The actual value at the end of the last smoothed block. Only used on the
+    /// audio thread.
+    float smoothed_current = 0.f;
+    
+    /// The per sample increment (linear) or ratio (multiplicative) of the ramp.
+    float smoothed_step = 0.f;
+    
+    /// The number of samples left in the current ramp.
+    int smoothed_countdown = 0;
+    
+    /// The per sample actual values of the last smoothed block.
+    HeapBlock<float> smoothed_buffer;
+    
+    /// The number of samples allocated for smoothed_buffer.
+    int smoothed_buffer_size = 0;
+    
+public:
+    /** 
+        Creates a parameter from a normalized value.
+     
+        The given identifier must be unique and never change in code. It is used
+        for keeping track of parameters when saving and loading state.
+     
+        The formatString is not checked, so if it is not valid the parameter value
+        may not be formatted correctly, or even display, when calling getText().
+     */
+    PluginParameter (Identifier parameterId,
+                     float defaultParameterValue,
+                     const String& parameterName,
+                     const String& parameterLabel = String::empty,
+                     const int precision = 0,
+                     std::function<void(float)> callback = nullptr)
+    : identifier(parameterId),
+    identifier_hash(hashIdentifier(parameterId)),
+    name(parameterName),
+    label(parameterLabel),
+    default_value(defaultParameterValue),
+    precision(precision),
+    callback(callback)
+    {
+        actual_minimum = 0.f;
+        actual_maximum = 1.f;
+        setValue(defaultParameterValue);
+    }
+    
+    /** 
+        Creates a parameter from an actual value and range.
+     
+        Creates a parameter from an actual value and range, the actual value
+        will be set to the default and the normalized values will be calculated.
+        The given identifier must be unique and never change in code. It is used
+        for keeping track of parameters when saving and loading state.
+     */
+    PluginParameter(Identifier parameterId,
+                    float actualDefaultValue,
+                    float actualMinimum,
+                    float actualMaximum,
+                    const String& parameterName,
+                    const String& parameterLabel = String::empty,
+                    const int precision = 0,
+                    std::function<void(float)> callback = nullptr)
+    : identifier(parameterId),
+    identifier_hash(hashIdentifier(parameterId)),
+    name(parameterName),
+    label(parameterLabel),
+    actual_minimum(actualMinimum),
+    actual_maximum(actualMaximum),
+    precision(precision),
+    callback(callback)
+    {
+        default_value = calculateValue(actualDefaultValue);
+        setValue(default_value);
+    }
+    
+    /// Default destructor
+    virtual ~PluginParameter() {};
+    
+    /// Returns the parameter identifier
+    Identifier getIdentifier() const
+    {
+        return identifier;
+    }
+    
+    /// Returns the hash of the parameter identifier, which never changes between
+    /// platforms or versions.
+    uint64 getIdentifierHash() const
+    {
+        return identifier_hash;
+    }
+    
+    /// Returns the FNV-1a hash of an identifier.
+    static uint64 hashIdentifier(const Identifier& identifier)
+    {
+        uint64 hash = 14695981039346656037ULL;
+        for (const char* c = identifier.toString().toRawUTF8(); *c != 0; ++c) {
+            hash = (hash ^ (uint8) *c) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    /** Returns the normalized value corresponding to the given actual value.
+     
+        Returns the normalized value corresponding to the given value within the
+        range of the actual parameter values.
+     
+        This class does not provide any set methods using actual parameter values,
+        so use this to convert actual values to normalized values for usage in
+        general JUCE code and to set the parameter value.
+     
+        One such case occurs when assigning slider values to parameters from an
+        audio plugin editor.
+     
+        `parameter->setValueNotifyingHost(processor->calculateValue(actual_value));`
+     
+        This approach allows works so long as the range of the actual parameter values
+        has been specified prior and if the given actual value is within the range.
+     
+        The range is mapped linearly, see MappedParameter for other mappings.
+     */
+    virtual float calculateValue(float actualValue) const
+    {
+        return (actualValue - actual_minimum) / (actual_maximum - actual_minimum);
+    }
+    
+    /// Returns the actual value corresponding to the given normalized value within
+    /// the range of the actual parameter values.
+    virtual float calculateActualValue(float value) const
+    {
+        return actual_minimum + (actual_maximum - actual_minimum) * value;
+    }
+    
+    /// Returns the actual parameter value calculated from the parameter range and
+    /// normalized value.
+    float getActualValue() const
+    {
+        return calculateActualValue(getValue());
+    }
+
+    /// Returns the actual default parameter value calculated from the parameter
+    /// range and normalized default value.
+    float getActualDefaultValue() const
+    {
+        return calculateActualValue(default_value);
+    }
+    
+    /// Returns the acutal minimum value of the parameter.
+    float getActualMinimum() const
+    {
+        return actual_minimum;
+    }
+    
+    /// Returns the actual maximum value of the parameter.
+    float getActualMaximum() const
+    {
+        return actual_maximum;
+    }
+    
+    /** Defers the callback to the thread that takes the marked parameters from
+        flags.
+     
+        The processor connects all of its PluginParameters to its flags after
+        construction, so callbacks run on the audio thread at block boundaries.
+     */
+    void setCallbackFlags(ParameterChangeFlags* flags)
+    {
+        callback_flags = flags;
+    }
+    
+    /** Marks the parameter in flags whenever its value is set.
+     
+        The processor connects all of its PluginParameters to its flags, so the
+        editor can update only the controls of parameters that changed.
+     */
+    void setChangeFlags(ParameterChangeFlags* flags)
+    {
+        change_flags = flags;
+    }
+    
+    /** Keeps the value in the slot of registry at the parameter index instead
+        of in the parameter.
+     
+        The processor connects all of its PluginParameters to its registry after
+        ParameterRegistry::setParameters(), so their values sit next to each
+        other and can be snapshot per block.
+     */
+    void setRegistry(ParameterRegistry* newRegistry)
+    {
+        if (newRegistry != nullptr) {
+            const float currentValue = getValue();
+            registry_slot = getParameterIndex();
+            newRegistry->setValue(registry_slot, currentValue);
+        }
+        else if (registry != nullptr) {
+            value.set(registry->getValue(registry_slot));
+        }
+        registry = newRegistry;
+    }
+    
+    /// Sets the normalized value and marks it for the editor, without marking it
+    /// for the callback or running the callback. Used by the processor to switch
+    /// programs on the audio thread, where it runs the callbacks itself.
+    void storeValue(float newValue)
+    {
+        if (registry != nullptr) {
+            registry->setValue(registry_slot, newValue);
+        }
+        else {
+            value.set(newValue);
+        }
+        if (change_flags != nullptr) {
+            change_flags->mark(getParameterIndex());
+        }
+    }
+
+    /// Runs the callback with the given normalized value. Used by the processor
+    /// when handling the parameters marked in the callback flags.
+    void performCallback(float newValue) const
+    {
+        if (callback != nullptr) {
+            callback(newValue);
+        }
+    }
+    
+    /** Sets the unit the actual value is shown in by getText().
+     
+        With any unit other than ParameterText::plain the text includes the unit,
+        e.g. "2.50 kHz", and getLabel() returns an empty string so hosts do not
+        show it twice. Call this from the constructor of your processor.
+     */
+    void setUnit(ParameterText::Unit newUnit)
+    {
+        const SpinLock::ScopedLockType lock(text_cache_lock);
+        unit = newUnit;
+        cached_text_value = std::numeric_limits<float>::quiet_NaN();
+    }
+    
+    /// Returns the unit the actual value is shown in.
+    ParameterText::Unit getUnit() const
+    {
+        return unit;
+    }
+    
+    // =======================================================
+    // Smoothing
+    // =======================================================
+    
+    /** Sets the type and length of the ramp used to smooth parameter changes.
+     
+        This should be called from the constructor of your processor, or at least
+        before prepareToPlay(). Multiplicative smoothing falls back to linear
+        smoothing if the actual range includes zero.
+     */
+    void setSmoothing(SmoothingType type, float rampLengthSeconds)
+    {
+        if (type == multiplicativeSmoothing && actual_minimum * actual_maximum <= 0.f) {
+            jassertfalse;
+            type = linearSmoothing;
+        }
+        
+        smoothing_type = type;
+        smoothing_time = rampLengthSeconds;
+    }
+    
+    /// Returns the type of ramp used to smooth parameter changes.
+    SmoothingType getSmoothingType() const
+    {
+        return smoothing_type;
+    }
+    
+    /** Allocates the smoothing buffer and jumps to the current value.
+     
+        Call this from prepareToPlay(). The number of samples later passed to
+        smoothBlock() must never exceed maximumBlockSize.
+     */
+    void prepareSmoothing(double sampleRate, int maximumBlockSize)
+    {
+        smoothing_steps = smoothing_type == noSmoothing
+                        ? 0
+                        : (int) std::floor(smoothing_time * sampleRate);
+        
+        if (maximumBlockSize > smoothed_buffer_size) {
+            smoothed_buffer.malloc((size_t) maximumBlockSize);
+            smoothed_buffer_size = maximumBlockSize;
+        }
+        
+        smoothed_target = smoothed_current = getActualValue();
+        smoothed_countdown = 0;
+    }
+    
+    /** Advances the smoothed value by a block of samples.
+     
+        Returns false if the parameter is not ramping during this block, in which
+        case getSmoothedValue() is constant and the buffer is not touched. This is
+        the fast path and costs an atomic load and a compare.
+     
+        Returns true if the parameter is ramping, in which case getSmoothedBlock()
+        holds one actual value per sample for the next numSamples samples.
+     
+        Only call this from the audio thread.
+     */
+    bool smoothBlock(int numSamples)
+    {
+        const float target = getActualValue();
+        
+        if (target != smoothed_target) {
+            smoothed_target = target;
+            startRamp();
+        }
+        
+        if (smoothed_countdown == 0) {
+            return false;
+        }
+        
+        jassert(numSamples <= smoothed_buffer_size);
+        numSamples = jmin(numSamples, smoothed_buffer_size);
+        
+        float* const output = smoothed_buffer;
+        const int numRamped = jmin(numSamples, smoothed_countdown);
+        
+        if (smoothing_type == multiplicativeSmoothing) {
+            fillMultiplicativeRamp(output, numRamped);
+        }
+        else {
+            fillLinearRamp(output, numRamped);
+        }
+        
+        smoothed_countdown -= numRamped;
+        
+        if (smoothed_countdown == 0) {
+            smoothed_current = smoothed_target;
+            for (int i = numRamped; i < numSamples; ++i) {
+                output[i] = smoothed_target;
+            }
+        }
+        else {
+            smoothed_current = output[numRamped - 1];
+        }
+        
+        return true;
+    }
+    
+    /// Returns true if a ramp is still in progress, which the next call to
+    /// smoothBlock() continues. After the block that finishes a ramp this is
+    /// false, even though that call to smoothBlock() returned true.
+    bool isSmoothing() const
+    {
+        return smoothed_countdown > 0;
+    }
+    
+    /// Returns the smoothed actual value at the end of the last smoothed block.
+    float getSmoothedValue() const
+    {
+        return smoothed_current;
+    }
+    
+    /// Returns the per sample actual values written by the last call to
+    /// smoothBlock() that returned true.
+    const float* getSmoothedBlock() const
+    {
+        return smoothed_buffer;
+    }
+
+    /// Prints the values of all private variables. This is for debugging purposes.
+    void printState()
+    {
+        std::cout
+        << "PluginParameter\n"
+        << "\tName: " << name
+        << "\tLabel: " << label << "\n"
+        << "\tValue: " << getValue() << "\tDefault: " << default_value
+        << "\tActual: " << calculateActualValue(getValue()) << label
+        << "\tDefault: " << calculateActualValue(default_value) << label
+        << "\tRange: [" << actual_minimum << label
+        << ", " << actual_maximum << label << "]\n";
+    }
+
+protected:
+    /// Sets the actual range reported by getActualMinimum() and
+    /// getActualMaximum(). Only call this from the constructor of a subclass.
+    void setActualRange(float actualMinimum, float actualMaximum)
+    {
+        actual_minimum = actualMinimum;
+        actual_maximum = actualMaximum;
+    }
+
+public:
+    // =======================================================
+    // Inherited from AudioProcessorParameter
+    // =======================================================
+    
+    /// Returns the value of the parameter.
+    ///
+    /// The return value is a normalized float within 0 - 1.f.
+    float getValue() const override
+    {
+        return registry != nullptr ? registry->getValue(registry_slot) : value.get();
+    }
+    
+    /// Sets the value of the parameter.
+    ///
+    /// The new value must be a float within 0 - 1.f.
+    void setValue(float newValue) override
+    {
+        storeValue(newValue);
+        if (callback_flags != nullptr) {
+            callback_flags->mark(getParameterIndex());
+        }
+        else {
+            performCallback(newValue);
+        }
+    }
+
+    /// Returns the default value of the parameter.
+    ///
+    /// The return value is a normalized float within 0 - 1.f.
+    float getDefaultValue() const override
+    {
+        return default_value;
+    }
+    
+    /// Returns the name of the parameter, made to fit a given stirng length.
+    String getName(int maximumStringLength) const override
+    {
+        if (maximumStringLength < name.length()) {
+            return name.substring(0, maximumStringLength - 1);
+        }
+        else {
+            return name;
+        }
+        
+    }
+    
+    /// Returns the label of a parameter, or an empty string if getText()
+    /// includes the unit.
+    String getLabel() const override
+    {
+        return unit == ParameterText::plain ? label : String();
+    }
+    
+    /// Returns the actual parameter value as a string, with its unit unless the
+    /// unit is ParameterText::plain.
+    ///
+    /// The text is formatted on the stack and the last one is cached, so asking
+    /// again for the same value only copies a reference counted String.
+    virtual String getText(float value, int stringLength) const override
+    {
+        const SpinLock::ScopedTryLockType lock(text_cache_lock);
+        
+        if (lock.isLocked() && value == cached_text_value) {
+            return cached_text;
+        }
+        
+        char text[ParameterText::maximumLength];
+        const int length = ParameterText::format(calculateActualValue(value), unit, precision, text);
+        const String result(text, (size_t) length);
+        
+        if (lock.isLocked()) {
+            cached_text_value = value;
+            cached_text = result;
+        }
+        return result;
+    }
+    
+    /// Parses a string as an actual value in the parameter's unit and returns
+    /// the normalized value, clamped to 0 - 1.f. Text that is not a number
+    /// returns the current value.
+    virtual float getValueForText(const String& text) const override
+    {
+        float actualValue;
+        if (! ParameterText::parse(text.toRawUTF8(), unit, actualValue)) {
+            return getValue();
+        }
+        return jlimit(0.f, 1.f, calculateValue(actualValue));
+    }
+    
+    // getNumStemps() is not implemented for continuous ranges, default implementation
+    // calls getDefaultNumParameterSteps().
+    
+private:
+    /// Calculates the step of a new ramp from the current to the target value.
+    void startRamp()
+    {
+        if (smoothing_steps <= 0) {
+            smoothed_current = smoothed_target;
+            smoothed_countdown = 0;
+            return;
+        }
+        
+        smoothed_countdown = smoothing_steps;
+        
+        if (smoothing_type == multiplicativeSmoothing) {
+            smoothed_step = std::exp(std::log(smoothed_target / smoothed_current)
+                                     / smoothing_steps);
+        }
+        else {
+            smoothed_step = (smoothed_target - smoothed_current) / smoothing_steps;
+        }
+    }
+    
+    /// Writes a linear ramp continuing from the current value. Each sample only
+    /// depends on its index, so the loop vectorizes.
+    void fillLinearRamp(float* output, int numSamples) const
+    {
+        const float start = smoothed_current;
+        const float step = smoothed_step;
+        
+        for (int i = 0; i < numSamples; ++i) {
+            output[i] = start + step * (float) (i + 1);
+        }
+    }
+    
+    /// Writes a multiplicative ramp continuing from the current value. The ramp
+    /// is split over four independent lanes so the multiplies do not form a
+    /// single dependency chain.
+    void fillMultiplicativeRamp(float* output, int numSamples) const
+    {
+        float lanes[4];
+        lanes[0] = smoothed_current * smoothed_step;
+        lanes[1] = lanes[0] * smoothed_step;
+        lanes[2] = lanes[1] * smoothed_step;
+        lanes[3] = lanes[2] * smoothed_step;
+        
+        const float stride = (smoothed_step * smoothed_step)
+                           * (smoothed_step * smoothed_step);
+        
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4) {
+            for (int lane = 0; lane < 4; ++lane) {
+                output[i + lane] = lanes[lane];
+                lanes[lane] *= stride;
+            }
+        }
+        
+        for (int lane = 0; i < numSamples; ++i, ++lane) {
+            output[i] = lanes[lane];
+        }
+    }
+};
+
+
+#endif  // PLUGINPARAMETER_H_INCLUDED
@@ -1,176 +1,653 @@
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-PluginAudioProcessor::PluginAudioProcessor()
-{
-    // If you're using PluginParameter, create lambda callbacks
-    // auto myCallback = [this] (float value) { ... };
-    
-    // Create and add parameters
-    // addParameter(myParameter = new ...);
-}
-
-PluginAudioProcessor::~PluginAudioProcessor()
-{
-}
-
-//==============================================================================
-const String PluginAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-const String PluginAudioProcessor::getInputChannelName (int channelIndex) const
-{
-    return String (channelIndex + 1);
-}
-
-const String PluginAudioProcessor::getOutputChannelName (int channelIndex) const
-{
-    return String (channelIndex + 1);
-}
-
-bool PluginAudioProcessor::isInputChannelStereoPair (int index) const
-{
-    return true;
-}
-
-bool PluginAudioProcessor::isOutputChannelStereoPair (int index) const
-{
-    return true;
-}
-
-bool PluginAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool PluginAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool PluginAudioProcessor::silenceInProducesSilenceOut() const
-{
-    return false;
-}
-
-double PluginAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int PluginAudioProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
-}
-
-int PluginAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void PluginAudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const String PluginAudioProcessor::getProgramName (int index)
-{
-    return String();
-}
-
-void PluginAudioProcessor::changeProgramName (int index, const String& newName)
-{
-}
-
-//==============================================================================
-void PluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    // Use this method as the place to do any pre-playback
-    // initialisation that you need..
-}
-
-void PluginAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-void PluginAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
-{
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // I've added this to avoid people getting screaming feedback
-    // when they first compile the plugin, but obviously you don't need to
-    // this code if your algorithm already fills all the output channels.
-    for (int i = getNumInputChannels(); i < getNumOutputChannels(); ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
-
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    
-    // Generally, effects will be stereo only so this is a better approach,
-    // if you're trying to program for more channels try the default 
-    // code included below this for loop
-    float* leftChannel  = buffer.getWritePointer (0);
-    float* rightChannel = buffer.getWritePointer (1);
-    
-    for (int i = 0; i < buffer.getNumSamples(); i++)
-    {
-        float leftSample  = leftChannel[i];
-        float rightSample = rightChannel[i];
-    }
-
-    // Default JUCE multichannel processing loop
-    /*
-    for (int channel = 0; channel < getNumInputChannels(); ++channel)
-    {
-        float* channelData = buffer.getWritePointer (channel);
-
-        // ..do something to the data...
-    }
-    */
-}
-
-//==============================================================================
-bool PluginAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-AudioProcessorEditor* PluginAudioProcessor::createEditor()
-{
-    return new PluginEditor(*this);
-}
-
-//==============================================================================
-void PluginAudioProcessor::getStateInformation (MemoryBlock& destData)
-{
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-}
-
-void PluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new PluginAudioProcessor();
-}
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+//==============================================================================
+PluginAudioProcessor::PluginAudioProcessor()
+    : oversamplingStages (0),
+      latencyReporter (*this),
+      presetBank (*this),
+      programChanged (false),
+      subBlockSize (32),
+      parameterDrainInterval (0),
+      numWorkerThreads (0),
+      minimumSegmentSize (16)
+{
+    // If you're using PluginParameter, create lambda callbacks
+    // auto myCallback = [this] (float value) { ... };
+    
+    // Filter coefficients are best computed in the callback, so the audio
+    // thread only interpolates them. Callbacks receive the normalized value,
+    // so convert it to hertz first, e.g.
+    // auto cutoffCallback = [this] (float value) { myFilters.setStage (0, FilterBank::lowPass, cutoff->calculateActualValue (value)); };
+    
+    // Recomputation too heavy for the audio thread, e.g. designing a long FIR
+    // filter, runs as a task on the background compute thread, which builds a
+    // new state and publishes it to a DspState, e.g.
+    // firTask = backgroundCompute.addTask ([this] { myFir.publish (new FirDesign (cutoff->getActualValue())); });
+    // auto cutoffCallback = [this] (float) { backgroundCompute.request (firTask); };
+    // Request each task once here too, so its first state is ready in prepareToPlay()
+    
+    // Create and add parameters, use MappedParameter for ranges that are not
+    // linear, e.g. ParameterMapping::Logarithmic for frequencies
+    // addParameter(myParameter = new ...);
+    
+    // Optionally smooth parameters that are read per sample
+    // myParameter->setSmoothing(PluginParameter::linearSmoothing, 0.05f);
+    
+    // Oversampling of the kernel, 1x, 2x, 4x or 8x. Use Oversampler::iirFilter
+    // for lower latency at the cost of linear phase. The callback converts
+    // through the same mapping as the text, so the host shows the factor used
+    const ParameterMapping::PowersOfTwo oversamplingFactors (0, Oversampler::maximumStages);
+    auto oversamplingCallback = [this, oversamplingFactors] (float value)
+    {
+        oversamplingStages = roundToInt (std::log2 (oversamplingFactors.toActual (value)));
+    };
+    
+    addParameter (oversampling = new MappedParameter<ParameterMapping::PowersOfTwo> (
+        "oversampling", 1.f, oversamplingFactors, "Oversampling", "x", 0, oversamplingCallback));
+    oversampler.setFilterType (Oversampler::firFilter);
+    
+    // Declare how long your DSP rings after the input goes silent, so hosts and
+    // processBlock know when it can be skipped
+    setTailLength (0.0);
+    
+    // Zones of processBlock timed by the profiler, add your own for stages worth
+    // watching and time them with a ZoneProfiler::ScopedZone
+    oversamplingZone = profiler.addZone ("Oversampling");
+    kernelZone = profiler.addZone ("Kernel");
+    meteringZone = profiler.addZone ("Metering");
+    
+    // Stages that delay the output, reported to the host as one latency. Set
+    // the lookahead of your DSP with setLookahead()
+    oversamplingLatency = latencyReporter.addSource();
+    lookaheadLatency = latencyReporter.addSource();
+    
+    // Run PluginParameter callbacks on the audio thread, track their changes for
+    // the editor and save them in the plugin state, keep this after all
+    // parameters have been added
+    initialiseParameters();
+}
+
+PluginAudioProcessor::~PluginAudioProcessor()
+{
+    // Stop the tasks before the DspStates they publish to are destroyed
+    backgroundCompute.stop();
+}
+
+//==============================================================================
+const String PluginAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+const String PluginAudioProcessor::getInputChannelName (int channelIndex) const
+{
+    return String (channelIndex + 1);
+}
+
+const String PluginAudioProcessor::getOutputChannelName (int channelIndex) const
+{
+    return String (channelIndex + 1);
+}
+
+bool PluginAudioProcessor::isInputChannelStereoPair (int index) const
+{
+    return true;
+}
+
+bool PluginAudioProcessor::isOutputChannelStereoPair (int index) const
+{
+    return true;
+}
+
+bool PluginAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool PluginAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool PluginAudioProcessor::silenceInProducesSilenceOut() const
+{
+    // processBlock outputs silence once silent input has outlasted the tail.
+    // Return false if your DSP generates sound without input
+    return true;
+}
+
+double PluginAudioProcessor::getTailLengthSeconds() const
+{
+    return silenceDetector.getTailLength();
+}
+
+int PluginAudioProcessor::getNumPrograms()
+{
+    // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    // so this should be at least 1, even if you're not really implementing programs.
+    return jmax (1, presetBank.getNumPresets());
+}
+
+int PluginAudioProcessor::getCurrentProgram()
+{
+    return jmax (0, presetBank.getCurrentPreset());
+}
+
+void PluginAudioProcessor::setCurrentProgram (int index)
+{
+    // The preset is decoded on a background thread and switched to at the
+    // start of a following block
+    presetBank.select (index);
+}
+
+const String PluginAudioProcessor::getProgramName (int index)
+{
+    return presetBank.getPresetName (index);
+}
+
+void PluginAudioProcessor::changeProgramName (int index, const String& newName)
+{
+    // Banks are read only
+}
+
+//==============================================================================
+void PluginAudioProcessor::setSubBlockSize (int numSamples)
+{
+    subBlockSize = numSamples <= 16 ? 16
+                 : numSamples <= 32 ? 32
+                 : numSamples <= 64 ? 64
+                 : 128;
+}
+
+void PluginAudioProcessor::setParameterDrainInterval (int numSamples)
+{
+    parameterDrainInterval = jmax (0, numSamples);
+}
+
+void PluginAudioProcessor::setMinimumSegmentSize (int numSamples)
+{
+    minimumSegmentSize = jmax (1, numSamples);
+}
+
+void PluginAudioProcessor::setTailLength (double seconds)
+{
+    silenceDetector.setTailLength (seconds);
+}
+
+void PluginAudioProcessor::setNumWorkerThreads (int numThreads)
+{
+    numWorkerThreads = jlimit (0, (int) WorkerPool::maximumThreads, numThreads);
+}
+
+void PluginAudioProcessor::setLookahead (int numSamples)
+{
+    latencyReporter.setLatency (lookaheadLatency, numSamples);
+}
+
+bool PluginAudioProcessor::openPresetBank (const File& file)
+{
+    if (! presetBank.open (file))
+        return false;
+    
+    updateHostDisplay();
+    return true;
+}
+
+void PluginAudioProcessor::setProgramFadeLength (double seconds)
+{
+    presetBank.setFadeLength (seconds);
+}
+
+void PluginAudioProcessor::initialiseParameters()
+{
+    const OwnedArray<AudioProcessorParameter>& parameters = getParameters();
+    const int numParameters = parameters.size();
+    
+    pluginParameters.clear();
+    parameterChanges.setSize (numParameters);
+    pendingCallbacks.setSize (numParameters);
+    
+    for (int i = 0; i < numParameters; ++i)
+    {
+        PluginParameter* pluginParameter = dynamic_cast<PluginParameter*> (parameters[i]);
+        if (pluginParameter != nullptr)
+        {
+            pluginParameter->setCallbackFlags (&pendingCallbacks);
+            pluginParameter->setChangeFlags (&parameterChanges);
+        }
+        
+        pluginParameters.add (pluginParameter);
+    }
+    
+    // Move the values into one contiguous array, read per block as a snapshot
+    parameterRegistry.setParameters (pluginParameters);
+    parameterSnapshot.setSize (parameterRegistry.size());
+    
+    for (PluginParameter* pluginParameter : pluginParameters)
+    {
+        if (pluginParameter != nullptr)
+            pluginParameter->setRegistry (&parameterRegistry);
+    }
+    
+    parameterState.setParameters (pluginParameters);
+    presetBank.setParameters (pluginParameters, parameterState);
+}
+
+void PluginAudioProcessor::handleParameterChanges()
+{
+    // A program switch set every value, so run every callback
+    if (programChanged)
+    {
+        programChanged = false;
+        pendingCallbacks.markAll();
+    }
+    
+    // Each marked parameter runs its callback once with the value it holds now,
+    // however often and from however many threads it was set
+    pendingCallbacks.forEachChanged ([this] (int index)
+    {
+        if (PluginParameter* parameter = pluginParameters[index])
+            parameter->performCallback (parameter->getValue());
+    });
+}
+
+//==============================================================================
+void PluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    // Use this method as the place to do any pre-playback
+    // initialisation that you need..
+    
+    // Allocating here is fine, even if the host calls this from the audio thread
+    const RealtimeSafety::ScopedNonRealtime nonRealtime;
+    
+    // Audio is processed in sub-blocks of at most subBlockSize samples, so
+    // buffers only need to hold one sub-block whatever samplesPerBlock is
+    
+    // The host chooses float or double samples before calling this, so buffers
+    // and states are allocated and reset for that precision only
+    const bool doublePrecision = isUsingDoublePrecision();
+    
+    if (doublePrecision)
+        doubleKernel.reset();
+    else
+        floatKernel.reset();
+    
+    // Run the callbacks of values set since the last block, e.g. restored by
+    // setStateInformation(), so the oversampling factor below is current
+    handleParameterChanges();
+    
+    // Allocate the smoothing buffers of all PluginParameters, call
+    // myParam->smoothBlock(numSamples) in processSubBlock to use them
+    for (AudioProcessorParameter* parameter : getParameters())
+    {
+        if (PluginParameter* pluginParameter = dynamic_cast<PluginParameter*> (parameter))
+            pluginParameter->prepareSmoothing (sampleRate, subBlockSize);
+    }
+    
+    // Oversampling needs room for the kernel to process the largest factor
+    oversampler.prepare (jmax (getNumInputChannels(), getNumOutputChannels()), subBlockSize, doublePrecision);
+    oversampler.setNumStages (oversamplingStages);
+    latencyReporter.setLatency (oversamplingLatency, oversampler.getLatencyInSamples());
+    latencyReporter.update();
+    latencyReporter.report();
+    
+    // Allocate delay lines here, sized for the longest delay and a sub-block,
+    // e.g. myDelay.prepare (getNumInputChannels(), maximumDelay, subBlockSize, doublePrecision)
+    
+    // Convolvers are sized for the longest impulse response, and start the
+    // thread for its long partitions here, e.g.
+    // myConvolver.prepare (getNumOutputChannels(), (int) (10.0 * sampleRate), true)
+    
+    // Filter banks hold the state of every channel and stage, e.g.
+    // myFilters.prepare (sampleRate * oversampler.getFactor(), getNumOutputChannels(), 4, doublePrecision)
+    
+    // DspStates fade at the sample rate and retire states to the background
+    // compute thread, which runs the tasks requested so far before it starts,
+    // e.g. myFir.prepare (sampleRate, backgroundCompute)
+    backgroundCompute.start();
+    
+    silenceDetector.setLatency (latencyReporter.getTotalLatency());
+    silenceDetector.prepare (sampleRate);
+    
+    channelDispatcher.prepare (subBlockSize << Oversampler::maximumStages, doublePrecision);
+    
+    levelMeter.prepare (sampleRate);
+    profiler.prepare (sampleRate);
+    
+    workerPool.start (numWorkerThreads);
+    
+    presetBank.prepare (sampleRate);
+}
+
+void PluginAudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
+    workerPool.stop();
+    presetBank.release();
+    backgroundCompute.stop();
+    
+    // Stop the threads of any Convolvers, e.g. myConvolver.release()
+}
+
+void PluginAudioProcessor::processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
+{
+    process (buffer, midiMessages);
+}
+
+void PluginAudioProcessor::processBlock (AudioBuffer<double>& buffer, MidiBuffer& midiMessages)
+{
+    process (buffer, midiMessages);
+}
+
+bool PluginAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    // Hosts with a 64-bit mix bus then pass their buffers without converting
+    // them to float and back. Return false if the DSP only works in float
+    return true;
+}
+
+template <typename FloatType>
+void PluginAudioProcessor::process (AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages)
+{
+    // In debug builds, allocating, locking or file access from here on is reported
+    // as a violation, see RealtimeSafety
+    const RealtimeSafety::ScopedRealtime realtime;
+    
+    // In debug builds, the time taken by the block and its zones is measured
+    // against the deadline of the block, see ZoneProfiler
+    const ZoneProfiler::ScopedBlock profiledBlock (profiler, buffer.getNumSamples());
+    
+    // Treat denormals as zero, so decaying feedback paths don't slow down on
+    // their way to silence
+    const ScopedFlushDenormals flushDenormals;
+    
+    // In case we have more outputs than inputs, this code clears any output
+    // channels that didn't contain input data, (because these aren't
+    // guaranteed to be empty - they may contain garbage).
+    // I've added this to avoid people getting screaming feedback
+    // when they first compile the plugin, but obviously you don't need to
+    // this code if your algorithm already fills all the output channels.
+    for (int i = getNumInputChannels(); i < getNumOutputChannels(); ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    // Switch to a program selected with setCurrentProgram() all at once, before
+    // the parameter values of the block are read
+    if (presetBank.beginBlock())
+        programChanged = true;
+    
+    // Take a consistent copy of all parameter values for this block in one pass
+    parameterRegistry.read (parameterSnapshot);
+    
+    // Take the controller mapping if the editor changed it
+    midiLearn.beginBlock();
+    
+    // Switch DspStates to the latest states built by the background compute
+    // thread, e.g. myFir.beginBlock()
+    
+    // Run the callbacks of changed parameters before anything depends on them
+    handleParameterChanges();
+    
+    // Changing the oversampling factor changes the latency, so only do it at a
+    // block boundary
+    if (oversamplingStages != oversampler.getNumStages())
+    {
+        oversampler.setNumStages (oversamplingStages);
+        latencyReporter.setLatency (oversamplingLatency, oversampler.getLatencyInSamples());
+    }
+    
+    // Note changes of the oversampling latency or the lookahead, which the
+    // reporter's timer tells the host on the message thread
+    if (latencyReporter.update())
+        silenceDetector.setLatency (latencyReporter.getTotalLatency());
+
+    // Once the input has been silent for longer than the tail, skip the DSP and
+    // output silence. Input above the threshold or any MIDI wakes it up again,
+    // and blocks with MIDI are always processed so their events are handled
+    if (! midiMessages.isEmpty())
+        silenceDetector.wake();
+    
+    const bool silent = ! silenceDetector.process (buffer, getNumInputChannels());
+    
+    if (silent && midiMessages.isEmpty())
+    {
+        buffer.clear();
+    }
+    else
+    {
+        // Split the host buffer into fixed size sub-blocks, so the cost per
+        // sample is the same whatever buffer size the host uses
+        switch (subBlockSize)
+        {
+            case 16:  processSubBlocks<16>  (buffer, midiMessages); break;
+            case 64:  processSubBlocks<64>  (buffer, midiMessages); break;
+            case 128: processSubBlocks<128> (buffer, midiMessages); break;
+            default:  processSubBlocks<32>  (buffer, midiMessages); break;
+        }
+    }
+    
+    // Fade the output around program switches, if a fade length is set
+    presetBank.endBlock (buffer, getNumOutputChannels());
+    
+    // Measure the output for the editor's meters, once per channel per block
+    {
+        const ZoneProfiler::ScopedZone zone (profiler, meteringZone);
+        levelMeter.process (buffer, getNumOutputChannels());
+    }
+}
+
+template <int SubBlockSize, typename FloatType>
+void PluginAudioProcessor::processSubBlocks (AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int drainInterval = parameterDrainInterval > 0 ? parameterDrainInterval : numSamples;
+    
+    // Sub-blocks are split into segments at MIDI events, so each event takes
+    // effect at its sample. The MIDI buffer is walked once
+    MidiDispatcher midiDispatcher (midiMessages, numSamples, minimumSegmentSize);
+    auto handleEvent = [this] (const uint8* data, int numBytes, int samplePosition)
+    {
+        handleMidiMessage (data, numBytes, samplePosition);
+    };
+    
+    // process() ran the callbacks at the start of the block
+    int nextDrain = drainInterval;
+    int numSegmentSamples = 0;
+    
+    for (int startSample = 0; startSample < numSamples; startSample += numSegmentSamples)
+    {
+        const int subBlockEnd = jmin (numSamples, (startSample / SubBlockSize + 1) * SubBlockSize);
+        
+        // Run the callbacks of changed parameters again at the first sub-block
+        // boundary after each drain interval
+        if (startSample % SubBlockSize == 0 && startSample >= nextDrain)
+        {
+            handleParameterChanges();
+            nextDrain = startSample + drainInterval;
+        }
+        
+        numSegmentSamples = midiDispatcher.nextSegment (startSample, subBlockEnd - startSample, handleEvent);
+        
+        // Full sub-blocks are processed with their size known at compile time,
+        // only segments split by MIDI and the last sub-block of a host buffer
+        // may be shorter
+        if (numSegmentSamples == SubBlockSize)
+            processSubBlock<SubBlockSize> (buffer, startSample, SubBlockSize);
+        else
+            processSubBlock<0> (buffer, startSample, numSegmentSamples);
+    }
+}
+
+void PluginAudioProcessor::handleMidiMessage (const uint8* data, int numBytes, int samplePosition)
+{
+    // Controllers mapped with getMidiLearn() set their parameter. The status
+    // byte is read directly, as building a MidiMessage allocates for sysex
+    if (numBytes >= 3 && (data[0] & 0xf0) == 0xb0)
+    {
+        const int controller = data[1] & 0x7f;
+        midiLearn.controllerReceived (controller);
+        
+        const int parameterIndex = midiLearn.getParameterIndex (controller);
+        if (parameterIndex >= 0)
+            setParameterFromMidi (parameterIndex, (data[2] & 0x7f) / 127.f);
+    }
+    
+    // Respond to other incoming MIDI here, e.g. notes. This is called on the
+    // audio thread before the segment starting at samplePosition, or less than
+    // the minimum segment size before it, see setMinimumSegmentSize(). Parse
+    // the bytes, or wrap short messages in a MidiMessage (data, numBytes),
+    // which only allocates for messages longer than a few bytes.
+}
+
+void PluginAudioProcessor::setParameterFromMidi (int parameterIndex, float value)
+{
+    PluginParameter* parameter = pluginParameters[parameterIndex];
+    
+    if (parameter == nullptr || parameter->getValue() == value)
+        return;
+    
+    // Store the value for the editor and the saved state, and apply it to the
+    // rest of the block by running the callback now rather than at the next
+    // drain. The host isn't notified, as that locks
+    parameter->storeValue (value);
+    parameterSnapshot.set (parameterIndex, value);
+    parameter->performCallback (value);
+}
+
+template <int BlockSize, typename FloatType>
+void PluginAudioProcessor::processSubBlock (AudioBuffer<FloatType>& buffer, int startSample, int numSamples)
+{
+    // This is the place where you'd normally do the guts of your plugin's
+    // audio processing...
+    
+    // Unsmoothed parameters are read from the snapshot taken at the start of
+    // the block, which keeps all values in a few cache lines
+    // const float mix = parameterSnapshot[myParam->getParameterIndex()];
+    
+    // Smoothed parameters either hold a constant value for the whole block or
+    // provide a ramp of actual values, one per sample. Hand them to the kernel
+    // before processing
+    // const bool gainIsRamping = myParam->smoothBlock (numSamples);
+    // kernel.gainRamp = gainIsRamping ? myParam->getSmoothedBlock() : nullptr;
+    // kernel.gain = myParam->getSmoothedValue();
+    
+    // Delay lines are written and read a sub-block at a time, e.g. to delay the
+    // audio by the lookahead of a limiter
+    // myDelay.write (channel, buffer.getReadPointer (channel, startSample), numSamples);
+    // myDelay.read (channel, buffer.getWritePointer (channel, startSample), numSamples, lookahead);
+    // myDelay.advance (numSamples);
+    
+    // A Convolver replaces the sub-block with its convolution without adding
+    // latency. Load impulse responses with loadImpulseResponse() from the
+    // message thread, never from here. It convolves in float, also when
+    // passed double channels
+    // myConvolver.process (wetChannels, numChannels, numSamples);
+    
+    // A DspState holds a state built on the background compute thread, read
+    // without locks. With a fade length set, process a copy of the input with
+    // the previous state too while it fades, and mix the two, e.g.
+    // myFirFilter.process (*myFir.get(), channels, numChannels, numSamples);
+    // if (myFir.isFading())
+    // {
+    //     myFirFilter.process (*myFir.getPrevious(), copyChannels, numChannels, numSamples);
+    //     myFir.crossfade (channels, copyChannels, numChannels, numSamples);
+    // }
+    
+    // A FilterBank filters all channels at once, four per SIMD register, in
+    // the precision it was prepared for. Set smoothed coefficients once per
+    // sub-block, it interpolates between them
+    // if (cutoff->smoothBlock (numSamples))
+    //     myFilters.setStage (0, FilterBank::lowPass, cutoff->getSmoothedValue());
+    // myFilters.process (channels, numChannels, numSamples);
+    
+    // Independent per channel or per band work that is heavy enough to outweigh
+    // waking a thread can be spread over the worker pool, see
+    // setNumWorkerThreads(). Jobs must not write to state they share
+    // auto processChannel = [&] (int channel) { ... };
+    // workerPool.run (buffer.getNumChannels(), processChannel);
+    
+    // The DSP itself is written once in Kernel and run over every channel of
+    // whatever bus layout the host chose, from mono up to surround beds. When
+    // oversampling, the kernel runs at getSampleRate() * oversampler.getFactor()
+    // and sees that many more frames
+    const int numChannels = jmin (getNumInputChannels(), buffer.getNumChannels());
+    Kernel<FloatType>& kernel = getKernel (buffer);
+    
+    if (oversampler.getNumStages() == 0)
+    {
+        const ZoneProfiler::ScopedZone zone (profiler, kernelZone);
+        channelDispatcher.processLanes<BlockSize> (kernel, buffer, startSample, numSamples, numChannels);
+        return;
+    }
+    
+    {
+        const ZoneProfiler::ScopedZone zone (profiler, oversamplingZone);
+        oversampler.upsample (buffer, startSample, numSamples, numChannels);
+    }
+    
+    AudioBuffer<FloatType>& oversampled = oversampler.getOversampledBuffer<FloatType>();
+    const int numOversampled = numSamples * oversampler.getFactor();
+    
+    {
+        const ZoneProfiler::ScopedZone zone (profiler, kernelZone);
+        
+        switch (oversampler.getFactor())
+        {
+            case 2:  channelDispatcher.processLanes<BlockSize * 2> (kernel, oversampled, 0, numOversampled, numChannels); break;
+            case 4:  channelDispatcher.processLanes<BlockSize * 4> (kernel, oversampled, 0, numOversampled, numChannels); break;
+            default: channelDispatcher.processLanes<BlockSize * 8> (kernel, oversampled, 0, numOversampled, numChannels); break;
+        }
+    }
+    
+    const ZoneProfiler::ScopedZone zone (profiler, oversamplingZone);
+    oversampler.downsample (buffer, startSample, numSamples, numChannels);
+}
+
+//==============================================================================
+bool PluginAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+AudioProcessorEditor* PluginAudioProcessor::createEditor()
+{
+    return new PluginEditor(*this);
+}
+
+//==============================================================================
+void PluginAudioProcessor::getStateInformation (MemoryBlock& destData)
+{
+    // You should use this method to store your parameters in the memory block.
+    // PluginParameters are stored in a compact binary format, see ParameterState,
+    // append any other data you need after it. The values are taken as one
+    // snapshot, so they are consistent even while the host automates them. If
+    // writes keep overlapping the snapshot, each parameter is saved as it is
+    ParameterRegistry::Snapshot snapshot;
+    if (parameterRegistry.read (snapshot, 64))
+        parameterState.save (destData, snapshot);
+    else
+        parameterState.save (destData);
+}
+
+void PluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    // You should use this method to restore your parameters from this memory block,
+    // whose contents will have been created by the getStateInformation() call.
+    parameterState.load (data, (size_t) jmax (0, sizeInBytes));
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new PluginAudioProcessor();
+}
@@ -1,77 +1,369 @@
-#ifndef PLUGINPROCESSOR_H_INCLUDED
-#define PLUGINPROCESSOR_H_INCLUDED
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "PluginParameter.h"
-
-/** Helper Macros
-    
-    All audio samples are represented in unit voltage (uV) as a float in the
-    range of -1.0 to 1.0. To convert an audio sample into a decibel (dB) value
-    pass the sample into `dB(x)`. The returned output can be used for audio
-    analysis and dynamic procesing. To convert a decibel value back to unit
-    voltage for output, pass the value into `uV(x)`. Do not output your samples
-    in decibels.
-
-    It is important to keep track of when your values are in decibels or
-    unit voltage. Be sure to label your variables accordingly.
-*/
-#define dB(x) 20.0 * ((x) > 0.00001 ? log10(x) : -5.0)  // uV -> dB
-#define uV(x) pow(10.0, (x) / 20.0)                     // dB -> uV
-
-//==============================================================================
-/**
-*/
-class PluginAudioProcessor  : public AudioProcessor
-{
-public:
-    //==============================================================================
-    PluginAudioProcessor();
-    ~PluginAudioProcessor();
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-    void processBlock (AudioSampleBuffer&, MidiBuffer&) override;
-
-    //==============================================================================
-    AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const String getName() const override;
-    const String getInputChannelName (int channelIndex) const override;
-    const String getOutputChannelName (int channelIndex) const override;
-    bool isInputChannelStereoPair (int index) const override;
-    bool isOutputChannelStereoPair (int index) const override;
-
-    bool   acceptsMidi() const override;
-    bool   producesMidi() const override;
-    bool   silenceInProducesSilenceOut() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int  getNumPrograms() override;
-    int  getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const String getProgramName (int index) override;
-    void changeProgramName (int index, const String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-
-    // Parameters
-    // AudioProcessorParameter* myParam;
-    
-private:
-    // Data structures, intermediate values, and processor-only methods should
-    // be delcared here. E.g. `float fs; void setCutoff(float cutoff);
-    
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginAudioProcessor)
-};
-
-
-#endif  // PLUGINPROCESSOR_H_INCLUDED
+#ifndef PLUGINPROCESSOR_H_INCLUDED
+#define PLUGINPROCESSOR_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PluginParameter.h"
+#include "MappedParameter.h"
+#include "ParameterState.h"
+#include "PresetBank.h"
+#include "DecibelConversion.h"
+#include "ChannelDispatcher.h"
+#include "Oversampler.h"
+#include "LevelMeter.h"
+#include "RealtimeSafety.h"
+#include "ZoneProfiler.h"
+#include "SilenceDetector.h"
+#include "DelayLine.h"
+#include "Convolver.h"
+#include "FilterBank.h"
+#include "LatencyReporter.h"
+#include "MidiDispatcher.h"
+#include "MidiLearn.h"
+#include "ScopedFlushDenormals.h"
+#include "WorkerPool.h"
+#include "BackgroundCompute.h"
+#include "DspState.h"
+
+//==============================================================================
+/**
+*/
+class PluginAudioProcessor  : public AudioProcessor
+{
+public:
+    //==============================================================================
+    PluginAudioProcessor();
+    ~PluginAudioProcessor();
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+    void processBlock (AudioBuffer<float>&, MidiBuffer&) override;
+    void processBlock (AudioBuffer<double>&, MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
+    //==============================================================================
+    AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const String getName() const override;
+    const String getInputChannelName (int channelIndex) const override;
+    const String getOutputChannelName (int channelIndex) const override;
+    bool isInputChannelStereoPair (int index) const override;
+    bool isOutputChannelStereoPair (int index) const override;
+
+    bool   acceptsMidi() const override;
+    bool   producesMidi() const override;
+    bool   silenceInProducesSilenceOut() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int  getNumPrograms() override;
+    int  getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const String getProgramName (int index) override;
+    void changeProgramName (int index, const String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+    //==============================================================================
+    /** Sets the size of the sub-blocks the host buffer is split into.
+     
+        processBlock always runs the DSP in sub-blocks of this size, whatever
+        buffer size the host uses, so the kernel sees a block size known at
+        compile time. Supported sizes are 16, 32, 64 and 128 samples, other sizes
+        are rounded up. Call this before prepareToPlay(), the default is 32.
+     */
+    void setSubBlockSize (int numSamples);
+    
+    /** Sets how often parameter changes are handled within a block.
+     
+        By default PluginParameter callbacks run once at the start of each block.
+        A positive interval also handles changes at the first sub-block boundary
+        after every numSamples samples, which gives finer timing for automation
+        at the cost of more callbacks.
+     */
+    void setParameterDrainInterval (int numSamples);
+    
+    /** Sets the shortest segment a sub-block is split into at MIDI events.
+     
+        Sub-blocks are split at the sample of each MIDI event, so notes and
+        controllers take effect exactly where the host placed them. Events less
+        than numSamples after the start of a segment are handled at its start
+        instead, which bounds the number of splits per block. A size of at least
+        the sub-block size only handles events at sub-block boundaries. The
+        default is 16.
+     */
+    void setMinimumSegmentSize (int numSamples);
+    
+    /** Declares how long the DSP keeps producing output after its input goes
+        silent, e.g. the decay time of a reverb or delay.
+     
+        This is reported to the host by getTailLengthSeconds(). Once the input has
+        been silent for longer than the tail, processBlock skips the DSP and
+        outputs silence until the input or MIDI wakes it. Pass
+        std::numeric_limits<double>::infinity() if the DSP generates sound by
+        itself. Call this from the constructor, the default is 0.
+     */
+    void setTailLength (double seconds);
+    
+    /** Sets the number of worker threads processBlock can spread jobs over.
+     
+        The pool is started in prepareToPlay() and stopped in releaseResources().
+        Use it for independent per channel or per band work that is too heavy
+        for one core at small buffer sizes, see WorkerPool::run(). The default
+        is 0, which runs every job on the audio thread.
+     */
+    void setNumWorkerThreads (int numThreads);
+    
+    /** Declares the lookahead of the DSP in samples, e.g. the delay line of a
+        lookahead limiter.
+     
+        It is added to the latency of the oversampling from the start of the
+        next block, and reported to the host with setLatencySamples() from the
+        message thread shortly after. Call this from any thread.
+     */
+    void setLookahead (int numSamples);
+    
+    /** Opens a bank of presets, which become the plugin's programs.
+     
+        The file is memory mapped and presets are only decoded once selected,
+        so large banks open instantly. Create banks from the states saved by
+        getStateInformation() with PresetBank::create(). Returns false and
+        keeps the current bank if the file is not a valid bank.
+     */
+    bool openPresetBank (const File& file);
+    
+    /** Sets the length of the fade around program switches.
+     
+        Switches happen at a block boundary. With a fade the output is faded out
+        with the old program and back in with the new one, which hides jumps of
+        parameters that are not smoothed. Call this before prepareToPlay(), the
+        default is 0, which switches instantly.
+     */
+    void setProgramFadeLength (double seconds);
+    
+    /** Returns the meter of the output levels.
+     
+        The levels of every output channel are measured at the end of each
+        processBlock. Call LevelMeter::read() from the editor's timer to take
+        them, which never blocks the audio thread.
+     */
+    LevelMeter& getLevelMeter() { return levelMeter; }
+    
+    /** Returns the flags of parameters changed since the editor last checked.
+     
+        Every PluginParameter marks its flag when its value is set, from any
+        thread. The editor takes them from its timer to update only the controls
+        whose parameters changed.
+     */
+    ParameterChangeFlags& getParameterChanges() { return parameterChanges; }
+    
+    /** Returns the profiler of the time spent in processBlock.
+     
+        Each block is timed as a whole and in zones for oversampling, the kernel
+        and metering. Call ZoneProfiler::read() from the editor's timer to take
+        the load statistics, which never blocks the audio thread.
+     */
+    ZoneProfiler& getProfiler() { return profiler; }
+    
+    /** Returns the registry holding the normalized values of all parameters.
+     
+        The values sit in one contiguous array, without the identifiers, ranges
+        or labels, which stay with the parameters. Use ParameterRegistry::read()
+        to take a consistent snapshot of all values from any thread.
+     */
+    const ParameterRegistry& getParameterRegistry() const { return parameterRegistry; }
+    
+    /** Returns the table of MIDI controllers mapped to parameters.
+     
+        Change it from the editor, e.g. to learn the controller of a parameter.
+        Controllers then set their PluginParameter at the sample they arrive,
+        which runs its callback and marks it for the editor without locking.
+        The host is not told about these changes, so it won't record them as
+        automation.
+     */
+    MidiLearn& getMidiLearn() { return midiLearn; }
+
+    // Parameters
+    // AudioProcessorParameter* myParam;
+    MappedParameter<ParameterMapping::PowersOfTwo>* oversampling;
+    
+private:
+    // Data structures, intermediate values, and processor-only methods should
+    // be delcared here. E.g. `float fs; void setCutoff(float cutoff);
+    
+    /// Connects all PluginParameters to the parameter registry, callback and
+    /// change flags and saved state.
+    /// Call this after all parameters have been added.
+    void initialiseParameters();
+    
+    /// Runs the callback of each parameter changed since the last call once, with
+    /// its latest value. Only call this from the audio thread.
+    void handleParameterChanges();
+    
+    /// The body of both processBlock overloads. Everything that touches
+    /// samples is written once for FloatType, float or double.
+    template <typename FloatType>
+    void process (AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages);
+    
+    /// Splits the buffer into sub-blocks, handling parameter changes and MIDI
+    /// at their boundaries.
+    template <int SubBlockSize, typename FloatType>
+    void processSubBlocks (AudioBuffer<FloatType>& buffer, MidiBuffer& midiMessages);
+    
+    /// Handles the bytes of a MIDI message before the segment it falls in is
+    /// processed.
+    void handleMidiMessage (const uint8* data, int numBytes, int samplePosition);
+    
+    /// Sets a parameter from a MIDI controller within the block, running its
+    /// callback right away. Only call this from the audio thread.
+    void setParameterFromMidi (int parameterIndex, float value);
+    
+    /// Processes a sub-block of the buffer. BlockSize is numSamples known at
+    /// compile time, or 0 for the shorter last sub-block of a host buffer.
+    template <int BlockSize, typename FloatType>
+    void processSubBlock (AudioBuffer<FloatType>& buffer, int startSample, int numSamples);
+    
+    /** The per channel DSP of the plugin.
+     
+        Write the processing once here and ChannelDispatcher runs it over any bus
+        layout. Each frame holds one sample of Lanes channels, starting at
+        firstChannel. Keep per channel state, e.g. filter memories, in arrays
+        indexed by `firstChannel + lane` so the lane loop vectorizes.
+     
+        BlockSize is the number of frames known at compile time, which lets the
+        compiler unroll the frame loop, or 0 when only numFrames is known.
+     
+        The kernel exists once per precision, FloatType is float or double.
+        Keep its state, e.g. filter memories, in FloatType too. Only the kernel
+        of the precision the host chose runs, and prepareToPlay() resets it.
+     */
+    template <typename FloatType>
+    struct Kernel
+    {
+        /// Clears the state, e.g. filter memories.
+        void reset()
+        {
+        }
+        
+        template <int Lanes, int BlockSize>
+        void processLanes (FloatType* frames, int numFrames, int firstChannel)
+        {
+            const int n = BlockSize > 0 ? BlockSize : numFrames;
+            
+            for (int i = 0; i < n; ++i)
+            {
+                for (int lane = 0; lane < Lanes; ++lane)
+                {
+                    FloatType sample = frames[i * Lanes + lane];
+                    
+                    // ..do something to the data...
+                    
+                    frames[i * Lanes + lane] = sample;
+                }
+            }
+        }
+    };
+    
+    /// The DSP run on every channel in processSubBlock(), in each precision.
+    Kernel<float>  floatKernel;
+    Kernel<double> doubleKernel;
+    
+    Kernel<float>&  getKernel (const AudioBuffer<float>&)  { return floatKernel; }
+    Kernel<double>& getKernel (const AudioBuffer<double>&) { return doubleKernel; }
+    
+    /// Packs channels into SIMD lanes for the kernel.
+    ChannelDispatcher channelDispatcher;
+    
+    /// Oversamples the audio around the kernel.
+    Oversampler oversampler;
+    
+    /// The number of oversampling stages requested by the oversampling
+    /// parameter, applied at the next block boundary.
+    int oversamplingStages;
+    
+    /// Measures the output levels for the editor.
+    LevelMeter levelMeter;
+    
+    /// Adds up the latency of the oversampling and the lookahead for the host.
+    LatencyReporter latencyReporter;
+    
+    /// The sources of latencyReporter.
+    int oversamplingLatency;
+    int lookaheadLatency;
+    
+    /// Skips the DSP while the input is silent and the tail has decayed.
+    SilenceDetector silenceDetector;
+    
+    /// Runs jobs of processBlock on other cores.
+    WorkerPool workerPool;
+    
+    /// Builds DSP states that take too long to compute in a parameter
+    /// callback, and frees the ones the audio thread is done with.
+    BackgroundCompute backgroundCompute;
+    
+    // DSP states built by backgroundCompute, e.g.
+    // DspState<FirDesign> myFir;
+    
+    /// Times processBlock and its zones for the editor.
+    ZoneProfiler profiler;
+    
+    /// The zones of profiler timed in processBlock.
+    int oversamplingZone;
+    int kernelZone;
+    int meteringZone;
+    
+    /// Marked by PluginParameter::setValue() and cleared in processBlock, which
+    /// runs the callbacks of the marked parameters.
+    ParameterChangeFlags pendingCallbacks;
+    
+    /// Marked by PluginParameter::setValue() and cleared by the editor.
+    ParameterChangeFlags parameterChanges;
+    
+    /// The PluginParameters by parameter index, or nullptr for other parameters.
+    Array<PluginParameter*> pluginParameters;
+    
+    /// The normalized values of all parameters, stored contiguously.
+    ParameterRegistry parameterRegistry;
+    
+    /// The values of all parameters at the start of the current block, taken
+    /// in processBlock. Read it from processSubBlock by parameter index.
+    ParameterRegistry::Snapshot parameterSnapshot;
+    
+    /// The programs, switched at block boundaries in processBlock.
+    PresetBank presetBank;
+    
+    /// Set when presetBank switched programs, so handleParameterChanges() runs
+    /// the callbacks of all parameters.
+    bool programChanged;
+    
+    /// Saves and restores the PluginParameters in getStateInformation() and
+    /// setStateInformation().
+    ParameterState parameterState;
+    
+    /// The number of samples in each sub-block.
+    int subBlockSize;
+    
+    /// The number of samples between handling parameter changes, or 0 to only
+    /// handle them at the start of each block.
+    int parameterDrainInterval;
+    
+    /// The number of threads workerPool is started with.
+    int numWorkerThreads;
+    
+    /// The shortest segment sub-blocks are split into at MIDI events.
+    int minimumSegmentSize;
+    
+    /// The MIDI controllers mapped to parameters.
+    MidiLearn midiLearn;
+    
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginAudioProcessor)
+};
+
+
+#endif  // PLUGINPROCESSOR_H_INCLUDED
@@ -0,0 +1,484 @@
+#ifndef PRESETBANK_H_INCLUDED
+#define PRESETBANK_H_INCLUDED
+
+#include <atomic>
+
+#include "ParameterState.h"
+#include "TripleBuffer.h"
+
+/**
+    A bank of presets read from a single memory mapped file, switched on the
+    audio thread at block boundaries.
+
+    The file is a 16 byte header followed by an index of one fixed size entry
+    per preset, all little endian. Offsets are from the start of the file:
+
+    | Offset | Size | Header field                                         |
+    |--------|------|------------------------------------------------------|
+    | 0      | 4    | Magic number, "PPBK"                                 |
+    | 4      | 2    | Format version                                       |
+    | 6      | 2    | Index entry size in bytes, 16 for version 1          |
+    | 8      | 4    | Number of presets                                    |
+    | 12     | 4    | Reserved, 0                                          |
+
+    | Offset | Size | Index entry field                                    |
+    |--------|------|------------------------------------------------------|
+    | 0      | 4    | Offset of the name, UTF-8 without a terminator       |
+    | 4      | 4    | Length of the name in bytes                          |
+    | 8      | 4    | Offset of the preset, in the ParameterState format   |
+    | 12     | 4    | Size of the preset in bytes                          |
+
+    Opening a bank only maps the file and checks the header, so banks with
+    thousands of presets open instantly. Names are read when asked for, and a
+    preset is only decoded once it is selected. Create a bank from the saved
+    states of the processor with create().
+
+    select() hands the preset to a decoder thread, which decodes it from the
+    mapped file and publishes its values through a TripleBuffer. The processor
+    calls beginBlock() at the start of each block to apply the latest decoded
+    preset to all parameters at once, then runs their callbacks. Applying it
+    neither allocates nor touches the file. With a fade length set, the output
+    is faded out with the old preset and back in with the new one, see
+    endBlock(). Once a preset is applied, a timer on the message thread tells
+    the host about the new values, as host callbacks may lock or allocate.
+
+    While the processor is not prepared, select() applies the preset straight
+    away on the calling thread.
+ */
+class PresetBank : private Timer {
+public:
+    /// The magic number at the start of every bank, "PPBK".
+    static const uint32 magic = 0x4b425050;
+
+    /// The format version written by this class.
+    static const uint16 version = 1;
+
+    /// The size of the header in bytes.
+    static const int headerSize = 16;
+
+    /// The size of an index entry written by this version in bytes.
+    static const int entrySize = 16;
+
+    /// The largest number of parameters a preset can switch.
+    static const int maximumParameters = 1024;
+
+    /// How often the message thread checks for an applied preset to tell the
+    /// host about, in milliseconds.
+    static const int notifyInterval = 50;
+
+    explicit PresetBank(AudioProcessor& owner)
+    : processor(owner),
+    decoder(*this),
+    state(nullptr),
+    num_presets(0),
+    current_preset(-1),
+    requested_preset(-1),
+    applied_preset(-1),
+    prepared(false),
+    fade_time(0.0),
+    fade_length(0),
+    fade_countdown(0),
+    fading_out(false)
+    {
+        startTimer(notifyInterval);
+    }
+
+    /// Stops the decoder thread without applying a pending preset, as the
+    /// parameters and the state may already be gone.
+    ~PresetBank()
+    {
+        stopTimer();
+        decoder.stopThread(1000);
+    }
+
+    /// Sets the PluginParameters switched by presets, by parameter index, and
+    /// the state used to decode them. Call this once after all parameters have
+    /// been added.
+    void setParameters(const Array<PluginParameter*>& pluginParameters, const ParameterState& parameterState)
+    {
+        jassert(pluginParameters.size() <= maximumParameters);
+        parameters = pluginParameters;
+        state = &parameterState;
+    }
+
+    /// Maps a bank file and replaces the current bank with it. Returns false and
+    /// keeps the current bank if the file is not a valid bank.
+    bool open(const File& file)
+    {
+        ScopedPointer<MemoryMappedFile> newFile(new MemoryMappedFile(file, MemoryMappedFile::readOnly));
+        const uint8* const data = static_cast<const uint8*>(newFile->getData());
+        const size_t size = newFile->getSize();
+
+        if (data == nullptr || size < (size_t) headerSize
+            || readUInt32(data) != magic || readUInt16(data + 6) < entrySize) {
+            return false;
+        }
+
+        const uint32 numEntries = readUInt32(data + 8);
+        if ((size - headerSize) / readUInt16(data + 6) < numEntries) {
+            return false;
+        }
+
+        const ScopedLock lock(bank_lock);
+        mapped_file.swapWith(newFile);
+        num_presets.store((int) numEntries);
+        current_preset.store(-1);
+        return true;
+    }
+
+    /// Returns the number of presets in the bank.
+    int getNumPresets() const
+    {
+        return num_presets.load();
+    }
+
+    /// Returns the preset last selected, or -1 if none is.
+    int getCurrentPreset() const
+    {
+        return current_preset.load();
+    }
+
+    /// Returns the name of a preset, or an empty string if there is none.
+    String getPresetName(int index) const
+    {
+        const ScopedLock lock(bank_lock);
+
+        const uint8* name;
+        size_t length;
+        if (! findEntry(index, 0, name, length)) {
+            return String();
+        }
+        return String::fromUTF8(reinterpret_cast<const char*>(name), (int) length);
+    }
+
+    /// Selects a preset, which is applied at the start of a following block.
+    /// Call this from any thread except the audio thread.
+    void select(int index)
+    {
+        if (! isPositiveAndBelow(index, getNumPresets())) {
+            return;
+        }
+
+        current_preset.store(index);
+
+        if (prepared) {
+            requested_preset.store(index);
+            decoder.notify();
+        }
+        else {
+            applyNow(index);
+        }
+    }
+
+    /// Sets the length of the fade around a switch, 0 to switch instantly.
+    /// Call this before prepare().
+    void setFadeLength(double seconds)
+    {
+        fade_time = jmax(0.0, seconds);
+    }
+
+    /// Starts the decoder thread. Call this from prepareToPlay().
+    void prepare(double sampleRate)
+    {
+        fade_length = (int) (fade_time * sampleRate);
+        fade_countdown = 0;
+        fading_out = false;
+
+        prepared = true;
+        if (! decoder.isThreadRunning()) {
+            decoder.startThread(4);
+        }
+    }
+
+    /// Stops the decoder thread and applies a preset that was selected but not
+    /// yet switched to. Call this from releaseResources().
+    void release()
+    {
+        prepared = false;
+        decoder.stopThread(1000);
+
+        const int requested = requested_preset.exchange(-1);
+        if (programs.read(program) || requested >= 0) {
+            applyNow(requested >= 0 ? requested : program.index);
+        }
+        fade_countdown = 0;
+        fading_out = false;
+    }
+
+    /** Switches to the latest decoded preset. Returns true if it did, in which
+        case the caller must run the callbacks of all parameters, as their
+        values changed without marking their callbacks.
+
+        With a fade, the switch waits until the output has faded out. Only call
+        this from the audio thread, at the start of a block.
+     */
+    bool beginBlock()
+    {
+        if (fading_out) {
+            if (fade_countdown > 0) {
+                return false;
+            }
+
+            fading_out = false;
+            fade_countdown = fade_length;
+            return apply();
+        }
+
+        if (! programs.hasUnreadValue()) {
+            return false;
+        }
+
+        if (fade_length > 0) {
+            fading_out = true;
+            fade_countdown = fade_length;
+            return false;
+        }
+
+        return apply();
+    }
+
+    /// Fades the output, of float or double samples, while a switch is fading
+    /// out or in. Only call this from the audio thread, at the end of a block.
+    template <typename FloatType>
+    void endBlock(AudioBuffer<FloatType>& buffer, int numChannels)
+    {
+        if (fade_countdown == 0) {
+            return;
+        }
+
+        const int numSamples = buffer.getNumSamples();
+        const float step = 1.f / (float) fade_length;
+        const float start = (float) (fading_out ? fade_countdown : fade_length - fade_countdown) * step;
+        const float increment = fading_out ? -step : step;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            FloatType* const samples = buffer.getWritePointer(channel);
+            for (int i = 0; i < numSamples; ++i) {
+                samples[i] *= (FloatType) jlimit(0.f, 1.f, start + increment * (float) (i + 1));
+            }
+        }
+
+        fade_countdown = jmax(0, fade_countdown - numSamples);
+    }
+
+    /// Writes a bank of presets to destination, replacing its contents. Each
+    /// state is data written by ParameterState::save(), e.g. by
+    /// getStateInformation().
+    static void create(MemoryBlock& destination, const StringArray& names, const Array<MemoryBlock>& states)
+    {
+        jassert(names.size() == states.size());
+        const int numPresets = jmin(names.size(), states.size());
+
+        size_t size = (size_t) (headerSize + numPresets * entrySize);
+        for (int i = 0; i < numPresets; ++i) {
+            size += names[i].getNumBytesAsUTF8() + states.getReference(i).getSize();
+        }
+        destination.setSize(size, false);
+
+        uint8* const data = static_cast<uint8*>(destination.getData());
+        size_t offset = (size_t) (headerSize + numPresets * entrySize);
+
+        for (int i = 0; i < numPresets; ++i) {
+            uint8* const entry = data + headerSize + i * entrySize;
+            const size_t nameLength = names[i].getNumBytesAsUTF8();
+            const MemoryBlock& preset = states.getReference(i);
+
+            writeUInt32(entry, (uint32) offset);
+            writeUInt32(entry + 4, (uint32) nameLength);
+            std::memcpy(data + offset, names[i].toRawUTF8(), nameLength);
+            offset += nameLength;
+
+            writeUInt32(entry + 8, (uint32) offset);
+            writeUInt32(entry + 12, (uint32) preset.getSize());
+            std::memcpy(data + offset, preset.getData(), preset.getSize());
+            offset += preset.getSize();
+        }
+
+        writeUInt32(data, magic);
+        writeUInt16(data + 4, version);
+        writeUInt16(data + 6, (uint16) entrySize);
+        writeUInt32(data + 8, (uint32) numPresets);
+        writeUInt32(data + 12, 0);
+    }
+
+private:
+    /// The values of a decoded preset, by parameter index.
+    struct Program {
+        int index;
+        float values[maximumParameters];
+    };
+
+    /// Decodes selected presets.
+    class Decoder : public Thread {
+    public:
+        explicit Decoder(PresetBank& owner)
+        : Thread("Preset decoder"),
+        bank(owner)
+        {
+        }
+
+        void run() override
+        {
+            while (! threadShouldExit()) {
+                wait(-1);
+
+                const int requested = bank.requested_preset.exchange(-1);
+                if (requested >= 0) {
+                    Program& decoded = bank.programs.getWriteBuffer();
+                    if (bank.decode(requested, decoded.values)) {
+                        decoded.index = requested;
+                        bank.programs.publish();
+                    }
+                }
+            }
+        }
+
+    private:
+        PresetBank& bank;
+    };
+
+    /// Decodes a preset into values, by parameter index. Returns false if the
+    /// preset is not in the bank or is not a valid state.
+    bool decode(int index, float* values) const
+    {
+        const ScopedLock lock(bank_lock);
+
+        const uint8* preset;
+        size_t size;
+        return state != nullptr && findEntry(index, 8, preset, size) && state->decode(preset, size, values);
+    }
+
+    /// Switches the parameters to the latest decoded preset on the audio
+    /// thread. Their callbacks are run by the caller.
+    bool apply()
+    {
+        if (! programs.read(program)) {
+            return false;
+        }
+
+        for (int i = 0; i < parameters.size(); ++i) {
+            if (parameters[i] != nullptr) {
+                parameters[i]->storeValue(program.values[i]);
+            }
+        }
+
+        applied_preset.store(program.index);
+        return true;
+    }
+
+    /// Decodes and applies a preset on the calling thread, notifying the host.
+    void applyNow(int index)
+    {
+        HeapBlock<float> values((size_t) jmax(1, parameters.size()));
+        if (! decode(index, values)) {
+            return;
+        }
+
+        for (int i = 0; i < parameters.size(); ++i) {
+            if (parameters[i] != nullptr) {
+                parameters[i]->setValueNotifyingHost(values[i]);
+            }
+        }
+        processor.updateHostDisplay();
+    }
+
+    /// Tells the host the values of the preset last applied on the audio
+    /// thread, if it wasn't told yet.
+    void timerCallback() override
+    {
+        const int applied = applied_preset.exchange(-1);
+        if (applied < 0 || ! decode(applied, notified.values)) {
+            return;
+        }
+
+        for (int i = 0; i < parameters.size(); ++i) {
+            if (parameters[i] != nullptr) {
+                processor.sendParamChangeMessageToListeners(i, notified.values[i]);
+            }
+        }
+        processor.updateHostDisplay();
+    }
+
+    /// Finds the name (field 0) or preset (field 8) of an index entry in the
+    /// mapped file. Returns false if either lies outside the file. Call this
+    /// with bank_lock held.
+    bool findEntry(int index, int field, const uint8*& start, size_t& size) const
+    {
+        if (mapped_file == nullptr || ! isPositiveAndBelow(index, num_presets.load())) {
+            return false;
+        }
+
+        const uint8* const data = static_cast<const uint8*>(mapped_file->getData());
+        const size_t fileSize = mapped_file->getSize();
+        const uint8* const entry = data + headerSize + (size_t) index * readUInt16(data + 6);
+
+        const size_t offset = readUInt32(entry + field);
+        size = readUInt32(entry + field + 4);
+
+        if (offset > fileSize || size > fileSize - offset) {
+            return false;
+        }
+
+        start = data + offset;
+        return true;
+    }
+
+    static void writeUInt16(uint8* d, uint16 v) { d[0] = (uint8) v; d[1] = (uint8) (v >> 8); }
+    static void writeUInt32(uint8* d, uint32 v) { writeUInt16(d, (uint16) v); writeUInt16(d + 2, (uint16) (v >> 16)); }
+
+    static uint16 readUInt16(const uint8* d) { return (uint16) (d[0] | (d[1] << 8)); }
+    static uint32 readUInt32(const uint8* d) { return readUInt16(d) | ((uint32) readUInt16(d + 2) << 16); }
+
+    /// The processor whose host is told about switches.
+    AudioProcessor& processor;
+
+    Decoder decoder;
+
+    /// The PluginParameters by parameter index, or nullptr for other parameters.
+    Array<PluginParameter*> parameters;
+
+    /// Decodes presets into values.
+    const ParameterState* state;
+
+    /// The mapped bank file, replaced under bank_lock.
+    ScopedPointer<MemoryMappedFile> mapped_file;
+    CriticalSection bank_lock;
+    std::atomic<int> num_presets;
+
+    /// The preset last selected.
+    std::atomic<int> current_preset;
+
+    /// The preset to decode next, or -1.
+    std::atomic<int> requested_preset;
+
+    /// The preset last switched to on the audio thread, or -1 once the host
+    /// was told about it.
+    std::atomic<int> applied_preset;
+
+    /// Decoded presets, written by the decoder and read by the audio thread.
+    TripleBuffer<Program> programs;
+
+    /// The preset being switched to. Only used on the audio thread.
+    Program program;
+
+    /// The values of the applied preset sent to the host. Only used on the
+    /// message thread.
+    Program notified;
+
+    /// Whether the processor is prepared, so presets are switched on the audio
+    /// thread.
+    std::atomic<bool> prepared;
+
+    /// The length of the fade around a switch in seconds and samples.
+    double fade_time;
+    int fade_length;
+
+    /// The number of samples left in the fade, and whether it is fading out.
+    int fade_countdown;
+    bool fading_out;
+
+    JUCE_DECLARE_NON_COPYABLE(PresetBank)
+};
+
+
+#endif  // PRESETBANK_H_INCLUDED
@@ -0,0 +1,209 @@
+#ifndef REALFFT_H_INCLUDED
+#define REALFFT_H_INCLUDED
+
+#include <cmath>
+
+/**
+    A fast Fourier transform of real signals of a power of two size, for
+    block convolution and analysis.
+
+    The spectrum of size samples is size / 2 complex bins in two separate
+    arrays, real and imaginary parts. Bin 0 packs the two purely real bins:
+    its real part is the DC bin and its imaginary part the Nyquist bin. Keeping
+    real and imaginary parts apart makes multiplying spectra plain loops that
+    vectorize.
+
+    A signal is transformed as a complex transform of half its size, with the
+    even samples as real and the odd samples as imaginary parts, and the
+    result is then split into the spectrum. The complex transform is an
+    iterative radix-2 transform whose twiddle factors are stored contiguously
+    for each pass. The inverse transform runs the same passes with real and
+    imaginary parts swapped.
+
+    The tables and the work buffers are allocated by the constructor, so
+    transforms never allocate. As the work buffers are shared, use one
+    RealFFT per thread.
+ */
+class RealFFT {
+public:
+    /// Prepares transforms of 2^order samples, with order at least 2.
+    explicit RealFFT(int order)
+    : size(1 << jmax(2, order)),
+    half(size / 2)
+    {
+        work_real.calloc((size_t) half);
+        work_imaginary.calloc((size_t) half);
+        twiddle_real.calloc((size_t) half);
+        twiddle_imaginary.calloc((size_t) half);
+        split_real.calloc((size_t) half);
+        split_imaginary.calloc((size_t) half);
+        bit_reversed.calloc((size_t) half);
+
+        int bits = 0;
+        while ((1 << bits) < half) {
+            ++bits;
+        }
+
+        for (int i = 0; i < half; ++i) {
+            int reversed = 0;
+            for (int bit = 0; bit < bits; ++bit) {
+                reversed |= ((i >> bit) & 1) << (bits - 1 - bit);
+            }
+            bit_reversed[i] = reversed;
+        }
+
+        // The pass combining pairs of length h uses h twiddle factors, stored
+        // from index h - 1
+        for (int h = 1; h < half; h *= 2) {
+            for (int j = 0; j < h; ++j) {
+                const double angle = -double_Pi * j / h;
+                twiddle_real[h - 1 + j] = (float) std::cos(angle);
+                twiddle_imaginary[h - 1 + j] = (float) std::sin(angle);
+            }
+        }
+
+        for (int k = 0; k < half; ++k) {
+            const double angle = -2.0 * double_Pi * k / size;
+            split_real[k] = (float) std::cos(angle);
+            split_imaginary[k] = (float) std::sin(angle);
+        }
+    }
+
+    /// Returns the number of samples transformed.
+    int getSize() const { return size; }
+
+    /// Transforms size samples of input into size / 2 bins of real and
+    /// imaginary parts, packed as described above.
+    void forward(const float* input, float* real, float* imaginary)
+    {
+        for (int i = 0; i < half; ++i) {
+            const int j = bit_reversed[i];
+            real[j] = input[2 * i];
+            imaginary[j] = input[2 * i + 1];
+        }
+
+        transform(real, imaginary);
+
+        const float dc = real[0] + imaginary[0];
+        const float nyquist = real[0] - imaginary[0];
+        real[0] = dc;
+        imaginary[0] = nyquist;
+
+        for (int k = 1; k <= half / 2; ++k) {
+            const int m = half - k;
+
+            // The spectra of the even and odd samples
+            const float evenReal = 0.5f * (real[k] + real[m]);
+            const float evenImaginary = 0.5f * (imaginary[k] - imaginary[m]);
+            const float oddReal = 0.5f * (imaginary[k] + imaginary[m]);
+            const float oddImaginary = -0.5f * (real[k] - real[m]);
+
+            const float wr = split_real[k];
+            const float wi = split_imaginary[k];
+            const float tr = wr * oddReal - wi * oddImaginary;
+            const float ti = wr * oddImaginary + wi * oddReal;
+
+            real[k] = evenReal + tr;
+            imaginary[k] = evenImaginary + ti;
+            real[m] = evenReal - tr;
+            imaginary[m] = -(evenImaginary - ti);
+        }
+    }
+
+    /// Transforms size / 2 packed bins back into size samples of output. The
+    /// output is scaled by size, so a round trip multiplies by size.
+    void inverse(float* real, float* imaginary, float* output)
+    {
+        // The bins of the half size complex transform, doubled, written in bit
+        // reversed order for the passes
+        const float dc = real[0];
+        const float nyquist = imaginary[0];
+        work_real[0] = dc + nyquist;
+        work_imaginary[0] = dc - nyquist;
+
+        for (int k = 1; k <= half / 2; ++k) {
+            const int m = half - k;
+
+            const float evenReal = real[k] + real[m];
+            const float evenImaginary = imaginary[k] - imaginary[m];
+            const float differenceReal = real[k] - real[m];
+            const float differenceImaginary = imaginary[k] + imaginary[m];
+
+            // The odd spectrum is the difference turned back by the twiddle
+            const float wr = split_real[k];
+            const float wi = -split_imaginary[k];
+            const float oddReal = wr * differenceReal - wi * differenceImaginary;
+            const float oddImaginary = wr * differenceImaginary + wi * differenceReal;
+
+            work_real[bit_reversed[k]] = evenReal - oddImaginary;
+            work_imaginary[bit_reversed[k]] = evenImaginary + oddReal;
+            work_real[bit_reversed[m]] = evenReal + oddImaginary;
+            work_imaginary[bit_reversed[m]] = -evenImaginary + oddReal;
+        }
+
+        // Swapping real and imaginary parts turns the forward passes into
+        // inverse ones
+        transform(work_imaginary, work_real);
+
+        for (int i = 0; i < half; ++i) {
+            output[2 * i] = work_real[i];
+            output[2 * i + 1] = work_imaginary[i];
+        }
+    }
+
+private:
+    /// Runs the passes of an in-place complex transform of half bins whose
+    /// input is in bit reversed order.
+    void transform(float* real, float* imaginary) const
+    {
+        for (int i = 0; i < half; i += 2) {
+            const float r = real[i + 1], m = imaginary[i + 1];
+            real[i + 1] = real[i] - r;
+            imaginary[i + 1] = imaginary[i] - m;
+            real[i] += r;
+            imaginary[i] += m;
+        }
+
+        for (int h = 2; h < half; h *= 2) {
+            const float* const wr = twiddle_real + h - 1;
+            const float* const wi = twiddle_imaginary + h - 1;
+
+            for (int start = 0; start < half; start += 2 * h) {
+                float* const ar = real + start;
+                float* const ai = imaginary + start;
+                float* const br = ar + h;
+                float* const bi = ai + h;
+
+                for (int j = 0; j < h; ++j) {
+                    const float tr = wr[j] * br[j] - wi[j] * bi[j];
+                    const float ti = wr[j] * bi[j] + wi[j] * br[j];
+                    br[j] = ar[j] - tr;
+                    bi[j] = ai[j] - ti;
+                    ar[j] += tr;
+                    ai[j] += ti;
+                }
+            }
+        }
+    }
+
+    const int size;
+    const int half;
+
+    HeapBlock<float> work_real;
+    HeapBlock<float> work_imaginary;
+
+    /// The twiddle factors of each pass of the complex transform.
+    HeapBlock<float> twiddle_real;
+    HeapBlock<float> twiddle_imaginary;
+
+    /// The twiddle factors that split the complex transform into the spectrum.
+    HeapBlock<float> split_real;
+    HeapBlock<float> split_imaginary;
+
+    HeapBlock<int> bit_reversed;
+
+    JUCE_DECLARE_NON_COPYABLE(RealFFT)
+};
+
+
+#endif  // REALFFT_H_INCLUDED
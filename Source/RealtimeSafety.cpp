@@ -0,0 +1,404 @@
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "RealtimeSafety.h"
+
+#if REALTIMESAFETY_ENABLED
+
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <execinfo.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+#endif
+
+#if JUCE_LINUX && defined(__GLIBC__)
+ #define REALTIMESAFETY_INTERCEPT_LIBC 1
+ #include <cerrno>
+ #include <cstdarg>
+ #include <cstdio>
+ #include <dlfcn.h>
+ #include <fcntl.h>
+ #include <pthread.h>
+ #include <unistd.h>
+#else
+ #define REALTIMESAFETY_INTERCEPT_LIBC 0
+#endif
+
+#if REALTIMESAFETY_INTERCEPT_LIBC
+// The glibc allocator, which the replaced C functions forward to
+extern "C" {
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+#endif
+
+// Initial-exec thread locals never allocate when first accessed, which matters
+// as they are read from inside malloc
+#if JUCE_MSVC
+ #define REALTIMESAFETY_THREAD_LOCAL __declspec(thread)
+#else
+ #define REALTIMESAFETY_THREAD_LOCAL __thread __attribute__((tls_model("initial-exec")))
+#endif
+
+namespace {
+    REALTIMESAFETY_THREAD_LOCAL int realtime_depth = 0;
+    REALTIMESAFETY_THREAD_LOCAL int non_realtime_depth = 0;
+
+    std::atomic<int> num_violations(0);
+    std::atomic<int> violation_action(JUCE_DEBUG ? RealtimeSafety::assertOnViolations
+                                                 : RealtimeSafety::recordViolations);
+    RealtimeSafety::Record records[RealtimeSafety::maximumRecords];
+
+    inline bool isChecking()
+    {
+        return realtime_depth > 0 && non_realtime_depth == 0;
+    }
+
+    inline void check(RealtimeSafety::Violation type)
+    {
+        if (isChecking()) {
+            RealtimeSafety::reportViolation(type);
+        }
+    }
+
+    int captureStackTrace(void** frames, int maximumFrames)
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        return backtrace(frames, maximumFrames);
+       #elif JUCE_WINDOWS
+        return (int) CaptureStackBackTrace(1, (DWORD) maximumFrames, frames, nullptr);
+       #else
+        return 0;
+       #endif
+    }
+
+   #if REALTIMESAFETY_INTERCEPT_LIBC
+    typedef int (*MutexLockFunction)(pthread_mutex_t*);
+    typedef int (*OpenFunction)(const char*, int, ...);
+    typedef FILE* (*FopenFunction)(const char*, const char*);
+    typedef ssize_t (*ReadFunction)(int, void*, size_t);
+    typedef ssize_t (*WriteFunction)(int, const void*, size_t);
+
+    /// Returns the libc function a hook forwards to.
+    template <typename Function>
+    Function findNext(Function& function, const char* name)
+    {
+        if (function == nullptr) {
+            function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+        }
+        return function;
+    }
+
+    MutexLockFunction next_mutex_lock = nullptr;
+    OpenFunction next_open = nullptr;
+    FopenFunction next_fopen = nullptr;
+    ReadFunction next_read = nullptr;
+    WriteFunction next_write = nullptr;
+
+    /// Finds the libc functions before any audio thread runs, as dlsym() may
+    /// allocate.
+    struct NextFunctions {
+        NextFunctions()
+        {
+            findNext(next_mutex_lock, "pthread_mutex_lock");
+            findNext(next_open, "open");
+            findNext(next_fopen, "fopen");
+            findNext(next_read, "read");
+            findNext(next_write, "write");
+        }
+    } next_functions;
+   #endif
+
+    void* allocate(size_t size)
+    {
+       #if REALTIMESAFETY_INTERCEPT_LIBC
+        return __libc_malloc(size == 0 ? 1 : size);
+       #else
+        return std::malloc(size == 0 ? 1 : size);
+       #endif
+    }
+
+    void deallocate(void* pointer)
+    {
+       #if REALTIMESAFETY_INTERCEPT_LIBC
+        __libc_free(pointer);
+       #else
+        std::free(pointer);
+       #endif
+    }
+}
+
+//==============================================================================
+void RealtimeSafety::setAction(Action action)
+{
+    violation_action.store(action, std::memory_order_relaxed);
+}
+
+bool RealtimeSafety::isRealtimeThread()
+{
+    return isChecking();
+}
+
+void RealtimeSafety::reportViolation(Violation type)
+{
+    if (! isChecking()) {
+        return;
+    }
+
+    // Recording and logging may allocate and lock themselves
+    ++non_realtime_depth;
+
+    const int index = num_violations.fetch_add(1, std::memory_order_relaxed);
+    if (index < maximumRecords) {
+        Record& record = records[index];
+        record.type = type;
+        record.numFrames = captureStackTrace(record.frames, maximumFrames);
+
+        const int action = violation_action.load(std::memory_order_relaxed);
+        if (action != recordViolations) {
+            Logger::writeToLog("Real-time safety violation: " + describe(record));
+        }
+        if (action == assertOnViolations) {
+            jassertfalse;
+        }
+    }
+
+    --non_realtime_depth;
+}
+
+int RealtimeSafety::getNumViolations()
+{
+    return num_violations.load(std::memory_order_acquire);
+}
+
+bool RealtimeSafety::getViolation(int index, Record& record)
+{
+    if (! isPositiveAndBelow(index, jmin(getNumViolations(), (int) maximumRecords))) {
+        return false;
+    }
+
+    record = records[index];
+    return true;
+}
+
+void RealtimeSafety::clearViolations()
+{
+    num_violations.store(0, std::memory_order_release);
+}
+
+String RealtimeSafety::describe(const Record& record)
+{
+    String text = String(getName(record.type)) + " on the audio thread";
+
+   #if JUCE_LINUX || JUCE_MAC
+    if (char** symbols = backtrace_symbols(record.frames, record.numFrames)) {
+        for (int i = 0; i < record.numFrames; ++i) {
+            text += "\n    " + String(symbols[i]);
+        }
+        std::free(symbols);
+    }
+   #else
+    for (int i = 0; i < record.numFrames; ++i) {
+        text += "\n    0x" + String::toHexString((pointer_sized_int) record.frames[i]);
+    }
+   #endif
+
+    return text;
+}
+
+const char* RealtimeSafety::getName(Violation type)
+{
+    switch (type) {
+        case allocation:   return "Allocation";
+        case deallocation: return "Deallocation";
+        case lock:         return "Mutex lock";
+        case fileAccess:   return "File access";
+    }
+    return "";
+}
+
+void RealtimeSafety::enterRealtime()
+{
+    ++realtime_depth;
+}
+
+void RealtimeSafety::exitRealtime()
+{
+    --realtime_depth;
+}
+
+void RealtimeSafety::enterNonRealtime()
+{
+    ++non_realtime_depth;
+}
+
+void RealtimeSafety::exitNonRealtime()
+{
+    --non_realtime_depth;
+}
+
+//==============================================================================
+// operator new and delete are replaced on every platform
+
+void* operator new(size_t size)
+{
+    check(RealtimeSafety::allocation);
+
+    if (void* pointer = allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    check(RealtimeSafety::allocation);
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr) {
+        check(RealtimeSafety::deallocation);
+        deallocate(pointer);
+    }
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    operator delete(pointer);
+}
+
+//==============================================================================
+// On Linux the libc functions are replaced too, forwarding to glibc. The file
+// functions are defined under their symbol names with asm labels, as
+// _FORTIFY_SOURCE may already define inline wrappers with the same names
+
+#if REALTIMESAFETY_INTERCEPT_LIBC
+extern "C" {
+    void* malloc(size_t size)
+    {
+        check(RealtimeSafety::allocation);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        check(RealtimeSafety::allocation);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        check(RealtimeSafety::allocation);
+        return __libc_realloc(pointer, size);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        check(RealtimeSafety::allocation);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** pointer, size_t alignment, size_t size)
+    {
+        check(RealtimeSafety::allocation);
+        *pointer = __libc_memalign(alignment, size);
+        return *pointer != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr) {
+            check(RealtimeSafety::deallocation);
+        }
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        check(RealtimeSafety::lock);
+        return findNext(next_mutex_lock, "pthread_mutex_lock")(mutex);
+    }
+
+    int realtimeSafetyOpen(const char* path, int flags, ...) __asm__("open");
+    int realtimeSafetyOpen(const char* path, int flags, ...)
+    {
+        mode_t mode = 0;
+        if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE) {
+            va_list args;
+            va_start(args, flags);
+            mode = (mode_t) va_arg(args, int);
+            va_end(args);
+        }
+
+        check(RealtimeSafety::fileAccess);
+        return findNext(next_open, "open")(path, flags, mode);
+    }
+
+    FILE* realtimeSafetyFopen(const char* path, const char* mode) __asm__("fopen");
+    FILE* realtimeSafetyFopen(const char* path, const char* mode)
+    {
+        check(RealtimeSafety::fileAccess);
+        return findNext(next_fopen, "fopen")(path, mode);
+    }
+
+    ssize_t realtimeSafetyRead(int file, void* buffer, size_t size) __asm__("read");
+    ssize_t realtimeSafetyRead(int file, void* buffer, size_t size)
+    {
+        check(RealtimeSafety::fileAccess);
+        return findNext(next_read, "read")(file, buffer, size);
+    }
+
+    ssize_t realtimeSafetyWrite(int file, const void* buffer, size_t size) __asm__("write");
+    ssize_t realtimeSafetyWrite(int file, const void* buffer, size_t size)
+    {
+        check(RealtimeSafety::fileAccess);
+        return findNext(next_write, "write")(file, buffer, size);
+    }
+}
+#endif
+
+#else
+
+//==============================================================================
+// Checking is compiled out, so nothing is ever reported
+
+void RealtimeSafety::setAction(Action) {}
+bool RealtimeSafety::isRealtimeThread() { return false; }
+void RealtimeSafety::reportViolation(Violation) {}
+int RealtimeSafety::getNumViolations() { return 0; }
+bool RealtimeSafety::getViolation(int, Record&) { return false; }
+void RealtimeSafety::clearViolations() {}
+String RealtimeSafety::describe(const Record&) { return String(); }
+const char* RealtimeSafety::getName(Violation) { return ""; }
+void RealtimeSafety::enterRealtime() {}
+void RealtimeSafety::exitRealtime() {}
+void RealtimeSafety::enterNonRealtime() {}
+void RealtimeSafety::exitNonRealtime() {}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef REALTIMESAFETY_H_INCLUDED
+#define REALTIMESAFETY_H_INCLUDED
+
+#include <atomic>
+
+// Checking is on in debug builds. Define REALTIMESAFETY_ENABLED=1 to also check
+// release builds, e.g. the benchmark harness, or 0 to turn it off
+#ifndef REALTIMESAFETY_ENABLED
+ #if JUCE_DEBUG
+  #define REALTIMESAFETY_ENABLED 1
+ #else
+  #define REALTIMESAFETY_ENABLED 0
+ #endif
+#endif
+
+/**
+    Detects code that is not real-time safe running on the audio thread.
+
+    The processor marks the extent of processBlock() with a ScopedRealtime and
+    of prepareToPlay() with a ScopedNonRealtime, as some hosts call
+    prepareToPlay() from the audio thread. While a thread is inside a
+    ScopedRealtime, the following are reported as violations:
+
+    - allocation: malloc, calloc, realloc, memalign and operator new.
+    - deallocation: free and operator delete.
+    - lock: locking a mutex, which includes CriticalSection and std::mutex.
+    - fileAccess: opening, reading or writing files.
+
+    Each violation is counted, and the first maximumRecords are recorded with a
+    stack trace. Depending on setAction() a violation is also logged, or logged
+    and asserted. Code that knows it blocks can call reportViolation() itself.
+
+    operator new and delete are replaced on every platform. On Linux the C
+    allocation, pthread mutex and file functions are intercepted as well; in a
+    plugin this covers calls made from the plugin's own code, in an executable
+    such as the benchmark harness it covers every call.
+
+    When REALTIMESAFETY_ENABLED is 0 the scopes compile to nothing and no
+    functions are intercepted.
+ */
+struct RealtimeSafety {
+    /// The kinds of violation detected.
+    enum Violation {
+        allocation,
+        deallocation,
+        lock,
+        fileAccess
+    };
+
+    /// What to do when a violation is detected, besides recording it.
+    enum Action {
+        recordViolations,       ///< Only record it, e.g. to check in a test
+        logViolations,          ///< Write it to the log with its stack trace
+        assertOnViolations      ///< Log it and trigger jassertfalse
+    };
+
+    /// The number of stack frames recorded per violation.
+    static const int maximumFrames = 32;
+
+    /// The number of violations recorded with a stack trace.
+    static const int maximumRecords = 64;
+
+    /// A recorded violation.
+    struct Record {
+        Violation type;
+        int numFrames;
+        void* frames[maximumFrames];
+    };
+
+   #if REALTIMESAFETY_ENABLED
+    /// Marks the calling thread as real-time for the lifetime of the object.
+    class ScopedRealtime {
+    public:
+        ScopedRealtime() { enterRealtime(); }
+        ~ScopedRealtime() { exitRealtime(); }
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtime)
+    };
+
+    /// Allows code that is not real-time safe within a ScopedRealtime, e.g.
+    /// prepareToPlay() called from the audio thread.
+    class ScopedNonRealtime {
+    public:
+        ScopedNonRealtime() { enterNonRealtime(); }
+        ~ScopedNonRealtime() { exitNonRealtime(); }
+        JUCE_DECLARE_NON_COPYABLE(ScopedNonRealtime)
+    };
+   #else
+    class ScopedRealtime {
+    public:
+        ScopedRealtime() {}
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtime)
+    };
+
+    class ScopedNonRealtime {
+    public:
+        ScopedNonRealtime() {}
+        JUCE_DECLARE_NON_COPYABLE(ScopedNonRealtime)
+    };
+   #endif
+
+    /// Returns true if checking was compiled in.
+    static bool isEnabled()
+    {
+        return REALTIMESAFETY_ENABLED != 0;
+    }
+
+    /// Sets what happens on a violation. The default is assertOnViolations in
+    /// debug builds and recordViolations otherwise.
+    static void setAction(Action action);
+
+    /// Returns true if the calling thread is inside a ScopedRealtime and not
+    /// inside a ScopedNonRealtime.
+    static bool isRealtimeThread();
+
+    /// Reports a violation if the calling thread is real-time.
+    static void reportViolation(Violation type);
+
+    /// Returns the number of violations since the last clearViolations().
+    static int getNumViolations();
+
+    /// Copies a recorded violation to record. Returns false if index is not
+    /// below jmin(getNumViolations(), maximumRecords).
+    static bool getViolation(int index, Record& record);
+
+    /// Forgets all violations. Do not call this while a real-time thread runs.
+    static void clearViolations();
+
+    /// Returns a description of a violation with its symbolized stack trace.
+    /// This allocates, so do not call it from the audio thread.
+    static String describe(const Record& record);
+
+    /// Returns the name of a kind of violation.
+    static const char* getName(Violation type);
+
+private:
+    static void enterRealtime();
+    static void exitRealtime();
+    static void enterNonRealtime();
+    static void exitNonRealtime();
+};
+
+
+#endif  // REALTIMESAFETY_H_INCLUDED
@@ -0,0 +1,78 @@
+#ifndef SCOPEDFLUSHDENORMALS_H_INCLUDED
+#define SCOPEDFLUSHDENORMALS_H_INCLUDED
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define SCOPEDFLUSHDENORMALS_USE_SSE 1
+ #include <immintrin.h>
+#else
+ #define SCOPEDFLUSHDENORMALS_USE_SSE 0
+#endif
+
+/**
+    Flushes denormal floats to zero on the calling thread for the lifetime of the
+    object, restoring the previous mode afterwards.
+
+    Feedback paths such as filters and reverbs decay towards zero through the
+    denormal range, where every operation can be a hundred times slower. With
+    flushing on, results and inputs that would be denormal are treated as zero
+    instead.
+
+    On x86 this sets the FTZ and DAZ bits of MXCSR, on ARM64 the FZ bit of FPCR.
+    Elsewhere it does nothing. The mode only applies to the calling thread, so
+    create one at the top of processBlock() rather than once in prepareToPlay().
+ */
+class ScopedFlushDenormals {
+public:
+    ScopedFlushDenormals()
+    : previous_mode(getMode())
+    {
+        setMode(previous_mode | flushMode);
+    }
+
+    ~ScopedFlushDenormals()
+    {
+        setMode(previous_mode);
+    }
+
+private:
+   #if SCOPEDFLUSHDENORMALS_USE_SSE
+    typedef unsigned int Mode;
+
+    /// The FTZ and DAZ bits of MXCSR.
+    static const Mode flushMode = 0x8040;
+
+    static Mode getMode() { return _mm_getcsr(); }
+    static void setMode(Mode mode) { _mm_setcsr(mode); }
+   #elif defined(__aarch64__)
+    typedef uint64 Mode;
+
+    /// The FZ bit of FPCR.
+    static const Mode flushMode = (Mode) 1 << 24;
+
+    static Mode getMode()
+    {
+        Mode mode;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode));
+        return mode;
+    }
+
+    static void setMode(Mode mode)
+    {
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+    }
+   #else
+    typedef int Mode;
+
+    static const Mode flushMode = 0;
+
+    static Mode getMode() { return 0; }
+    static void setMode(Mode) {}
+   #endif
+
+    const Mode previous_mode;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedFlushDenormals)
+};
+
+
+#endif  // SCOPEDFLUSHDENORMALS_H_INCLUDED
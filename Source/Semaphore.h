@@ -0,0 +1,56 @@
+#ifndef SEMAPHORE_H_INCLUDED
+#define SEMAPHORE_H_INCLUDED
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+/**
+    A counting semaphore whose signal() never locks a mutex, unlike
+    WaitableEvent, so the audio thread can wake other threads.
+
+    It includes the platform headers, so only include it from .cpp files.
+ */
+class Semaphore {
+public:
+   #if JUCE_MAC || JUCE_IOS
+    Semaphore() : semaphore(dispatch_semaphore_create(0)) {}
+    ~Semaphore() { dispatch_release(semaphore); }
+    void signal() { dispatch_semaphore_signal(semaphore); }
+    void wait() { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+
+private:
+    dispatch_semaphore_t semaphore;
+   #elif JUCE_WINDOWS
+    Semaphore() : semaphore(CreateSemaphore(nullptr, 0, 0x7fffffff, nullptr)) {}
+    ~Semaphore() { CloseHandle(semaphore); }
+    void signal() { ReleaseSemaphore(semaphore, 1, nullptr); }
+    void wait() { WaitForSingleObject(semaphore, INFINITE); }
+
+private:
+    HANDLE semaphore;
+   #else
+    Semaphore() { sem_init(&semaphore, 0, 0); }
+    ~Semaphore() { sem_destroy(&semaphore); }
+    void signal() { sem_post(&semaphore); }
+
+    void wait()
+    {
+        while (sem_wait(&semaphore) != 0 && errno == EINTR) {
+        }
+    }
+
+private:
+    sem_t semaphore;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE(Semaphore)
+};
+
+
+#endif  // SEMAPHORE_H_INCLUDED
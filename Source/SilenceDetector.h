@@ -0,0 +1,199 @@
+#ifndef SILENCEDETECTOR_H_INCLUDED
+#define SILENCEDETECTOR_H_INCLUDED
+
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define SILENCEDETECTOR_USE_SSE 1
+ #include <emmintrin.h>
+#else
+ #define SILENCEDETECTOR_USE_SSE 0
+#endif
+
+/**
+    Decides whether a block needs processing, so the DSP can sleep while the
+    input is silent and its tail has decayed.
+
+    The processor calls process() with each input block before running the DSP.
+    A block is silent when no sample of any channel is above the threshold. Any
+    block that is not silent keeps the DSP awake and restarts a countdown of the
+    tail length plus the latency. Once the input has been silent for the whole
+    countdown, process() returns false until the next block that is not silent,
+    which it returns true for immediately.
+
+    The tail is how long the DSP keeps producing output after its input goes
+    silent, e.g. the decay of a reverb. An infinite tail, for DSP that generates
+    sound by itself, keeps it awake forever.
+ */
+class SilenceDetector {
+public:
+    SilenceDetector()
+    : threshold(0.00001f),
+    tail_length(0.0),
+    sample_rate(44100.0),
+    latency(0),
+    tail_samples(0),
+    samples_remaining(0)
+    {
+    }
+
+    /// Sets the level below which input counts as silent. The default is -100 dB.
+    void setThreshold(float decibels)
+    {
+        threshold = std::pow(10.f, decibels / 20.f);
+    }
+
+    /// Sets how long the DSP keeps producing output after its input goes silent,
+    /// in seconds. Call this before prepare().
+    void setTailLength(double seconds)
+    {
+        tail_length = jmax(0.0, seconds);
+        updateTailSamples();
+    }
+
+    /// Returns the tail length in seconds.
+    double getTailLength() const
+    {
+        return tail_length;
+    }
+
+    /// Sets the sample rate and wakes the DSP. Call this from prepareToPlay().
+    void prepare(double sampleRate)
+    {
+        sample_rate = sampleRate;
+        updateTailSamples();
+        wake();
+    }
+
+    /// Sets the latency of the DSP in samples, which is waited for on top of the
+    /// tail, as the output lags the input by that much.
+    void setLatency(int numSamples)
+    {
+        latency = jmax(0, numSamples);
+        updateTailSamples();
+    }
+
+    /// Restarts the countdown as if the input was not silent, e.g. when a MIDI
+    /// message arrives.
+    void wake()
+    {
+        samples_remaining = tail_samples;
+    }
+
+    /// Checks the first numChannels channels of a block, of float or double
+    /// samples, and returns true if the DSP should process it.
+    template <typename FloatType>
+    bool process(const AudioBuffer<FloatType>& buffer, int numChannels)
+    {
+        const int numSamples = buffer.getNumSamples();
+        numChannels = jmin(numChannels, buffer.getNumChannels());
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            if (exceeds(buffer.getReadPointer(channel), numSamples, threshold)) {
+                wake();
+                return true;
+            }
+        }
+
+        if (tail_samples < 0) {
+            return true;
+        }
+
+        if (samples_remaining <= 0) {
+            return false;
+        }
+
+        samples_remaining -= numSamples;
+        return true;
+    }
+
+    /// Returns true if the absolute value of any of numSamples samples is above
+    /// threshold.
+    static bool exceeds(const float* samples, int numSamples, float threshold)
+    {
+        int i = 0;
+
+       #if SILENCEDETECTOR_USE_SSE
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 threshold4 = _mm_set1_ps(threshold);
+
+        // Sixteen samples at a time, so the branch is rare and sound is found
+        // without scanning the rest of the block
+        for (; i + 16 <= numSamples; i += 16) {
+            const __m128 a = _mm_and_ps(_mm_loadu_ps(samples + i), signMask);
+            const __m128 b = _mm_and_ps(_mm_loadu_ps(samples + i + 4), signMask);
+            const __m128 c = _mm_and_ps(_mm_loadu_ps(samples + i + 8), signMask);
+            const __m128 d = _mm_and_ps(_mm_loadu_ps(samples + i + 12), signMask);
+            const __m128 maximum = _mm_max_ps(_mm_max_ps(a, b), _mm_max_ps(c, d));
+
+            if (_mm_movemask_ps(_mm_cmpgt_ps(maximum, threshold4)) != 0) {
+                return true;
+            }
+        }
+       #endif
+
+        for (; i < numSamples; ++i) {
+            if (std::abs(samples[i]) > threshold) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Returns true if the absolute value of any of numSamples double samples
+    /// is above threshold.
+    static bool exceeds(const double* samples, int numSamples, float threshold)
+    {
+        int i = 0;
+
+       #if SILENCEDETECTOR_USE_SSE
+        const __m128d signMask = _mm_castsi128_pd(_mm_set_epi32(0x7fffffff, -1, 0x7fffffff, -1));
+        const __m128d threshold2 = _mm_set1_pd(threshold);
+
+        for (; i + 8 <= numSamples; i += 8) {
+            const __m128d a = _mm_and_pd(_mm_loadu_pd(samples + i), signMask);
+            const __m128d b = _mm_and_pd(_mm_loadu_pd(samples + i + 2), signMask);
+            const __m128d c = _mm_and_pd(_mm_loadu_pd(samples + i + 4), signMask);
+            const __m128d d = _mm_and_pd(_mm_loadu_pd(samples + i + 6), signMask);
+            const __m128d maximum = _mm_max_pd(_mm_max_pd(a, b), _mm_max_pd(c, d));
+
+            if (_mm_movemask_pd(_mm_cmpgt_pd(maximum, threshold2)) != 0) {
+                return true;
+            }
+        }
+       #endif
+
+        for (; i < numSamples; ++i) {
+            if (std::abs(samples[i]) > threshold) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    void updateTailSamples()
+    {
+        const double numSamples = std::ceil(tail_length * sample_rate) + latency;
+
+        // A tail too long to count down is treated as infinite
+        tail_samples = numSamples < (double) std::numeric_limits<int>::max() ? (int) numSamples : -1;
+    }
+
+    float threshold;
+    double tail_length;
+    double sample_rate;
+    int latency;
+
+    /// The number of silent samples before the DSP sleeps, or -1 to never sleep.
+    int tail_samples;
+
+    /// The number of silent samples left before the DSP sleeps.
+    int samples_remaining;
+
+    JUCE_DECLARE_NON_COPYABLE(SilenceDetector)
+};
+
+
+#endif  // SILENCEDETECTOR_H_INCLUDED
@@ -0,0 +1,91 @@
+#ifndef TRIPLEBUFFER_H_INCLUDED
+#define TRIPLEBUFFER_H_INCLUDED
+
+#include <atomic>
+
+/**
+    Hands the latest value from one thread to another without either waiting.
+
+    The writer fills getWriteBuffer() and calls publish(), the reader calls
+    read() to take the latest published value. There are three slots: the
+    writer always owns one to write to, the reader always owns one to read
+    from, and the third holds the latest published value. Publishing and
+    reading swap a slot with the middle one, so neither side ever blocks and
+    the reader never sees a partially written value. Values published before
+    the reader took them are replaced.
+
+    Type must be trivially copyable. There must only ever be one writer thread
+    and one reader thread at a time.
+ */
+template <typename Type>
+class TripleBuffer {
+public:
+    TripleBuffer()
+    : slots(),
+    back(2),
+    front(0),
+    state(1)
+    {
+    }
+
+    /// Returns the slot to fill before calling publish(). Only call this from
+    /// the writer thread.
+    Type& getWriteBuffer()
+    {
+        return slots[back];
+    }
+
+    /// Makes the filled slot the latest value. Only call this from the writer
+    /// thread.
+    void publish()
+    {
+        back = state.exchange(back | unread, std::memory_order_acq_rel) & slotMask;
+    }
+
+    /// Returns true if a value was published that the reader has not taken yet.
+    /// Safe to call from the writer thread.
+    bool hasUnreadValue() const
+    {
+        return (state.load(std::memory_order_acquire) & unread) != 0;
+    }
+
+    /// Copies the latest value to value and returns true, or returns false if
+    /// nothing was published since the previous call. Only call this from the
+    /// reader thread.
+    bool read(Type& value)
+    {
+        if ((state.load(std::memory_order_relaxed) & unread) == 0) {
+            return false;
+        }
+
+        front = state.exchange(front, std::memory_order_acq_rel) & slotMask;
+        value = slots[front];
+        return true;
+    }
+
+private:
+    /// The flag set in state when the middle slot has not been read.
+    static const int unread = 4;
+
+    /// The bits of state holding the index of the middle slot.
+    static const int slotMask = 3;
+
+    Type slots[3];
+
+    /// The slot owned by the writer.
+    int back;
+
+    /// The slot owned by the reader. It is padded apart from back so the two
+    /// threads do not write to the same cache line.
+    char back_padding[64];
+    int front;
+    char front_padding[64];
+
+    /// The index of the middle slot, and unread if it has not been read.
+    std::atomic<int> state;
+
+    JUCE_DECLARE_NON_COPYABLE(TripleBuffer)
+};
+
+
+#endif  // TRIPLEBUFFER_H_INCLUDED
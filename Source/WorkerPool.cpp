@@ -0,0 +1,191 @@
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WorkerPool.h"
+#include "RealtimeSafety.h"
+#include "Semaphore.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+#endif
+
+namespace {
+    /// The number of times the caller of run() checks for the workers to finish
+    /// before it waits. At a few dozen cycles per check this is some tens of
+    /// microseconds, short against a block but long enough to cover most jobs.
+    const int joinSpinIterations = 2000;
+
+    /// The priority of the workers. On Linux any priority above 0 is SCHED_RR,
+    /// if the process is allowed real-time scheduling.
+    const int workerPriority = 9;
+
+    /// Tells the CPU the thread is spinning.
+    inline void pause()
+    {
+       #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        _mm_pause();
+       #elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+       #endif
+    }
+}
+
+//==============================================================================
+/// A worker thread, which runs jobs whenever it is woken until there are none
+/// left.
+class WorkerPool::Worker : public Thread {
+public:
+    Worker(WorkerPool& p, int index)
+    : Thread("Worker " + String(index + 1)),
+    pool(p)
+    {
+    }
+
+    void run() override
+    {
+        // Jobs are part of processBlock(), so they are checked like it
+        const RealtimeSafety::ScopedRealtime realtime;
+
+        for (;;) {
+            pool.work_available->wait();
+
+            if (threadShouldExit()) {
+                break;
+            }
+
+            bool completedLast = false;
+            while (pool.runNextJob(completedLast)) {
+                if (completedLast) {
+                    pool.work_done->signal();
+                }
+            }
+        }
+    }
+
+private:
+    WorkerPool& pool;
+    JUCE_DECLARE_NON_COPYABLE(Worker)
+};
+
+//==============================================================================
+WorkerPool::WorkerPool()
+: work_available(new Semaphore()),
+work_done(new Semaphore()),
+job_function(nullptr),
+job_context(nullptr),
+claims(0),
+jobs_done(0)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::start(int numThreads)
+{
+    stop();
+
+    numThreads = jlimit(0, (int) maximumThreads, numThreads);
+
+    // Affinity masks cover the first 32 cores, so larger machines pin the
+    // workers among those
+    const int numCores = jmin(SystemStats::getNumCpus(), 32);
+
+    for (int i = 0; i < numThreads; ++i) {
+        Worker* worker = workers.add(new Worker(*this, i));
+
+        // Leave the first core for the host, which often runs its own audio
+        // thread there
+        if (numCores > 1) {
+            worker->setAffinityMask((uint32) 1 << (1 + i % (numCores - 1)));
+        }
+
+        worker->startThread(workerPriority);
+    }
+}
+
+void WorkerPool::stop()
+{
+    for (int i = 0; i < workers.size(); ++i) {
+        workers[i]->signalThreadShouldExit();
+    }
+    for (int i = 0; i < workers.size(); ++i) {
+        work_available->signal();
+    }
+    for (int i = 0; i < workers.size(); ++i) {
+        workers[i]->stopThread(1000);
+    }
+
+    workers.clear();
+
+    // Drop wake-ups no worker took, so they don't carry over to the next start()
+    work_available = new Semaphore();
+    work_done = new Semaphore();
+}
+
+int WorkerPool::getNumThreads() const
+{
+    return workers.size();
+}
+
+void WorkerPool::run(int numJobs, JobFunction function, void* context)
+{
+    if (numJobs <= 0) {
+        return;
+    }
+
+    if (workers.size() == 0 || numJobs == 1) {
+        for (int job = 0; job < numJobs; ++job) {
+            function(context, job);
+        }
+        return;
+    }
+
+    job_function = function;
+    job_context = context;
+    jobs_done.store(0, std::memory_order_relaxed);
+    claims.store((int64) numJobs << 32, std::memory_order_release);
+
+    // The caller takes one job itself
+    const int numWakes = jmin(workers.size(), numJobs - 1);
+    for (int i = 0; i < numWakes; ++i) {
+        work_available->signal();
+    }
+
+    // Steal every job no worker has claimed yet, including those of late
+    // workers. Jobs already claimed are waited for below however long their
+    // worker takes, e.g. if it is preempted, so this is not a deadline
+    bool completedLast = false;
+    bool ranLast = false;
+    while (runNextJob(completedLast)) {
+        ranLast = ranLast || completedLast;
+    }
+
+    // Wait for the jobs still running on workers. The worker finishing the last
+    // one signals work_done, which the spinning usually makes free to take
+    if (! ranLast) {
+        for (int i = 0; i < joinSpinIterations && jobs_done.load(std::memory_order_acquire) < numJobs; ++i) {
+            pause();
+        }
+        work_done->wait();
+    }
+
+    // Workers woken late find no jobs until the next batch
+    claims.store(0, std::memory_order_relaxed);
+}
+
+bool WorkerPool::runNextJob(bool& completedLast)
+{
+    const int64 claim = claims.fetch_add(1, std::memory_order_acq_rel);
+    const int numJobs = (int) (claim >> 32);
+    const int job = (int) (claim & 0xffffffff);
+
+    if (job >= numJobs) {
+        return false;
+    }
+
+    job_function(job_context, job);
+
+    completedLast = jobs_done.fetch_add(1, std::memory_order_acq_rel) == numJobs - 1;
+    return true;
+}
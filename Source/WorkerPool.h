@@ -0,0 +1,113 @@
+#ifndef WORKERPOOL_H_INCLUDED
+#define WORKERPOOL_H_INCLUDED
+
+#include <atomic>
+
+class Semaphore;
+
+/**
+    Spreads independent jobs of a block, e.g. channels or bands, over worker
+    threads so heavy DSP can use more than one core.
+
+    The processor starts the pool in prepareToPlay() and stops it in
+    releaseResources(). In processBlock() run() hands out numJobs jobs, takes
+    part in them itself and returns once every job is done:
+
+    @code
+    auto processChannel = [&] (int channel)
+    {
+        convolvers[channel].process (buffer.getWritePointer (channel), numSamples);
+    };
+    workerPool.run (numChannels, processChannel);
+    @endcode
+
+    Jobs are claimed from a single atomic counter, so run() never allocates or
+    locks. Workers are woken with a semaphore, and the caller steals every job
+    no worker has claimed by the time it is free and runs it inline, so a
+    worker that wakes up late only costs the time of the jobs it did claim.
+    The caller then spins for the remaining workers to finish before waiting
+    on a semaphore. That wait is not bounded: a job a worker claimed and was
+    then preempted in holds up run() until the worker gets to finish it.
+
+    Workers run with real-time priority where the platform allows it and are
+    each pinned to a core other than the first. Affinity masks only cover the
+    first 32 cores, so on larger machines workers are pinned among those. Without any threads, run()
+    simply runs every job in turn on the calling thread.
+ */
+class WorkerPool {
+public:
+    /// A job of run(), called with the context passed to run() and the index of
+    /// the job from 0 to numJobs - 1.
+    typedef void (*JobFunction)(void* context, int job);
+
+    /// The largest number of worker threads.
+    static const int maximumThreads = 31;
+
+    WorkerPool();
+    ~WorkerPool();
+
+    /// Starts numThreads worker threads, stopping any running ones first. Call
+    /// this from prepareToPlay(), as it allocates and may take a while.
+    void start(int numThreads);
+
+    /// Stops the worker threads. Call this from releaseResources() or the
+    /// destructor, never while run() may be running.
+    void stop();
+
+    /// Returns the number of worker threads running.
+    int getNumThreads() const;
+
+    /// Runs function(context, job) for every job from 0 to numJobs - 1 across
+    /// the calling thread and the workers, and returns when all are done. Jobs
+    /// may run in any order and at the same time, so they must not share state
+    /// they write to. Only call this from one thread at a time.
+    void run(int numJobs, JobFunction function, void* context);
+
+    /// Runs function(job) for every job from 0 to numJobs - 1, see above. The
+    /// function is called by reference, so a lambda capturing by reference does
+    /// not allocate.
+    template <typename Function>
+    void run(int numJobs, Function& function)
+    {
+        run(numJobs, &callFunction<Function>, &function);
+    }
+
+private:
+    class Worker;
+
+    template <typename Function>
+    static void callFunction(void* context, int job)
+    {
+        (*static_cast<Function*>(context))(job);
+    }
+
+    /// Claims and runs the next job of the current batch. Returns false if
+    /// there are none left, otherwise sets completedLast if it was the last of
+    /// the batch to finish.
+    bool runNextJob(bool& completedLast);
+
+    OwnedArray<Worker> workers;
+
+    /// Signalled once for each worker needed by a batch.
+    ScopedPointer<Semaphore> work_available;
+
+    /// Signalled by the worker that finishes the last job of a batch.
+    ScopedPointer<Semaphore> work_done;
+
+    /// The job of the current batch.
+    JobFunction job_function;
+    void* job_context;
+
+    /// The number of jobs of the current batch in the upper 32 bits and the
+    /// index of the next job to claim in the lower 32 bits, so a claim reads
+    /// both at once. The number of jobs is 0 between batches.
+    std::atomic<int64> claims;
+
+    /// The number of jobs of the current batch that are finished.
+    std::atomic<int> jobs_done;
+
+    JUCE_DECLARE_NON_COPYABLE(WorkerPool)
+};
+
+
+#endif  // WORKERPOOL_H_INCLUDED
@@ -0,0 +1,298 @@
+#ifndef ZONEPROFILER_H_INCLUDED
+#define ZONEPROFILER_H_INCLUDED
+
+#include <cmath>
+#include <cstring>
+
+#include "TripleBuffer.h"
+
+// Profiling is on in debug builds. Define ZONEPROFILER_ENABLED=1 to profile a
+// release build, or 0 to remove the timers entirely
+#ifndef ZONEPROFILER_ENABLED
+ #if JUCE_DEBUG
+  #define ZONEPROFILER_ENABLED 1
+ #else
+  #define ZONEPROFILER_ENABLED 0
+ #endif
+#endif
+
+/**
+    Measures how much of the block deadline each stage of processBlock() uses.
+
+    Register the zones once with addZone(), before processing starts. In
+    processBlock(), a ScopedBlock times the whole block, zone 0, and a
+    ScopedZone times the code in its scope:
+
+    @code
+    const ZoneProfiler::ScopedBlock block (profiler, buffer.getNumSamples());
+    ...
+    {
+        const ZoneProfiler::ScopedZone zone (profiler, filterZone);
+        // ...filter the buffer...
+    }
+    @endcode
+
+    A zone can be entered several times per block, e.g. once per sub-block, and
+    its times add up. At the end of each block the load of each zone, its time
+    divided by the deadline of numSamples / sampleRate, goes into a fixed size
+    histogram. The audio thread never allocates or locks. About ten times a
+    second the statistics are published to the editor, which takes them with
+    read() without blocking the audio thread.
+
+    Time is read with Time::getHighResolutionTicks(), which uses the TSC or the
+    steady system clock depending on the platform. When ZONEPROFILER_ENABLED is
+    0 the scoped timers compile to nothing and read() never returns anything.
+ */
+class ZoneProfiler {
+public:
+    /// The largest number of zones, including the whole block.
+    static const int maximumZones = 16;
+
+    /// The number of histogram bins. Bins are spaced by a factor of sqrt(2),
+    /// see getBinLowerBound().
+    static const int numBins = 24;
+
+    /// The statistics of a zone over a publishing interval. Loads are fractions
+    /// of the block deadline, so 1 is a block that took as long as it lasts.
+    struct ZoneStatistics {
+        /// The mean load over all blocks.
+        float averageLoad;
+
+        /// The highest load of a single block.
+        float maximumLoad;
+
+        /// The number of blocks with a load in each bin.
+        uint32 histogram[numBins];
+    };
+
+    /// The statistics of every zone over a publishing interval.
+    struct Snapshot {
+        /// The number of zones, including the whole block.
+        int numZones;
+
+        /// The number of blocks measured.
+        int numBlocks;
+
+        ZoneStatistics zones[maximumZones];
+    };
+
+    ZoneProfiler()
+    : ticks_per_sample(0.0),
+    publish_interval(4410),
+    num_zones(1),
+    num_blocks(0),
+    num_samples(0),
+    deadline_ticks(0.0),
+    block_start(0)
+    {
+        names.add("Block");
+        clearStatistics();
+    }
+
+    /// Registers a zone and returns its index for ScopedZone, or -1 if there
+    /// are already maximumZones. Only call this before processing starts.
+    int addZone(const String& name)
+    {
+        if (num_zones >= maximumZones) {
+            jassertfalse;
+            return -1;
+        }
+
+        names.add(name);
+        return num_zones++;
+    }
+
+    /// Returns the number of zones, including the whole block.
+    int getNumZones() const
+    {
+        return num_zones;
+    }
+
+    /// Returns the name of a zone.
+    String getZoneName(int zone) const
+    {
+        return names[zone];
+    }
+
+    /// Sets the sample rate used to work out block deadlines. Call this from
+    /// prepareToPlay().
+    void prepare(double sampleRate)
+    {
+        ticks_per_sample = (double) Time::getHighResolutionTicksPerSecond() / jmax(1.0, sampleRate);
+        publish_interval = jmax(1, roundToInt(sampleRate * 0.1));
+        clearStatistics();
+    }
+
+    /// Copies the statistics published since the previous call to snapshot and
+    /// returns true, or returns false if there are none. Never blocks. Only call
+    /// this from the editor's thread.
+    bool read(Snapshot& snapshot)
+    {
+        return published.read(snapshot);
+    }
+
+    /// Returns the lowest load counted in a histogram bin. Bin 20 starts at a
+    /// load of 1, the deadline, and the last bin holds everything above.
+    static float getBinLowerBound(int bin)
+    {
+        return bin == 0 ? 0.f : std::pow(2.f, (bin - 20) * 0.5f);
+    }
+
+   #if ZONEPROFILER_ENABLED
+    /// Times a whole block. Only use this on the audio thread.
+    class ScopedBlock {
+    public:
+        ScopedBlock(ZoneProfiler& p, int numSamples)
+        : profiler(p)
+        {
+            profiler.beginBlock(numSamples);
+        }
+
+        ~ScopedBlock()
+        {
+            profiler.endBlock();
+        }
+
+    private:
+        ZoneProfiler& profiler;
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    /// Adds the time spent in its scope to a zone. Only use this on the audio
+    /// thread within a ScopedBlock.
+    class ScopedZone {
+    public:
+        ScopedZone(ZoneProfiler& p, int zoneIndex)
+        : profiler(p),
+        zone(zoneIndex),
+        start(Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedZone()
+        {
+            profiler.addTicks(zone, Time::getHighResolutionTicks() - start);
+        }
+
+    private:
+        ZoneProfiler& profiler;
+        const int zone;
+        const int64 start;
+        JUCE_DECLARE_NON_COPYABLE(ScopedZone)
+    };
+   #else
+    class ScopedBlock {
+    public:
+        ScopedBlock(ZoneProfiler&, int) {}
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    class ScopedZone {
+    public:
+        ScopedZone(ZoneProfiler&, int) {}
+        JUCE_DECLARE_NON_COPYABLE(ScopedZone)
+    };
+   #endif
+
+private:
+    void beginBlock(int numSamples)
+    {
+        deadline_ticks = numSamples * ticks_per_sample;
+        num_samples += numSamples;
+        block_start = Time::getHighResolutionTicks();
+    }
+
+    void addTicks(int zone, int64 ticks)
+    {
+        if (isPositiveAndBelow(zone, num_zones)) {
+            block_ticks[zone] += ticks;
+        }
+    }
+
+    void endBlock()
+    {
+        block_ticks[0] = Time::getHighResolutionTicks() - block_start;
+
+        if (deadline_ticks > 0.0) {
+            for (int zone = 0; zone < num_zones; ++zone) {
+                const float load = (float) (block_ticks[zone] / deadline_ticks);
+                ZoneStatistics& statistics = accumulated.zones[zone];
+
+                load_sums[zone] += load;
+                statistics.maximumLoad = jmax(statistics.maximumLoad, load);
+                ++statistics.histogram[getBin(load)];
+            }
+            ++num_blocks;
+        }
+
+        for (int zone = 0; zone < num_zones; ++zone) {
+            block_ticks[zone] = 0;
+        }
+
+        if (num_samples >= publish_interval) {
+            publish();
+        }
+    }
+
+    void publish()
+    {
+        Snapshot& snapshot = published.getWriteBuffer();
+        snapshot = accumulated;
+        snapshot.numZones = num_zones;
+        snapshot.numBlocks = num_blocks;
+
+        for (int zone = 0; zone < num_zones; ++zone) {
+            snapshot.zones[zone].averageLoad = num_blocks > 0 ? (float) (load_sums[zone] / num_blocks) : 0.f;
+        }
+
+        published.publish();
+        clearStatistics();
+    }
+
+    void clearStatistics()
+    {
+        std::memset(&accumulated, 0, sizeof(accumulated));
+        for (int zone = 0; zone < maximumZones; ++zone) {
+            load_sums[zone] = 0.0;
+            block_ticks[zone] = 0;
+        }
+        num_blocks = 0;
+        num_samples = 0;
+    }
+
+    /// Returns the histogram bin of a load.
+    static int getBin(float load)
+    {
+        if (! (load > 0.f)) {
+            return 0;
+        }
+        return jlimit(0, numBins - 1, (int) std::floor(2.f * std::log2(load)) + 20);
+    }
+
+    /// The names of the zones.
+    StringArray names;
+
+    /// The statistics since the last publication, and the sum of the loads of
+    /// each zone for the average.
+    Snapshot accumulated;
+    double load_sums[maximumZones];
+
+    /// The time spent in each zone during the current block.
+    int64 block_ticks[maximumZones];
+
+    /// The statistics handed from the audio thread to read().
+    TripleBuffer<Snapshot> published;
+
+    double ticks_per_sample;
+    int publish_interval;
+    int num_zones;
+    int num_blocks;
+    int num_samples;
+    double deadline_ticks;
+    int64 block_start;
+
+    JUCE_DECLARE_NON_COPYABLE(ZoneProfiler)
+};
+
+
+#endif  // ZONEPROFILER_H_INCLUDED